@@ -0,0 +1,113 @@
+#ifndef __VCD_CHANGE_INDEX_HPP__
+#define __VCD_CHANGE_INDEX_HPP__
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Include/VcdStructs.hpp"
+
+namespace vcd
+{
+   //======================================================================
+   // Глобальный журнал изменений, упорядоченный по времени
+   //======================================================================
+   /**
+    *  Для каждой различной метки времени хранит диапазон записей
+    *  (id пина, номер изменения в его временной шкале). Отвечает на
+    *  «что изменилось в ts», «что менялось в [t0, t1]» за O(log T + k)
+    *  и ищет соседнее событие для набора сигналов.
+    *
+    *  Строится после загрузки и, как и Handle, неизменяем: запросы
+    *  можно выполнять из нескольких потоков. Ссылается на временные
+    *  шкалы Handle и живёт не дольше него.
+    */
+   class ChangeIndex
+   {
+   public:
+      struct Record
+      {
+         std::uint32_t pinId = 0;  //!< IPinDescription::GetId()
+         std::uint32_t change = 0; //!< индекс в GetTimeline() пина
+      };
+
+      using Range = std::pair<const Record *, const Record *>;
+
+      /**
+       * @brief Параллельное построение по временным диапазонам.
+       * @param timelineById временные шкалы по id пина (nullptr — пропустить).
+       * @param splits       границы диапазонов (например, последние метки
+       *                     кусков загрузчика); каждый диапазон — свой поток.
+       * @throws std::length_error больше 2^32-1 пинов или изменений одного пина
+       *                     (поля Record — 32-битные).
+       */
+      static ChangeIndex
+      Build(const std::vector<const std::vector<PinValue> *> &timelineById,
+            std::vector<std::uint64_t> splits);
+
+      /**  Записи ровно в ts (пустой диапазон, если изменений нет). */
+      Range
+      At(std::uint64_t ts) const;
+
+      /**  Записи с t0 <= ts <= t1, упорядоченные по времени. */
+      Range
+      Window(std::uint64_t t0, std::uint64_t t1) const;
+
+      /**  Метка записи (для перебора результата Window()). */
+      std::uint64_t
+      TimestampOf(const Record *r) const;
+
+      /**
+       * @brief Ближайшая метка строго после / до ts, в которой изменился
+       *        хотя бы один пин из pinMask (маска по id; nullptr — любой).
+       *
+       * Без маски — O(log T). С маской — не больше kScanRecords записей
+       * журнала, затем двоичный поиск по шкале каждого пина маски:
+       * O(log T + |pinMask| + m log n) для m выбранных пинов.
+       */
+      std::optional<std::uint64_t>
+      NextEvent(std::uint64_t ts, const std::vector<std::uint8_t> *pinMask = nullptr) const;
+
+      std::optional<std::uint64_t>
+      PrevEvent(std::uint64_t ts, const std::vector<std::uint8_t> *pinMask = nullptr) const;
+
+      const std::vector<std::uint64_t> &
+      GetTimestamps() const noexcept
+      {
+         return m_times;
+      }
+
+      std::size_t
+      GetRecordCount() const noexcept
+      {
+         return m_records.size();
+      }
+
+      std::size_t
+      GetBytes() const noexcept
+      {
+         return m_times.capacity() * sizeof(std::uint64_t) +
+                m_offsets.capacity() * sizeof(std::uint64_t) +
+                m_records.capacity() * sizeof(Record) +
+                m_timelines.capacity() * sizeof(void *);
+      }
+
+      static constexpr std::uint64_t kScanRecords = 4096; //!< записей журнала до поиска по шкалам
+
+   private:
+      bool
+      Matches(std::size_t timeIdx, const std::vector<std::uint8_t> &pinMask) const;
+
+      template <typename Fn>
+      void
+      ForEachMasked(const std::vector<std::uint8_t> &pinMask, Fn &&fn) const;
+
+      std::vector<std::uint64_t> m_times;   //!< различные метки, по возрастанию
+      std::vector<std::uint64_t> m_offsets; //!< m_times.size() + 1 начал диапазонов
+      std::vector<Record> m_records;
+      std::vector<const std::vector<PinValue> *> m_timelines; //!< по id пина, из Build()
+   };
+} // namespace vcd
+
+#endif //!__VCD_CHANGE_INDEX_HPP__
@@ -0,0 +1,61 @@
+#ifndef __VCD_GEN_HPP__
+#define __VCD_GEN_HPP__
+
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace vcd
+{
+   //======================================================================
+   // Синтетические VCD для тестов и бенчмарков
+   //======================================================================
+   /**
+    *  Один и тот же seed и одни и те же параметры дают побайтно один и
+    *  тот же файл на любой платформе: свой ГПСЧ, без std::*_distribution.
+    */
+   struct GenOptions
+   {
+      std::uint64_t seed = 1;
+      std::uint64_t targetBytes = 16u << 20; //!< тело дописывается, пока файл меньше
+
+      /* иерархия: depth уровней по fanout подмодулей, сигналы — по всем модулям */
+      unsigned signals = 1000;
+      unsigned depth = 3;
+      unsigned fanout = 4;
+
+      /* доля шин и их ширины (выбор равновероятный: {8, 8, 64} — 2/3 восьмибитных) */
+      double busFraction = 0.2;
+      std::vector<unsigned> busWidths = {4, 8, 16, 32, 64};
+
+      double xzDensity = 0.01;      //!< вероятность x/z для бита нового значения
+      double changesPerStep = 0.05; //!< доля сигналов, меняющихся на одной метке
+      std::uint64_t timeStep = 10;  //!< расстояние между соседними метками
+
+      bool crlf = false;
+      unsigned dumpoffEvery = 0;  //!< блок $dumpoff каждые N меток, 0 — нет
+      unsigned dumpoffLength = 5; //!< длина блока в метках
+
+      std::string timescale = "1ps";
+   };
+
+   struct GenResult
+   {
+      std::uint64_t bytes = 0;
+      std::uint64_t changes = 0;    //!< изменений в теле, без $dumpvars
+      std::uint64_t timestamps = 0; //!< меток после #0
+      std::uint64_t maxTs = 0;
+      std::size_t dumpoffBlocks = 0;
+   };
+
+   GenResult
+   GenerateVcd(std::ostream &out, const GenOptions &opt);
+
+   /**  @throws std::system_error, если файл не удалось записать. */
+   GenResult
+   GenerateVcd(const std::filesystem::path &path, const GenOptions &opt);
+} // namespace vcd
+
+#endif //!__VCD_GEN_HPP__
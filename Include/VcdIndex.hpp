@@ -0,0 +1,124 @@
+#ifndef __VCD_INDEX_HPP__
+#define __VCD_INDEX_HPP__
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vcd
+{
+   //======================================================================
+   // Индекс тела VCD для загрузки по окну времени
+   //======================================================================
+   /**
+    *  Строится одним проходом по телу файла (без буфера на весь файл):
+    *   - точки поиска   : смещение строки "#<ts>" примерно каждые seekBytes;
+    *   - контрольные    : полный срез состояний всех сигналов примерно
+    *     точки            каждые checkpointBytes (всегда совпадают с точкой поиска).
+    *
+    *  Состояния хранятся по alias, поэтому индекс не зависит от порядка пинов
+    *  в Handle. Сохраняется рядом с VCD (<file>.vcdidx) и считается
+    *  действительным, пока у файла не изменились размер и mtime.
+    */
+   class VcdIndex
+   {
+   public:
+      struct Options
+      {
+         std::size_t checkpointBytes = 16u << 20;
+         std::size_t seekBytes = 256u << 10;
+         std::filesystem::path sidecar; //!< пусто -> SidecarPath(vcd)
+         bool persist = true;           //!< сохранять / читать sidecar
+      };
+
+      struct SeekPoint
+      {
+         std::uint64_t timestamp = 0; //!< первый "#ts" с этого смещения
+         std::uint64_t offset = 0;    //!< смещение '#' от начала файла
+      };
+
+      struct Checkpoint
+      {
+         SeekPoint at;
+         std::vector<std::string> states; //!< значения в порядке GetAliases() до at.timestamp
+         bool inDumpoff = false;
+         std::uint64_t dumpoffBegin = 0;
+      };
+
+      /**
+       * @brief Проход по телу [bodyOffset, EOF).
+       * @param aliasInit пары (alias, начальное состояние из заголовка).
+       * @throws std::system_error если файл не читается.
+       */
+      static VcdIndex
+      Build(const std::filesystem::path &vcd, std::uint64_t bodyOffset,
+            const std::vector<std::pair<std::string, std::string>> &aliasInit,
+            const Options &opt);
+
+      /**  nullopt — sidecar отсутствует, повреждён или устарел. */
+      static std::optional<VcdIndex>
+      Load(const std::filesystem::path &sidecar, const std::filesystem::path &vcd);
+
+      bool
+      Save(const std::filesystem::path &sidecar) const;
+
+      static std::filesystem::path
+      SidecarPath(const std::filesystem::path &vcd)
+      {
+         return std::filesystem::path(vcd.string() + ".vcdidx");
+      }
+
+      /**  Последняя контрольная точка с timestamp <= ts (или первая). */
+      const Checkpoint &
+      FindCheckpoint(std::uint64_t ts) const;
+
+      /**  Смещение, после которого все метки > ts (или конец файла). */
+      std::uint64_t
+      FindEndOffset(std::uint64_t ts) const;
+
+      const std::vector<std::string> &
+      GetAliases() const noexcept
+      {
+         return m_aliases;
+      }
+
+      const std::vector<SeekPoint> &
+      GetSeekPoints() const noexcept
+      {
+         return m_seek;
+      }
+
+      const std::vector<Checkpoint> &
+      GetCheckpoints() const noexcept
+      {
+         return m_checkpoints;
+      }
+
+      std::uint64_t
+      GetBodyOffset() const noexcept
+      {
+         return m_bodyOffset;
+      }
+
+      std::uint64_t
+      GetMaxTs() const noexcept
+      {
+         return m_maxTs;
+      }
+
+   private:
+      std::uint64_t m_fileSize = 0;
+      std::int64_t m_mtime = 0;
+      std::uint64_t m_bodyOffset = 0;
+      std::uint64_t m_maxTs = 0;
+
+      std::vector<std::string> m_aliases;
+      std::vector<SeekPoint> m_seek;
+      std::vector<Checkpoint> m_checkpoints;
+   };
+} // namespace vcd
+
+#endif //!__VCD_INDEX_HPP__
@@ -0,0 +1,77 @@
+#ifndef __VCD_PERF_COUNTERS_HPP__
+#define __VCD_PERF_COUNTERS_HPP__
+
+#include <cstdint>
+#include <optional>
+
+namespace vcd
+{
+   //======================================================================
+   // Счётчики процессора для профилирования фаз загрузки и запросов
+   //======================================================================
+   /**
+    *  Аппаратные значения — через perf_event_open (только user-space,
+    *  с поправкой на мультиплексирование); если ядро не даёт доступа
+    *  (perf_event_paranoid, контейнер, ВМ), они пусты. Программные
+    *  (время CPU потока, страничные сбои, переключения контекста)
+    *  доступны всегда.
+    */
+   struct CounterValues
+   {
+      std::optional<std::uint64_t> cycles;
+      std::optional<std::uint64_t> instructions;
+      std::optional<std::uint64_t> llcMisses;    //!< PERF_COUNT_HW_CACHE_MISSES
+      std::optional<std::uint64_t> branchMisses;
+
+      std::uint64_t cpuTimeNs = 0;     //!< CLOCK_THREAD_CPUTIME_ID
+      std::uint64_t pageFaults = 0;    //!< minor + major
+      std::uint64_t ctxSwitches = 0;   //!< voluntary + involuntary
+
+      double
+      Ipc() const noexcept
+      {
+         return cycles && instructions && *cycles ? static_cast<double>(*instructions) / static_cast<double>(*cycles) : 0.0;
+      }
+
+      CounterValues &
+      operator+=(const CounterValues &o) noexcept;
+   };
+
+   /**
+    *  Счётчики вызывающего потока: Start() и Stop() должны вызываться
+    *  из того же потока, что и конструктор.
+    */
+   class PerfCounters
+   {
+   public:
+      /**  @param hardware false — сразу программный режим. */
+      explicit PerfCounters(bool hardware = true);
+      ~PerfCounters();
+
+      PerfCounters(const PerfCounters &) = delete;
+      PerfCounters &operator=(const PerfCounters &) = delete;
+
+      /**  true, если открылся хотя бы счётчик тактов. */
+      bool
+      IsHardware() const noexcept
+      {
+         return m_fds[0] >= 0;
+      }
+
+      void
+      Start();
+
+      CounterValues
+      Stop();
+
+   private:
+      static constexpr int kEvents = 4; //!< cycles, instructions, LLC, branch misses
+
+      int m_fds[kEvents] = {-1, -1, -1, -1};
+      std::uint64_t m_cpuStart = 0;
+      std::uint64_t m_faultsStart = 0;
+      std::uint64_t m_switchesStart = 0;
+   };
+} // namespace vcd
+
+#endif //!__VCD_PERF_COUNTERS_HPP__
@@ -0,0 +1,92 @@
+#ifndef __VCD_REPORT_HPP__
+#define __VCD_REPORT_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Include/VcdStructs.hpp"
+
+namespace vcd
+{
+   //======================================================================
+   // Отчёт о переключениях по модулям и сигналам
+   //======================================================================
+   struct TimeWindow
+   {
+      std::uint64_t t0 = 0;
+      std::uint64_t t1 = 0;
+   };
+
+   struct SignalReport
+   {
+      std::size_t module = 0;          //!< индекс в Report::modules
+      PinDescriptionPtr pin;
+      std::vector<SignalStats> stats;  //!< по окнам
+   };
+
+   struct ModuleReport
+   {
+      std::string path;                   //!< "top.dut.core0"
+      std::size_t parent = SIZE_MAX;      //!< индекс родителя, SIZE_MAX у корня
+      std::size_t depth = 0;
+      std::size_t signalCount = 0;        //!< собственные сигналы (без параметров)
+      std::vector<std::uint64_t> toggles; //!< собственные, по окнам
+      std::vector<std::uint64_t> subtreeToggles; //!< с подмодулями, по окнам
+   };
+
+   struct ReportOptions
+   {
+      std::vector<TimeWindow> windows; //!< пусто -> одно окно [0, GetMaxTs()]
+      bool signalRows = true;          //!< false — только сводка по модулям
+      unsigned threads = 0;            //!< 0 -> hardware_concurrency()
+
+      /**
+       * Вызывается из рабочих потоков по мере готовности модулей
+       * (done, total); должен быть потокобезопасным.
+       */
+      std::function<void(std::size_t, std::size_t)> progress;
+
+      /**
+       * Готовый модуль (индекс в Report::modules) со своими строками
+       * сигналов — пустыми, если !signalRows — сразу после подсчёта, до
+       * конца BuildReport(). toggles окончательны, subtreeToggles ещё
+       * пусты. Зовётся из рабочих потоков; должен быть потокобезопасным.
+       */
+      std::function<void(std::size_t, const ModuleReport &, const std::vector<SignalReport> &)> moduleReady;
+   };
+
+   /**
+    *  Модули в порядке обхода в глубину (родитель раньше детей), сигналы
+    *  сгруппированы по модулям в том же порядке.
+    */
+   struct Report
+   {
+      std::vector<TimeWindow> windows;
+      std::vector<ModuleReport> modules;
+      std::vector<SignalReport> signals;
+      std::vector<std::uint64_t> totalToggles; //!< по окнам
+
+      std::string
+      SignalPath(const SignalReport &s) const
+      {
+         return modules[s.module].path + '.' + std::string(s.pin->GetName());
+      }
+   };
+
+   /**
+    * @brief Считает статистику переключений всех модулей.
+    *
+    * Дерево разворачивается в массив один раз (пути строятся от родителя),
+    * затем непрерывные участки массива — поддеревья — разбираются пулом
+    * потоков. Окна считаются через Handle::RangeStats() по списку окон:
+    * с SetBuildStatsIndex(true) — O(log n) на сигнал и окно, без него —
+    * проход по шкале сигнала в рабочем потоке, без кеша и общей блокировки.
+    * Handle должен быть загружен; он только читается.
+    */
+   Report
+   BuildReport(const Handle &handle, const ReportOptions &opt = {});
+} // namespace vcd
+
+#endif //!__VCD_REPORT_HPP__
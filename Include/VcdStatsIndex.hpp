@@ -0,0 +1,76 @@
+#ifndef __VCD_STATS_INDEX_HPP__
+#define __VCD_STATS_INDEX_HPP__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Include/VcdStructs.hpp"
+
+namespace vcd
+{
+   //======================================================================
+   // Префиксные суммы для статистики сигнала в окне времени
+   //======================================================================
+   /**
+    *  Для каждого изменения i сигнала хранит накопленные с нуля переключения
+    *  (включая i) и время в состояниях до ts_i. Агрегат по [t0, t1] — разность
+    *  двух префиксов, найденных двоичным поиском по шкале сигнала.
+    *
+    *  Ссылается на временные шкалы Handle и живёт не дольше него.
+    */
+   class StatsIndex
+   {
+   public:
+      struct Source
+      {
+         const std::vector<PinValue> *timeline = nullptr; //!< nullptr — сигнал без изменений
+         std::string initState;
+      };
+
+      /**  Сигналы независимы и делятся между потоками (0 -> по числу ядер). */
+      static StatsIndex
+      Build(const std::vector<Source> &byId, unsigned threads = 0);
+
+      /**  id — индекс в byId (IPinDescription::GetId()). */
+      SignalStats
+      Query(std::uint32_t id, std::uint64_t t0, std::uint64_t t1) const;
+
+      std::size_t
+      GetBytes() const noexcept;
+
+   private:
+      struct Prefix
+      {
+         std::uint64_t timeHigh = 0; //!< в [0, ts_i)
+         std::uint64_t timeLow = 0;
+         std::uint64_t timeX = 0;    //!< Z = ts_i - остальные
+         std::uint64_t toggles = 0;  //!< по изменение i включительно
+         std::uint64_t rises = 0;
+         std::uint64_t falls = 0;
+      };
+
+      struct Series
+      {
+         const std::vector<PinValue> *timeline = nullptr;
+         std::vector<Prefix> prefix;
+         std::uint8_t initClass = 0;
+      };
+
+      struct Cumulative
+      {
+         std::uint64_t time[4] = {}; //!< по классам состояния
+         std::uint64_t toggles = 0;
+         std::uint64_t rises = 0;
+         std::uint64_t falls = 0;
+      };
+
+      /**  Накопленное на момент t; m — число изменений, учитываемых до t. */
+      static Cumulative
+      At(const Series &s, std::uint64_t t, std::size_t m);
+
+      std::vector<Series> m_series;
+   };
+} // namespace vcd
+
+#endif //!__VCD_STATS_INDEX_HPP__
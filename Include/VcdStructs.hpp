@@ -3,10 +3,14 @@
 
 #include <filesystem>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <queue>
+#include <regex>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -15,6 +19,9 @@
 #include <vector>
 #include <iostream>
 
+#include "Include/VcdIndex.hpp"
+#include "Include/VcdPerfCounters.hpp"
+
 namespace vcd
 {
    class Module;
@@ -38,6 +45,8 @@ namespace vcd
    // 2.  Вперёд-объявления
    //======================================================================
    class Handle;    // главный «контейнер» VCD-данных
+   class ChangeIndex; // Include/VcdChangeIndex.hpp
+   class StatsIndex;  // Include/VcdStatsIndex.hpp
    class VcdReader; // парсер (header + body 1/МП)
    class IPinDescription;
    class SimplePinDescription;
@@ -50,7 +59,235 @@ namespace vcd
    struct PinValue
    {
       std::uint64_t timestamp{}; //!< момент изменения
-      std::string_view value;    //!< view в mmap-буфере (для многобитовых)
+      std::string_view value;    //!< view в ValuePool (или в буфере файла до компактизации)
+   };
+
+   //======================================================================
+   // 3a. Пул значений: владеет строками шин после разбора тела
+   //======================================================================
+   /**
+    *  Арена, в которую при компактизации копируются многобитовые значения,
+    *  чтобы view в PinValue перестали ссылаться на сырой буфер файла.
+    *  Однобитовые состояния в арену не попадают: их view указывает на
+    *  статическую таблицу символов (см. StateView).
+    */
+   class ValuePool
+   {
+   public:
+      ValuePool() = default;
+      ValuePool(const ValuePool &) = delete;
+      ValuePool &operator=(const ValuePool &) = delete;
+      ValuePool(ValuePool &&) noexcept = default;
+      ValuePool &operator=(ValuePool &&) noexcept = default;
+
+      /**  Копирует строку в арену; view остаётся валидным всё время жизни пула. */
+      std::string_view
+      Append(std::string_view v);
+
+      /**  Занятая арена в байтах (с учётом хвостов блоков). */
+      std::size_t
+      GetBytes() const noexcept
+      {
+         return m_bytes;
+      }
+
+      /**  View на один символ из статической таблицы: '0','1','x','z', … */
+      static std::string_view
+      StateView(char c) noexcept;
+
+   private:
+      static constexpr std::size_t kBlockSize = 1u << 20;
+
+      std::vector<std::unique_ptr<char[]>> m_blocks;
+      std::vector<std::unique_ptr<char[]>> m_large; //!< значения длиннее четверти блока
+      std::size_t m_used = kBlockSize;              //!< заполненность последнего блока
+      std::size_t m_bytes = 0;
+   };
+
+   //======================================================================
+   // 3b. Фильтр сигналов по иерархическим путям
+   //======================================================================
+   /**
+    *  Набор шаблонов include/exclude, которые сравниваются с полным путём
+    *  сигнала вида "tb.dut.core0.clk". Пустой include-список пропускает всё.
+    *
+    *  Glob: '*' — любая подстрока (в том числе с точками), '?' — один символ.
+    */
+   class SignalFilter
+   {
+   public:
+      enum class Syntax : std::uint8_t
+      {
+         glob = 1,
+         regex
+      };
+
+      /**  @throws std::regex_error при некорректном регулярном выражении */
+      SignalFilter &
+      Include(std::string_view pattern, Syntax syntax = Syntax::glob);
+
+      /**  @throws std::regex_error при некорректном регулярном выражении */
+      SignalFilter &
+      Exclude(std::string_view pattern, Syntax syntax = Syntax::glob);
+
+      bool
+      IsEmpty() const noexcept
+      {
+         return m_include.empty() && m_exclude.empty();
+      }
+
+      bool
+      Matches(const std::string &path) const;
+
+   private:
+      static std::regex
+      Compile(std::string_view pattern, Syntax syntax);
+
+      std::vector<std::regex> m_include;
+      std::vector<std::regex> m_exclude;
+   };
+
+   //======================================================================
+   // 3c. Статистика сигнала в окне времени (Handle::RangeStats)
+   //======================================================================
+   /**
+    *  Время считается по полуинтервалам [ts_i, ts_{i+1}) в состоянии
+    *  изменения i. Для шин: есть x — X, иначе есть z — Z, все '0' — low,
+    *  иначе high. toggles — изменения значения в окне, rises/falls —
+    *  переходы low->high / high->low.
+    */
+   struct SignalStats
+   {
+      std::uint64_t duration = 0; //!< t1 - t0
+      std::uint64_t toggles = 0;
+      std::uint64_t rises = 0;
+      std::uint64_t falls = 0;
+      std::uint64_t timeHigh = 0;
+      std::uint64_t timeLow = 0;
+      std::uint64_t timeX = 0;
+      std::uint64_t timeZ = 0;
+
+      double
+      DutyCycle() const noexcept
+      {
+         return duration ? static_cast<double>(timeHigh) / static_cast<double>(duration) : 0.0;
+      }
+   };
+
+   //======================================================================
+   // 3d. Расход памяти загруженного файла (Handle::MemoryUsage)
+   //======================================================================
+   /**
+    *  Байты по ёмкости контейнеров, а не по size(). Иерархия — оценка:
+    *  объекты модулей и пинов, строки вне SSO, управляющие блоки
+    *  shared_ptr, узлы и корзины alias-таблицы.
+    */
+   struct MemoryBreakdown
+   {
+      struct Signal
+      {
+         std::shared_ptr<IPinDescription> pin;
+         std::size_t changes = 0;
+         std::size_t bytes = 0; //!< вектор PinValue (строки шин — в valuePools)
+      };
+
+      std::size_t rawBuffer = 0;       //!< сырой текст файла (до CompactValues)
+      std::size_t simpleTimelines = 0; //!< PinValue 1-битовых сигналов
+      std::size_t busTimelines = 0;    //!< PinValue шин
+      std::size_t valuePools = 0;      //!< строки шин в ValuePool
+      std::size_t hierarchy = 0;
+      std::size_t changeIndex = 0;
+      std::size_t statsIndex = 0;
+
+      std::vector<Signal> largest; //!< по убыванию bytes
+
+      std::size_t
+      Total() const noexcept
+      {
+         return rawBuffer + simpleTimelines + busTimelines + valuePools + hierarchy + changeIndex + statsIndex;
+      }
+   };
+
+   /**  Многострочная таблица для логов тестов и бенчмарков. */
+   std::ostream &
+   operator<<(std::ostream &os, const MemoryBreakdown &m);
+
+   //======================================================================
+   // 3e. Хронометраж загрузки (Handle::GetLoadStats)
+   //======================================================================
+   /**
+    *  Время фаз в миллисекундах; фаз, которых нет у загрузчика, — 0.
+    *  У конвейерной загрузки чтение идёт одновременно с разбором, поэтому
+    *  readMs + parseMs может превышать bodyMs.
+    *
+    *  С Handle::SetCollectCounters(true) каждая фаза дополнительно
+    *  снабжается счётчиками процессора — по записи на каждый поток фазы.
+    */
+   struct LoadStats
+   {
+      struct PhaseCounters
+      {
+         std::string_view phase; //!< "init", "loadHdr", "read", "parse", "merge", "sort", "compact", "index"
+         unsigned thread = 0;    //!< номер потока внутри фазы
+         CounterValues values;
+      };
+
+      std::string_view loader; //!< "serial", "parallel", "pipelined", "parts", "window"
+      std::chrono::steady_clock::time_point openedAt; //!< начало Init()
+
+      double headerScanMs = 0.0; //!< Init(): поиск начала тела
+      double tokenizeMs = 0.0;   //!< Init(): токены заголовка
+      double loadHdrMs = 0.0;    //!< LoadHdr()
+      double readMs = 0.0;       //!< чтение тела с диска
+      double parseMs = 0.0;      //!< разбор тела, по стене
+      double mergeMs = 0.0;      //!< слияние результатов потоков
+      double sortMs = 0.0;       //!< SortAndRemoveDuplicates()
+      double compactMs = 0.0;    //!< перенос значений в ValuePool
+      double indexMs = 0.0;      //!< ChangeIndex / StatsIndex
+      double bodyMs = 0.0;       //!< весь LoadSignals*()
+      double totalMs = 0.0;      //!< от начала Init() до конца загрузки тела
+      double firstFrameMs = 0.0; //!< от начала Init() до первого кадра (заполняет GUI)
+
+      std::vector<double> threadParseMs; //!< чистое время разбора каждого потока
+      unsigned threads = 0;
+      std::uint64_t bytes = 0;   //!< размер файла (всех частей)
+      std::uint64_t changes = 0; //!< сохранённые изменения всех сигналов
+
+      std::vector<PhaseCounters> counters; //!< пусто без SetCollectCounters(true)
+
+      /**  Сумма счётчиков всех потоков фазы. */
+      CounterValues
+      PhaseTotal(std::string_view phase) const
+      {
+         CounterValues sum;
+         for (const PhaseCounters &c : counters)
+         {
+            if (c.phase == phase)
+               sum += c.values;
+         }
+         return sum;
+      }
+
+      double
+      BytesPerSecond() const noexcept
+      {
+         return totalMs > 0.0 ? static_cast<double>(bytes) / (totalMs / 1000.0) : 0.0;
+      }
+
+      /**  Максимум / среднее threadParseMs: 1 — потоки загружены поровну. */
+      double
+      Imbalance() const noexcept
+      {
+         if (threadParseMs.empty())
+            return 1.0;
+         double sum = 0.0, max = 0.0;
+         for (double ms : threadParseMs)
+         {
+            sum += ms;
+            max = std::max(max, ms);
+         }
+         return sum > 0.0 ? max * static_cast<double>(threadParseMs.size()) / sum : 1.0;
+      }
    };
 
    //======================================================================
@@ -65,6 +302,7 @@ namespace vcd
       std::string m_alias;    //!< символьное имя в VCD ($var … alias)
       std::string m_name;     //!< human-readable name (обычно instance/pin)
       std::string m_initState;
+      std::uint32_t m_id{0}; //!< плотный номер пина в Handle (для битовых масок)
 
       std::weak_ptr<Module> m_parent;
 
@@ -107,6 +345,12 @@ namespace vcd
          return m_name;
       }
 
+      std::uint32_t
+      GetId() const noexcept
+      {
+         return m_id;
+      }
+
       void
       SetInitState(std::string_view state)
       {
@@ -227,22 +471,22 @@ namespace vcd
       }
 
       // Для 1-битового пина возврат bus-строки бессмысленен; возвращаем строку из одного символа.
+      // View указывает в статическую таблицу и не зависит от потока и следующих вызовов.
       std::string_view
       GetValueBus(std::uint64_t ts) const override
       {
-         static thread_local std::string tmp; // делаем временную строку, чтобы вернуть std::string_view
-         char c = GetValueChar(ts);
-         tmp.assign(1, c);
-         return tmp;
+         return ValuePool::StateView(GetValueChar(ts));
       }
 
       void SortAndRemoveDuplicates()
       {
-         std::sort(m_values.begin(), m_values.end(),
-                   [](PinValue const &a, PinValue const &b)
-                   {
-                      return a.timestamp < b.timestamp;
-                   });
+         auto byTs = [](PinValue const &a, PinValue const &b)
+         {
+            return a.timestamp < b.timestamp;
+         };
+         // куски сливаются по порядку, поэтому обычно уже отсортировано
+         if (!std::is_sorted(m_values.begin(), m_values.end(), byTs))
+            std::sort(m_values.begin(), m_values.end(), byTs);
 
          auto uniqueEnd = std::unique(m_values.begin(), m_values.end(),
                                       [](PinValue const &a, PinValue const &b)
@@ -286,20 +530,21 @@ namespace vcd
          return m_values;
       }
 
+      /**  Ленивые пины отдельных битов; первый вызов из любого потока строит
+       *   их ровно один раз (call_once), остальные ждут и видят готовый вектор. */
       const std::vector<std::shared_ptr<SimplePinDescription>> &
-      GetSubPins() const noexcept
+      GetSubPins() const
       {
-
-         if (m_subpins.empty())
-         {
+         std::call_once(m_subpinsOnce, [this]
+                        {
             auto self = shared_from_this();
             auto [msb, lsb] = GetBitDepth();
-            std::size_t nBits = msb - lsb + 1;
+            std::size_t nBits = (msb > lsb ? msb - lsb : lsb - msb) + 1;
 
             m_subpins.reserve(nBits);
             for (std::size_t i = 0; i < nBits; ++i)
-               m_subpins.emplace_back(std::make_shared<BitProxy>(self));
-         }
+               m_subpins.emplace_back(std::make_shared<BitProxy>(self, i));
+            m_subpinsReady.store(true, std::memory_order_release); });
          return m_subpins;
       }
 
@@ -366,11 +611,13 @@ namespace vcd
 
       void SortAndRemoveDuplicates()
       {
-         std::sort(m_values.begin(), m_values.end(),
-                   [](PinValue const &a, PinValue const &b)
-                   {
-                      return a.timestamp < b.timestamp;
-                   });
+         auto byTs = [](PinValue const &a, PinValue const &b)
+         {
+            return a.timestamp < b.timestamp;
+         };
+         // куски сливаются по порядку, поэтому обычно уже отсортировано
+         if (!std::is_sorted(m_values.begin(), m_values.end(), byTs))
+            std::sort(m_values.begin(), m_values.end(), byTs);
 
          auto uniqueEnd = std::unique(m_values.begin(), m_values.end(),
                                       [](PinValue const &a, PinValue const &b)
@@ -385,10 +632,11 @@ namespace vcd
       struct BitProxy : public SimplePinDescription
       {
          std::shared_ptr<const BusPinDescription> parent;
+         std::size_t bit = 0; //!< индекс в GetSubPins() = позиция в строке значения
 
-         BitProxy(std::shared_ptr<const BusPinDescription> p)
+         BitProxy(std::shared_ptr<const BusPinDescription> p, std::size_t b)
              : SimplePinDescription(p->m_pinType, "", ""),
-               parent(std::move(p)) {}
+               parent(std::move(p)), bit(b) {}
 
          std::string
          GetInitState() const noexcept override
@@ -396,11 +644,11 @@ namespace vcd
             return parent->GetInitState();
          }
 
+         /**  Свой бит; аргумент bit игнорируется. */
          char GetValueChar(uint64_t ts,
-                           std::size_t bit) const override
+                           std::size_t /*bit*/ = 0) const override
          {
-            // std::cout << "ts:" << ts << "bit" << bit << std::endl;
-            return parent->GetValueChar(ts, bit);
+            return parent->GetValueChar(ts, this->bit);
          }
 
          const std::vector<PinValue> &GetTimeline() const noexcept override
@@ -413,6 +661,8 @@ namespace vcd
       std::pair<std::size_t, std::size_t> m_bitDepth;                       //!< {msb, lsb}
       std::vector<PinValue> m_values;                                       //!< строки «1010…» (ts + view)
       mutable std::vector<std::shared_ptr<SimplePinDescription>> m_subpins; //!< опционально, для битовых обращений
+      mutable std::once_flag m_subpinsOnce;                                 //!< публикация m_subpins между потоками
+      mutable std::atomic<bool> m_subpinsReady{false};                      //!< m_subpins достроен; читать без call_once
 
       // конструктор-делегат: PinType::wire/PinType::reg, SignalType::bus
 
@@ -472,6 +722,19 @@ namespace vcd
    //======================================================================
    // 9.  Главный объект VCD-файла
    //======================================================================
+   /**
+    *  Потокобезопасность.
+    *
+    *  Загрузка (Init, LoadHdr, Set*, LoadSignals*, LoadWindow) выполняется
+    *  одним потоком. После её завершения Handle неизменяем: все const-методы
+    *  Handle, Module и пинов (включая GetSubPins) можно вызывать из любого
+    *  числа потоков одновременно без внешней синхронизации, при условии что
+    *  Handle передан другим потокам после загрузки (shared_ptr, сигнал Qt,
+    *  join — любое happens-before).
+    *
+    *  Все string_view, возвращаемые запросами, указывают в ValuePool или
+    *  статическую таблицу состояний и валидны, пока жив Handle.
+    */
    class Handle
    {
       //-------------------------------------------- друзья
@@ -479,7 +742,7 @@ namespace vcd
 
    public:
       //-------------------------------------------- ctor/dtor
-      Handle() = default;
+      Handle(); //!< в .cpp: члены-индексы — неполные типы
 
       ~Handle(); //!< unmap + close
       Handle(const Handle &) = delete;
@@ -499,6 +762,187 @@ namespace vcd
       void
       LoadSignalsParallel();
 
+      /**
+       * @brief Загрузка тела блоками с упреждающим чтением.
+       *
+       * Чтение (io_uring или пул pread) перекрывается с разбором, буфер
+       * всего файла не создаётся. Результат совпадает с LoadSignalsParallel().
+       */
+      void
+      LoadSignalsPipelined();
+
+      /**
+       * @brief Загружает только изменения в окне [t0, t1].
+       *
+       * Индекс тела (VcdIndex) берётся из sidecar-файла или строится и
+       * сохраняется. Чтение начинается с ближайшей контрольной точки до t0,
+       * её состояния становятся значениями всех сигналов в момент t0;
+       * память пропорциональна окну, а не файлу.
+       */
+      void
+      LoadWindow(std::uint64_t t0, std::uint64_t t1, const VcdIndex::Options &opt = {});
+
+      /**
+       * @brief Склеивает тело из частей одного прогона (run.vcd, run_1.vcd, …).
+       *
+       * Вызывается вместо LoadSignals*() после Init(parts.front()) и LoadHdr().
+       * Части разбираются параллельно, временные шкалы сшиваются по времени,
+       * интервалы $dumpoff объединяются. Значения из $dumpall в начале части,
+       * совпадающие с уже известными, не дублируются.
+       *
+       * @throws std::runtime_error если заголовок части не совпадает с первым.
+       */
+      void
+      LoadSignalsFromParts(const std::vector<std::filesystem::path> &parts);
+
+      /**  Натуральный порядок имён: run.vcd, run_1.vcd, run_2.vcd, run_10.vcd. */
+      static void
+      SortPartsNaturally(std::vector<std::filesystem::path> &parts);
+
+      /**
+       * @brief Точное резервирование временных шкал в LoadSignals / LoadSignalsParallel.
+       *
+       * Дополнительный проход считает изменения каждого пина в каждом куске,
+       * после чего у сигнала одна аллокация нужного размера и куски пишут
+       * сразу по своим смещениям: нет перевыделений и копии при слиянии.
+       */
+      void
+      SetExactReservation(bool exact) noexcept
+      {
+         m_exactReservation = exact;
+      }
+
+      /**
+       * @brief Строить глобальный журнал изменений (ChangeIndex) после любой
+       *        LoadSignals* и LoadWindow.
+       *
+       * Строится параллельно по временным диапазонам (у LoadSignalsParallel —
+       * по кускам загрузчика, у остальных — равными долями [0, GetMaxTs()]),
+       * память — 8 байт на изменение плюс 16 байт на различную метку.
+       * Больше 2^32-1 изменений одного сигнала — std::length_error из загрузки.
+       */
+      void
+      SetBuildChangeIndex(bool build) noexcept
+      {
+         m_buildChangeIndex = build;
+      }
+
+      /**  nullptr, если журнал не строился. */
+      const ChangeIndex *
+      GetChangeIndex() const noexcept
+      {
+         return m_changeIndex.get();
+      }
+
+      /**
+       * @brief Строить префиксные суммы для RangeStats() после любой LoadSignals*.
+       *
+       * По каждому сигналу накопленные переключения и время в состояниях
+       * high/low/x на момент каждого изменения (48 байт на изменение).
+       */
+      void
+      SetBuildStatsIndex(bool build) noexcept
+      {
+         m_buildStatsIndex = build;
+      }
+
+      /**
+       * @brief Снимать счётчики процессора (VcdPerfCounters.hpp) по фазам
+       *        и потокам загрузки в LoadStats::counters.
+       *
+       * Действует на LoadHdr() и все LoadSignals*(); включать до LoadHdr().
+       * Без доступа к perf_event_open остаются только программные счётчики.
+       */
+      void
+      SetCollectCounters(bool collect) noexcept
+      {
+         m_collectCounters = collect;
+      }
+
+      /**  nullptr, если индекс статистики не строился. */
+      const StatsIndex *
+      GetStatsIndex() const noexcept
+      {
+         return m_statsIndex.get();
+      }
+
+      /**
+       * @brief Статистика сигнала в окне [t0, t1].
+       *
+       * С индексом — два двоичных поиска. Без него (и для битов из GetSubPins())
+       * префиксы пина строятся первым запросом за проход по шкале и
+       * переиспользуются до следующей загрузки. Бит шины считается по своему
+       * символу, а не по всей строке значения.
+       * Параметры и отфильтрованные пины всё окно находятся в начальном состоянии.
+       */
+      SignalStats
+      RangeStats(const IPinDescription &pin, std::uint64_t t0, std::uint64_t t1) const;
+
+      /**  То же по alias; пустая статистика, если alias не найден. */
+      SignalStats
+      RangeStats(std::string_view alias, std::uint64_t t0, std::uint64_t t1) const;
+
+      /**
+       * @brief Несколько окон [t0, t1] одного сигнала.
+       *
+       * Без индекса префиксы строятся один раз на вызов и не кешируются:
+       * для обходов всех сигналов (BuildReport), где кеш лишь копил бы
+       * память. Можно вызывать из многих потоков без общей блокировки.
+       */
+      std::vector<SignalStats>
+      RangeStats(const IPinDescription &pin, const std::vector<std::pair<std::uint64_t, std::uint64_t>> &windows) const;
+
+      /**
+       * @brief Верхняя граница числа рабочих потоков загрузки и индексов
+       *        (0 — по числу ядер). Для нескольких Handle в одном процессе.
+       */
+      void
+      SetMaxThreads(unsigned n) noexcept
+      {
+         m_maxThreads = n;
+      }
+
+      /**  Размер блока чтения для LoadSignalsPipelined(); 0 -> 8 МиБ. */
+      void
+      SetReadBlockSize(std::size_t bytes) noexcept
+      {
+         m_chunkSize = bytes;
+      }
+
+      /**  false — не пытаться открыть io_uring, сразу пул pread. */
+      void
+      SetUseIoUring(bool use) noexcept
+      {
+         m_useIoUring = use;
+      }
+
+      /**
+       * @brief Ограничивает набор сигналов, изменения которых сохраняются.
+       *
+       * Задаётся до LoadSignals*(). Заголовок разбирается полностью, все пины
+       * остаются в дереве модулей, но у отфильтрованных пустая временная шкала.
+       * Пин с общим alias сохраняется, если подходит хотя бы один из его путей.
+       */
+      void
+      SetSignalFilter(SignalFilter filter)
+      {
+         m_filter = std::move(filter);
+      }
+
+      /**  false — изменения пина были отброшены фильтром. */
+      bool
+      IsPinLoaded(const IPinDescription &pin) const noexcept
+      {
+         return m_keep.empty() || m_keep[pin.GetId()];
+      }
+
+      /**  Механизм чтения, выбранный последней LoadSignalsPipelined(). */
+      std::string_view
+      GetReadBackend() const noexcept
+      {
+         return m_readBackend;
+      }
+
       //-------------------------------------------- info
       std::string_view
       GetDate() const noexcept
@@ -550,6 +994,13 @@ namespace vcd
          return it == m_alias2pin.end() ? nullptr : it->second;
       }
 
+      /**  Пин по IPinDescription::GetId() (ChangeIndex::Record::pinId). */
+      PinDescriptionPtr
+      GetPinById(std::uint32_t id) const
+      {
+         return id < m_pinById.size() ? m_pinById[id] : nullptr;
+      }
+
       //-------------------------------------------- value getters (proxy)
       char
       GetValueChar(std::uint64_t ts, std::string_view alias, std::size_t bit = 0) const
@@ -575,6 +1026,43 @@ namespace vcd
          return m_dumpoffIntervals;
       }
 
+      //-------------------------------------------- память
+      struct RssInfo
+      {
+         std::size_t peakBytes = 0;   //!< VmHWM процесса к концу загрузки
+         std::size_t steadyBytes = 0; //!< VmRSS после освобождения буфера файла
+      };
+
+      /**  RSS, снятый в конце загрузки тела (любой из LoadSignals*). */
+      RssInfo
+      GetRssInfo() const noexcept
+      {
+         return m_rss;
+      }
+
+      /**  Время фаз последних Init() / LoadHdr() / LoadSignals*(). */
+      const LoadStats &
+      GetLoadStats() const noexcept
+      {
+         return m_loadStats;
+      }
+
+      /**  true, пока сырой текст файла держится в памяти. */
+      bool
+      HasRawData() const noexcept
+      {
+         return !m_data.empty();
+      }
+
+      /**
+       * @brief Разбивка занятой Handle памяти по категориям.
+       * @param topN сколько самых тяжёлых сигналов перечислить в largest.
+       *
+       * Подпины учитываются в иерархии, если их GetSubPins() уже достроил.
+       */
+      MemoryBreakdown
+      MemoryUsage(std::size_t topN = 10) const;
+
    private:
       std::queue<std::string>
       Tokenize(std::string_view fileData);
@@ -609,6 +1097,37 @@ namespace vcd
       void
       FillInitStates(const std::vector<std::pair<std::string, std::string>> &dumpVars);
 
+      void
+      ReadRawData();
+
+      void
+      AssignPinIds();
+
+      void
+      BuildKeepMask();
+
+      static std::vector<PinValue> *
+      GetMutableTimeline(IPinDescription &pin) noexcept;
+
+      /** viewsOutsideData — в шкалах есть view не в m_data (состояния контрольной
+       *  точки LoadWindow): переносить в пулы, даже если m_data пуст. */
+      void
+      CompactValues(bool viewsOutsideData = false);
+
+      void
+      BuildIndexes(std::vector<std::uint64_t> splits);
+
+      /**  Префиксы статистики одного пина; bitTimeline — хранилище шкалы бита для BitProxy. */
+      StatsIndex
+      BuildPinStats(const IPinDescription &pin, std::vector<PinValue> &bitTimeline) const;
+
+      unsigned
+      GetThreadBudget() const noexcept;
+
+      void
+      FinishLoadStats(std::string_view loader, unsigned threads,
+                      std::chrono::steady_clock::time_point bodyStart);
+
    private:
       void LinkParent(std::shared_ptr<Module> parent, const std::vector<std::shared_ptr<Module>> &childs);
       //-------------------------------------------- метаданные
@@ -620,6 +1139,7 @@ namespace vcd
       std::shared_ptr<Module> m_root;
       std::vector<PinDescriptionPtr> m_pins;
       std::unordered_map<std::string_view, PinDescriptionPtr> m_alias2pin;
+      std::vector<PinDescriptionPtr> m_pinById; //!< по m_id, заполняется в AssignPinIds()
 
       std::vector<std::pair<uint64_t, uint64_t>> m_dumpoffIntervals;
 
@@ -631,7 +1151,27 @@ namespace vcd
       std::queue<std::string> m_tokens;
       std::size_t m_tsOffset{0};
 
-      std::size_t m_chunkSize = 0; //!< 0 -> mmap всего файла, иначе разбивка на куски по m_chunkSize.
+      std::size_t m_chunkSize = 0; //!< размер блока LoadSignalsPipelined(), 0 -> по умолчанию
+      unsigned m_maxThreads = 0;   //!< 0 -> hardware_concurrency()
+      bool m_useIoUring = true;
+      bool m_exactReservation = false;
+      std::string_view m_readBackend;
+      bool m_bodyLoaded = false;
+
+      SignalFilter m_filter;
+      std::vector<std::uint8_t> m_keep; //!< по m_id; пусто -> сохраняются все
+
+      bool m_buildChangeIndex = false;
+      std::unique_ptr<ChangeIndex> m_changeIndex;
+      bool m_buildStatsIndex = false;
+      std::unique_ptr<StatsIndex> m_statsIndex;
+      struct RangeStatsCache;
+      std::unique_ptr<RangeStatsCache> m_rangeStatsCache; //!< префиксы RangeStats() вне m_statsIndex
+
+      std::vector<ValuePool> m_pools; //!< владельцы строк шин после CompactValues()
+      RssInfo m_rss;
+      LoadStats m_loadStats;
+      bool m_collectCounters = false;
    };
 
 } // namespace vcd
@@ -0,0 +1,85 @@
+#ifndef __VCD_TRACE_HPP__
+#define __VCD_TRACE_HPP__
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace vcd
+{
+   //======================================================================
+   // Маркеры трассировки в формате Chrome trace events
+   //======================================================================
+   /**
+    *  VCD_TRACE_SCOPE("имя") отмечает интервал от точки объявления до
+    *  конца блока; каждый поток пишет в свой буфер и в трассе выглядит
+    *  отдельной дорожкой. Маркеры компилируются только с опцией CMake
+    *  VCD_ENABLE_TRACE, иначе макросы пусты.
+    *
+    *  Результат — JSON для chrome://tracing и ui.perfetto.dev.
+    *  Имена должны быть строковыми литералами: хранится только указатель.
+    */
+   namespace trace
+   {
+      /**  true, если библиотека собрана с VCD_ENABLE_TRACE. */
+      bool
+      IsCompiledIn() noexcept;
+
+      /**  Имя дорожки текущего потока (метаданные thread_name). */
+      void
+      SetThreadName(std::string_view name);
+
+      /**  Завершённый интервал [begin, end) в наносекундах steady_clock. */
+      void
+      Record(const char *name, std::uint64_t beginNs, std::uint64_t endNs);
+
+      std::uint64_t
+      NowNs() noexcept;
+
+      /**  Сбрасывает накопленные события всех потоков. */
+      void
+      Clear();
+
+      /**
+       * @brief Пишет все накопленные события в JSON-файл.
+       * @return число записанных интервалов.
+       * @throws std::system_error, если файл не удалось записать.
+       */
+      std::size_t
+      WriteJson(const std::filesystem::path &path);
+
+      class Scope
+      {
+      public:
+         explicit Scope(const char *name) noexcept
+             : m_name(name), m_begin(NowNs())
+         {
+         }
+
+         ~Scope()
+         {
+            Record(m_name, m_begin, NowNs());
+         }
+
+         Scope(const Scope &) = delete;
+         Scope &operator=(const Scope &) = delete;
+
+      private:
+         const char *m_name;
+         std::uint64_t m_begin;
+      };
+   } // namespace trace
+} // namespace vcd
+
+#define VCD_TRACE_CONCAT_(a, b) a##b
+#define VCD_TRACE_CONCAT(a, b) VCD_TRACE_CONCAT_(a, b)
+
+#ifdef VCD_ENABLE_TRACE
+#define VCD_TRACE_SCOPE(name) ::vcd::trace::Scope VCD_TRACE_CONCAT(vcdTraceScope_, __LINE__)(name)
+#define VCD_TRACE_THREAD(name) ::vcd::trace::SetThreadName(name)
+#else
+#define VCD_TRACE_SCOPE(name) ((void)0)
+#define VCD_TRACE_THREAD(name) ((void)0)
+#endif
+
+#endif //!__VCD_TRACE_HPP__
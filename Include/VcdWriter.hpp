@@ -0,0 +1,57 @@
+#ifndef __VCD_WRITER_HPP__
+#define __VCD_WRITER_HPP__
+
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "Include/VcdStructs.hpp"
+
+namespace vcd
+{
+   //======================================================================
+   // Запись подмножества сигналов и окна времени в новый VCD
+   //======================================================================
+   struct WriteOptions
+   {
+      std::uint64_t t0 = 0;
+      std::uint64_t t1 = std::numeric_limits<std::uint64_t>::max(); //!< обрезается до GetMaxTs()
+
+      /**
+       * Выбор сигналов: пины из signals плюс все пины поддеревьев scopes.
+       * Оба пусты — весь файл. Модули без выбранных пинов в заголовок
+       * не попадают.
+       */
+      std::vector<std::shared_ptr<Module>> scopes;
+      std::vector<PinDescriptionPtr> signals;
+
+      std::size_t bufferBytes = 4u << 20; //!< размер одного write()
+   };
+
+   struct WriteResult
+   {
+      std::size_t signals = 0;   //!< различных alias в выходном файле
+      std::size_t changes = 0;   //!< записанных изменений после $dumpvars
+      std::uint64_t bytes = 0;
+   };
+
+   /**
+    * @brief Пишет VCD: заголовок выбранного поддерева, $dumpvars со
+    *        значениями в t0 и изменения из (t0, t1].
+    *
+    * $dumpvars всегда стоит под #0, и после чтения файла значения в t0
+    * становятся начальными состояниями: до t0 сигналы держат их же.
+    *
+    * Временные шкалы сливаются k-путевым слиянием по куче, текст копится
+    * в буфере и сбрасывается крупными write(). Интервалы $dumpoff внутри
+    * окна сохраняются. Handle только читается.
+    *
+    * @throws std::system_error при ошибке создания или записи файла.
+    */
+   WriteResult
+   WriteVcd(const Handle &handle, const std::filesystem::path &out, const WriteOptions &opt = {});
+} // namespace vcd
+
+#endif //!__VCD_WRITER_HPP__
@@ -0,0 +1,346 @@
+#include "Include/VcdGen.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace vcd
+{
+   namespace
+   {
+      /* SplitMix64: детерминирован и одинаков на всех стандартных библиотеках */
+      class Rng
+      {
+      public:
+         explicit Rng(std::uint64_t seed) : m_state(seed) {}
+
+         std::uint64_t
+         Next() noexcept
+         {
+            std::uint64_t z = (m_state += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+         }
+
+         std::uint64_t
+         Below(std::uint64_t n) noexcept
+         {
+            return n ? Next() % n : 0;
+         }
+
+         bool
+         Chance(double p) noexcept
+         {
+            return static_cast<double>(Next() >> 11) * 0x1.0p-53 < p;
+         }
+
+      private:
+         std::uint64_t m_state;
+      };
+
+      struct Signal
+      {
+         std::string alias;
+         unsigned width = 1;
+         std::string value; //!< текущее значение, для $dumpon
+         std::uint64_t changedAt = UINT64_MAX;
+      };
+
+      struct GenModule
+      {
+         std::string name;
+         std::vector<std::size_t> signals;
+         std::vector<GenModule> subs;
+      };
+
+      /* alias из печатных символов без '#' и '$', которые путают разбор заголовка */
+      std::string
+      MakeAlias(std::size_t id)
+      {
+         static const std::string kChars = []
+         {
+            std::string s;
+            for (char c = 33; c < 127; ++c)
+            {
+               if (c != '#' && c != '$')
+                  s += c;
+            }
+            return s;
+         }();
+         std::string alias;
+         do
+         {
+            alias += kChars[id % kChars.size()];
+            id /= kChars.size();
+         } while (id);
+         return alias;
+      }
+
+      void
+      BuildTree(GenModule &module, unsigned level, const GenOptions &opt, std::vector<GenModule *> &flat)
+      {
+         flat.push_back(&module);
+         if (level + 1 >= opt.depth)
+            return;
+         module.subs.resize(opt.fanout);
+         for (unsigned i = 0; i < opt.fanout; ++i)
+         {
+            module.subs[i].name = "u" + std::to_string(i);
+            BuildTree(module.subs[i], level + 1, opt, flat);
+         }
+      }
+
+      /* буфер с крупными сбросами в поток */
+      class Sink
+      {
+      public:
+         Sink(std::ostream &out, bool crlf) : m_out(out), m_nl(crlf ? "\r\n" : "\n")
+         {
+            m_buf.reserve(kFlush + 4096);
+         }
+
+         ~Sink() { Flush(); }
+
+         Sink &
+         operator<<(std::string_view s)
+         {
+            m_buf.append(s);
+            return *this;
+         }
+
+         Sink &
+         operator<<(char c)
+         {
+            m_buf.push_back(c);
+            return *this;
+         }
+
+         Sink &
+         operator<<(std::uint64_t v)
+         {
+            m_buf.append(std::to_string(v));
+            return *this;
+         }
+
+         void
+         EndLine()
+         {
+            m_buf.append(m_nl);
+            if (m_buf.size() >= kFlush)
+               Flush();
+         }
+
+         void
+         Flush()
+         {
+            m_out.write(m_buf.data(), static_cast<std::streamsize>(m_buf.size()));
+            m_bytes += m_buf.size();
+            m_buf.clear();
+         }
+
+         std::uint64_t
+         Bytes() const noexcept
+         {
+            return m_bytes + m_buf.size();
+         }
+
+      private:
+         static constexpr std::size_t kFlush = 1u << 20;
+
+         std::ostream &m_out;
+         std::string_view m_nl;
+         std::string m_buf;
+         std::uint64_t m_bytes = 0;
+      };
+
+      void
+      PutChange(Sink &out, const Signal &s)
+      {
+         if (s.width == 1)
+            out << s.value << s.alias;
+         else
+            out << 'b' << s.value << ' ' << s.alias;
+         out.EndLine();
+      }
+
+      void
+      WriteScope(Sink &out, const GenModule &module, const std::vector<Signal> &signals)
+      {
+         out << "$scope module " << module.name << " $end";
+         out.EndLine();
+         for (std::size_t id : module.signals)
+         {
+            const Signal &s = signals[id];
+            if (s.width == 1)
+               out << "$var wire 1 " << s.alias << " s" << static_cast<std::uint64_t>(id) << " $end";
+            else
+               out << "$var reg " << static_cast<std::uint64_t>(s.width) << ' ' << s.alias << " bus"
+                   << static_cast<std::uint64_t>(id) << " [" << static_cast<std::uint64_t>(s.width - 1) << ":0] $end";
+            out.EndLine();
+         }
+         for (const GenModule &sub : module.subs)
+            WriteScope(out, sub, signals);
+         out << "$upscope $end";
+         out.EndLine();
+      }
+   } // namespace
+
+   GenResult
+   GenerateVcd(std::ostream &os, const GenOptions &opt)
+   {
+      if (opt.signals == 0)
+         throw std::invalid_argument("GenerateVcd: signals must be > 0");
+      if (opt.timeStep == 0)
+         throw std::invalid_argument("GenerateVcd: timeStep must be > 0");
+
+      Rng rng(opt.seed);
+      GenResult res;
+
+      /*------------- 1. сигналы и иерархия ----------------------*/
+      auto randomBits = [&](unsigned width)
+      {
+         std::string v(width, '0');
+         for (char &c : v)
+         {
+            if (rng.Chance(opt.xzDensity))
+               c = (rng.Next() & 1) ? 'x' : 'z';
+            else
+               c = (rng.Next() & 1) ? '1' : '0';
+         }
+         return v;
+      };
+
+      std::vector<Signal> signals(opt.signals);
+      for (std::size_t id = 0; id < signals.size(); ++id)
+      {
+         Signal &s = signals[id];
+         s.alias = MakeAlias(id);
+         if (!opt.busWidths.empty() && rng.Chance(opt.busFraction))
+            s.width = std::max(2u, opt.busWidths[rng.Below(opt.busWidths.size())]);
+         s.value = randomBits(s.width);
+      }
+
+      GenModule top;
+      top.name = "top";
+      std::vector<GenModule *> flat;
+      BuildTree(top, 0, opt, flat);
+      for (std::size_t id = 0; id < signals.size(); ++id)
+         flat[id % flat.size()]->signals.push_back(id);
+
+      /*------------- 2. заголовок и $dumpvars -------------------*/
+      Sink out(os, opt.crlf);
+      out << "$date";
+      out.EndLine();
+      out << "\tvcdgen seed " << opt.seed;
+      out.EndLine();
+      out << "$end";
+      out.EndLine();
+      out << "$version";
+      out.EndLine();
+      out << "\tvcdgen";
+      out.EndLine();
+      out << "$end";
+      out.EndLine();
+      out << "$timescale";
+      out.EndLine();
+      out << '\t' << opt.timescale;
+      out.EndLine();
+      out << "$end";
+      out.EndLine();
+      WriteScope(out, top, signals);
+      out << "$enddefinitions $end";
+      out.EndLine();
+      out << "#0";
+      out.EndLine();
+      out << "$dumpvars";
+      out.EndLine();
+      for (const Signal &s : signals)
+         PutChange(out, s);
+      out << "$end";
+      out.EndLine();
+
+      /*------------- 3. тело ------------------------------------*/
+      const std::uint64_t meanChanges =
+          std::max<std::uint64_t>(1, static_cast<std::uint64_t>(opt.changesPerStep * opt.signals + 0.5));
+
+      auto dumpBlock = [&](std::string_view cmd, bool allX)
+      {
+         out << cmd;
+         out.EndLine();
+         for (Signal &s : signals)
+         {
+            if (allX)
+            {
+               const std::string saved = std::move(s.value);
+               s.value.assign(s.width, 'x');
+               PutChange(out, s);
+               s.value = saved;
+            }
+            else
+            {
+               PutChange(out, s);
+            }
+            ++res.changes;
+         }
+         out << "$end";
+         out.EndLine();
+      };
+
+      std::uint64_t ts = 0;
+      for (std::uint64_t step = 1; step == 1 || out.Bytes() < opt.targetBytes; ++step)
+      {
+         ts += opt.timeStep;
+         out << '#' << ts;
+         out.EndLine();
+         ++res.timestamps;
+
+         if (opt.dumpoffEvery && step % opt.dumpoffEvery == 0)
+         {
+            dumpBlock("$dumpoff", true);
+            ts += opt.timeStep * std::max(1u, opt.dumpoffLength);
+            out << '#' << ts;
+            out.EndLine();
+            ++res.timestamps;
+            dumpBlock("$dumpon", false);
+            ++res.dumpoffBlocks;
+            continue;
+         }
+
+         const std::uint64_t n = 1 + rng.Below(2 * meanChanges);
+         for (std::uint64_t k = 0; k < n; ++k)
+         {
+            Signal &s = signals[rng.Below(signals.size())];
+            if (s.changedAt == ts)
+               continue; // не больше одного изменения сигнала на метку
+            s.changedAt = ts;
+            if (s.width == 1)
+               s.value = rng.Chance(opt.xzDensity) ? ((rng.Next() & 1) ? "x" : "z") : (s.value == "1" ? "0" : "1");
+            else
+               s.value = randomBits(s.width);
+            PutChange(out, s);
+            ++res.changes;
+         }
+      }
+
+      out.Flush();
+      res.bytes = out.Bytes();
+      res.maxTs = ts;
+      return res;
+   }
+
+   GenResult
+   GenerateVcd(const std::filesystem::path &path, const GenOptions &opt)
+   {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      if (!out)
+         throw std::system_error(errno, std::generic_category(), "Can't create " + path.string());
+      const GenResult res = GenerateVcd(out, opt);
+      out.flush();
+      if (!out)
+         throw std::system_error(errno, std::generic_category(), "Can't write " + path.string());
+      return res;
+   }
+} // namespace vcd
@@ -0,0 +1,267 @@
+/*--------------------------------------------------------------------------
+ *  VcdReaderBench — Google Benchmark для загрузки и запросов VcdReader
+ *
+ *  Корпус генерируется vcd::GenerateVcd один раз и кешируется во
+ *  временном каталоге. Переменные окружения:
+ *    VCD_BENCH_FILE  — взять готовый файл вместо синтетического;
+ *    VCD_BENCH_MB    — размер синтетического корпуса (по умолчанию 32).
+ *
+ *  До замеров последовательная и параллельная загрузки сравниваются
+ *  по всем временным шкалам; расхождение — код возврата 1.
+ *------------------------------------------------------------------------*/
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Include/VcdGen.hpp"
+#include "Include/VcdStructs.hpp"
+
+namespace
+{
+   std::filesystem::path g_corpus;
+
+   std::filesystem::path
+   PrepareCorpus()
+   {
+      if (const char *file = std::getenv("VCD_BENCH_FILE"); file && *file)
+         return file;
+
+      vcd::GenOptions opt;
+      if (const char *mb = std::getenv("VCD_BENCH_MB"); mb && *mb)
+         opt.targetBytes = std::strtoull(mb, nullptr, 10) << 20;
+      else
+         opt.targetBytes = 32u << 20;
+      opt.dumpoffEvery = 5000;
+
+      const std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                         ("vcdreader-bench-" + std::to_string(opt.seed) + "-" +
+                                          std::to_string(opt.targetBytes >> 20) + "M.vcd");
+      /* генератор детерминирован: готовый файл с теми же параметрами тот же */
+      if (!std::filesystem::exists(path))
+      {
+         const vcd::GenResult res = vcd::GenerateVcd(path, opt);
+         std::cerr << "generated " << path << ": " << res.bytes << " bytes, " << res.changes << " changes\n";
+      }
+      return path;
+   }
+
+   std::unique_ptr<vcd::Handle>
+   OpenHeader()
+   {
+      auto h = std::make_unique<vcd::Handle>();
+      h->Init(g_corpus);
+      h->LoadHdr();
+      return h;
+   }
+
+   std::vector<vcd::PinValue>
+   TimelineOf(const vcd::IPinDescription &pin)
+   {
+      if (pin.GetSignalType() == vcd::SignalType::simple)
+         return static_cast<const vcd::SimplePinDescription &>(pin).GetTimeline();
+      return static_cast<const vcd::BusPinDescription &>(pin).GetTimeline();
+   }
+
+   /* последовательная загрузка — эталон для параллельной */
+   bool
+   CheckSerialMatchesParallel()
+   {
+      auto serial = OpenHeader();
+      serial->LoadSignals();
+      auto parallel = OpenHeader();
+      parallel->LoadSignalsParallel();
+
+      bool ok = serial->GetMaxTs() == parallel->GetMaxTs() &&
+                serial->GetDumpoffIntervals() == parallel->GetDumpoffIntervals();
+      for (const auto &[alias, pin] : serial->GetAlias2pinMap())
+      {
+         if (pin->GetPinType() == vcd::PinType::parameter)
+            continue;
+         const auto other = parallel->GetPinByAlias(alias);
+         const auto a = TimelineOf(*pin);
+         const auto b = other ? TimelineOf(*other) : std::vector<vcd::PinValue>{};
+         const bool same = a.size() == b.size() &&
+                           std::equal(a.begin(), a.end(), b.begin(), [](const auto &x, const auto &y)
+                                      { return x.timestamp == y.timestamp && x.value == y.value; });
+         if (!same)
+         {
+            std::cerr << "timeline mismatch for alias '" << alias << "': serial " << a.size()
+                      << " changes, parallel " << b.size() << '\n';
+            ok = false;
+         }
+      }
+      return ok;
+   }
+
+   std::int64_t
+   CorpusBytes()
+   {
+      return static_cast<std::int64_t>(std::filesystem::file_size(g_corpus));
+   }
+
+   //-------------------------------------------------------------- загрузка
+   void
+   BM_Init(benchmark::State &state)
+   {
+      for (auto _ : state)
+      {
+         vcd::Handle h;
+         h.Init(g_corpus);
+         benchmark::DoNotOptimize(h);
+      }
+   }
+   BENCHMARK(BM_Init)->Unit(benchmark::kMillisecond);
+
+   void
+   BM_LoadHdr(benchmark::State &state)
+   {
+      for (auto _ : state)
+      {
+         state.PauseTiming();
+         vcd::Handle h;
+         h.Init(g_corpus);
+         state.ResumeTiming();
+         h.LoadHdr();
+         benchmark::DoNotOptimize(h);
+      }
+   }
+   BENCHMARK(BM_LoadHdr)->Unit(benchmark::kMillisecond);
+
+   void
+   BM_LoadSignals(benchmark::State &state)
+   {
+      for (auto _ : state)
+      {
+         state.PauseTiming();
+         auto h = OpenHeader();
+         state.ResumeTiming();
+         h->LoadSignals();
+         state.PauseTiming();
+         h.reset(); // освобождение памяти не замеряется
+         state.ResumeTiming();
+      }
+      state.SetBytesProcessed(state.iterations() * CorpusBytes());
+   }
+   BENCHMARK(BM_LoadSignals)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+   void
+   BM_LoadSignalsParallel(benchmark::State &state)
+   {
+      const auto threads = static_cast<unsigned>(state.range(0));
+      for (auto _ : state)
+      {
+         state.PauseTiming();
+         auto h = OpenHeader();
+         h->SetMaxThreads(threads);
+         state.ResumeTiming();
+         h->LoadSignalsParallel();
+         state.PauseTiming();
+         h.reset();
+         state.ResumeTiming();
+      }
+      state.SetBytesProcessed(state.iterations() * CorpusBytes());
+      state.counters["threads"] = threads;
+   }
+   BENCHMARK(BM_LoadSignalsParallel)
+       ->Unit(benchmark::kMillisecond)
+       ->UseRealTime()
+       ->Apply([](benchmark::internal::Benchmark *b)
+               {
+                  const unsigned hw = std::max(2u, std::thread::hardware_concurrency());
+                  for (unsigned t = 1; t <= hw; t *= 2)
+                     b->Arg(t);
+                  if ((hw & (hw - 1)) != 0)
+                     b->Arg(hw); });
+
+   //-------------------------------------------------------------- запросы
+   /* файл загружается один раз на весь прогон запросов */
+   class Queries : public benchmark::Fixture
+   {
+   public:
+      void
+      SetUp(const benchmark::State &) override
+      {
+         if (m_handle)
+            return;
+         m_handle = OpenHeader();
+         m_handle->SetBuildStatsIndex(true);
+         m_handle->LoadSignalsParallel();
+
+         for (const auto &pin : m_handle->GetPins())
+         {
+            if (pin->GetPinType() != vcd::PinType::parameter)
+               m_pins.push_back(pin.get());
+         }
+         /* одни и те же запросы в каждом прогоне: LCG с фиксированным зерном */
+         std::uint64_t x = 12345;
+         const std::uint64_t maxTs = std::max<std::uint64_t>(1, m_handle->GetMaxTs());
+         for (std::size_t i = 0; i < kQueries; ++i)
+         {
+            x = x * 6364136223846793005ull + 1442695040888963407ull;
+            m_probes.push_back({m_pins[(x >> 33) % m_pins.size()], (x >> 7) % maxTs});
+         }
+      }
+
+   protected:
+      static constexpr std::size_t kQueries = 4096;
+
+      struct Probe
+      {
+         const vcd::IPinDescription *pin;
+         std::uint64_t ts;
+      };
+
+      static inline std::unique_ptr<vcd::Handle> m_handle;
+      static inline std::vector<const vcd::IPinDescription *> m_pins;
+      static inline std::vector<Probe> m_probes;
+   };
+
+   BENCHMARK_DEFINE_F(Queries, ValueAt)(benchmark::State &state)
+   {
+      std::size_t i = 0;
+      for (auto _ : state)
+      {
+         const Probe &p = m_probes[i++ % kQueries];
+         benchmark::DoNotOptimize(p.pin->GetValueBus(p.ts));
+      }
+   }
+   BENCHMARK_REGISTER_F(Queries, ValueAt);
+
+   BENCHMARK_DEFINE_F(Queries, RangeStats)(benchmark::State &state)
+   {
+      const std::uint64_t maxTs = m_handle->GetMaxTs();
+      std::size_t i = 0;
+      for (auto _ : state)
+      {
+         const Probe &p = m_probes[i++ % kQueries];
+         benchmark::DoNotOptimize(m_handle->RangeStats(*p.pin, p.ts / 2, p.ts / 2 + maxTs / 2));
+      }
+   }
+   BENCHMARK_REGISTER_F(Queries, RangeStats);
+} // namespace
+
+int main(int argc, char **argv)
+{
+   benchmark::Initialize(&argc, argv);
+   if (benchmark::ReportUnrecognizedArguments(argc, argv))
+      return 2;
+
+   g_corpus = PrepareCorpus();
+   if (!CheckSerialMatchesParallel())
+   {
+      std::cerr << "serial and parallel loads differ, benchmarks are not run\n";
+      return 1;
+   }
+
+   benchmark::RunSpecifiedBenchmarks();
+   benchmark::Shutdown();
+   return 0;
+}
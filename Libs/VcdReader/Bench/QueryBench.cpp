@@ -0,0 +1,573 @@
+/*--------------------------------------------------------------------------
+ *  VcdQueryBench — стоимость одиночных запросов значений («клик курсора»)
+ *
+ *  Временные шкалы 1e3..VCD_QUERY_MAX_ENTRIES (по умолчанию 1e6) изменений
+ *  строятся один раз и кешируются во временном каталоге. Порядок меток:
+ *    0 — случайный, 1 — последовательный (соседние изменения),
+ *    2 — кластерный (серии рядом со случайным центром).
+ *  Помимо GetValueChar/GetValueBus замеряются GetPinByAlias, BitProxy,
+ *  снимок всех сигналов в одной метке, форматирование значения шины так,
+ *  как это делает SignalTreeModel::data() (без Qt-части), и
+ *  конкурентные читатели. Счётчики кэш-промахов — через vcd::PerfCounters,
+ *  если ядро их даёт.
+ *
+ *  Сравнение с базой (время на итерацию, нс):
+ *    --baseline=FILE [--threshold=PCT]  код 1, если медленнее больше чем на PCT
+ *    --baseline=FILE --update-baseline  переписать базу результатами прогона
+ *------------------------------------------------------------------------*/
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "Include/Bin2Hex.hpp"
+#include "Include/VcdGen.hpp"
+#include "Include/VcdPerfCounters.hpp"
+#include "Include/VcdStructs.hpp"
+
+namespace
+{
+   constexpr std::uint64_t kStep = 10;      //!< расстояние между изменениями в корпусе
+   constexpr std::size_t kProbes = 4096;    //!< меток в одном наборе запросов
+   constexpr std::size_t kClusterSize = 64; //!< запросов в одном кластере
+   constexpr unsigned kWideSignals = 10000; //!< сигналов для снимков и поиска по alias
+
+   enum Pattern : int
+   {
+      randomAccess = 0,
+      sequentialAccess = 1,
+      clusteredAccess = 2,
+   };
+
+   const char *
+   PatternName(std::int64_t p)
+   {
+      switch (p)
+      {
+      case Pattern::sequentialAccess: return "sequential";
+      case Pattern::clusteredAccess: return "clustered";
+      default: return "random";
+      }
+   }
+
+   std::int64_t
+   MaxEntries()
+   {
+      if (const char *v = std::getenv("VCD_QUERY_MAX_ENTRIES"); v && *v)
+         return std::max<std::int64_t>(1000, std::strtoll(v, nullptr, 10));
+      return 1000000;
+   }
+
+   /* ровно entries изменений провода '!' и 16-битной шины '"', каждая тысячная — x */
+   std::filesystem::path
+   TimelineCorpus(std::int64_t entries)
+   {
+      const std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                         ("vcdquery-bench-" + std::to_string(entries) + ".vcd");
+      if (std::filesystem::exists(path))
+         return path;
+
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      if (!out)
+         throw std::system_error(errno, std::generic_category(), "Can't create " + path.string());
+      std::string buf =
+          "$timescale 1ps $end\n"
+          "$scope module top $end\n"
+          "$var wire 1 ! clk $end\n"
+          "$var reg 16 \" cnt [15:0] $end\n"
+          "$upscope $end\n"
+          "$enddefinitions $end\n"
+          "#0\n$dumpvars\n0!\nb0000000000000000 \"\n$end\n";
+      for (std::int64_t i = 1; i <= entries; ++i)
+      {
+         buf += '#';
+         buf += std::to_string(static_cast<std::uint64_t>(i) * kStep);
+         buf += (i & 1) ? "\n1!\nb" : "\n0!\nb";
+         if (i % 1000 == 0)
+         {
+            buf += 'x';
+         }
+         else
+         {
+            for (int bit = 15; bit >= 0; --bit)
+               buf += ((i >> bit) & 1) ? '1' : '0';
+         }
+         buf += " \"\n";
+         if (buf.size() >= (1u << 20))
+         {
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            buf.clear();
+         }
+      }
+      out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+      if (!out)
+         throw std::system_error(errno, std::generic_category(), "Can't write " + path.string());
+      return path;
+   }
+
+   std::filesystem::path
+   WideCorpus()
+   {
+      vcd::GenOptions opt;
+      opt.signals = kWideSignals;
+      opt.targetBytes = 4u << 20;
+      const std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                         ("vcdquery-bench-wide-" + std::to_string(opt.signals) + ".vcd");
+      if (!std::filesystem::exists(path))
+         vcd::GenerateVcd(path, opt);
+      return path;
+   }
+
+   std::unique_ptr<vcd::Handle>
+   Load(const std::filesystem::path &path)
+   {
+      auto h = std::make_unique<vcd::Handle>();
+      h->Init(path);
+      h->LoadHdr();
+      h->LoadSignalsParallel();
+      return h;
+   }
+
+   /* корпуса грузятся при первом обращении; потоки одного бенчмарка ждут загрузки */
+   const vcd::Handle &
+   TimelineHandle(std::int64_t entries)
+   {
+      static std::mutex mutex;
+      static std::map<std::int64_t, std::unique_ptr<vcd::Handle>> handles;
+      std::lock_guard lock(mutex);
+      auto &h = handles[entries];
+      if (!h)
+         h = Load(TimelineCorpus(entries));
+      return *h;
+   }
+
+   const vcd::Handle &
+   WideHandle()
+   {
+      static std::once_flag once;
+      static std::unique_ptr<vcd::Handle> h;
+      std::call_once(once, []
+                     { h = Load(WideCorpus()); });
+      return *h;
+   }
+
+   /* метки запросов: одни и те же в каждом прогоне (LCG с фиксированным зерном) */
+   std::vector<std::uint64_t>
+   MakeProbes(std::uint64_t maxTs, std::int64_t pattern, std::uint64_t seed = 12345)
+   {
+      std::vector<std::uint64_t> probes;
+      probes.reserve(kProbes);
+      std::uint64_t x = seed;
+      auto next = [&]
+      {
+         x = x * 6364136223846793005ull + 1442695040888963407ull;
+         return x >> 11;
+      };
+      const std::uint64_t span = std::max<std::uint64_t>(1, maxTs);
+
+      switch (pattern)
+      {
+      case Pattern::sequentialAccess:
+      {
+         const std::uint64_t start = next() % span;
+         for (std::size_t i = 0; i < kProbes; ++i)
+            probes.push_back((start + i * kStep) % span);
+         break;
+      }
+      case Pattern::clusteredAccess:
+      {
+         /* центр случайный, запросы — в окне ±256 изменений */
+         const std::uint64_t radius = 256 * kStep;
+         while (probes.size() < kProbes)
+         {
+            const std::uint64_t center = next() % span;
+            for (std::size_t i = 0; i < kClusterSize; ++i)
+               probes.push_back((center + span - radius % span + next() % (2 * radius)) % span);
+         }
+         break;
+      }
+      default:
+         for (std::size_t i = 0; i < kProbes; ++i)
+            probes.push_back(next() % span);
+         break;
+      }
+      return probes;
+   }
+
+   /* промахи LLC, такты и IPC на запрос; без аппаратных счётчиков не пишутся */
+   class QueryCounters
+   {
+   public:
+      QueryCounters() { m_pc.Start(); }
+
+      void
+      Finish(benchmark::State &state, double queriesPerIteration = 1.0)
+      {
+         const vcd::CounterValues v = m_pc.Stop();
+         const double queries = static_cast<double>(state.iterations()) * queriesPerIteration;
+         if (queries <= 0)
+            return;
+         auto put = [&](const char *name, const std::optional<std::uint64_t> &value)
+         {
+            if (value)
+               state.counters[name] = benchmark::Counter(static_cast<double>(*value) / queries,
+                                                         benchmark::Counter::kAvgThreads);
+         };
+         put("cycles/q", v.cycles);
+         put("llcMiss/q", v.llcMisses);
+         put("brMiss/q", v.branchMisses);
+         if (v.cycles && v.instructions)
+            state.counters["ipc"] = benchmark::Counter(v.Ipc(), benchmark::Counter::kAvgThreads);
+      }
+
+   private:
+      vcd::PerfCounters m_pc;
+   };
+
+   const vcd::IPinDescription &
+   Pin(const vcd::Handle &h, std::string_view alias)
+   {
+      return *h.GetPinByAlias(alias);
+   }
+
+   void
+   TimelineArgs(benchmark::internal::Benchmark *b)
+   {
+      const std::int64_t maxEntries = MaxEntries();
+      for (std::int64_t n = 1000; n <= maxEntries; n *= 10)
+      {
+         for (int p : {Pattern::randomAccess, Pattern::sequentialAccess, Pattern::clusteredAccess})
+            b->Args({n, p});
+      }
+      b->ArgNames({"entries", "pattern"});
+   }
+
+   //---------------------------------------------------- одиночные запросы
+   void
+   BM_ValueChar(benchmark::State &state)
+   {
+      const vcd::Handle &h = TimelineHandle(state.range(0));
+      const vcd::IPinDescription &pin = Pin(h, "!");
+      const auto probes = MakeProbes(h.GetMaxTs(), state.range(1));
+      state.SetLabel(PatternName(state.range(1)));
+
+      QueryCounters counters;
+      std::size_t i = 0;
+      for (auto _ : state)
+         benchmark::DoNotOptimize(pin.GetValueChar(probes[i++ % kProbes]));
+      counters.Finish(state);
+   }
+   BENCHMARK(BM_ValueChar)->Apply(TimelineArgs);
+
+   void
+   BM_ValueBus(benchmark::State &state)
+   {
+      const vcd::Handle &h = TimelineHandle(state.range(0));
+      const vcd::IPinDescription &pin = Pin(h, "\"");
+      const auto probes = MakeProbes(h.GetMaxTs(), state.range(1));
+      state.SetLabel(PatternName(state.range(1)));
+
+      QueryCounters counters;
+      std::size_t i = 0;
+      for (auto _ : state)
+         benchmark::DoNotOptimize(pin.GetValueBus(probes[i++ % kProbes]));
+      counters.Finish(state);
+   }
+   BENCHMARK(BM_ValueBus)->Apply(TimelineArgs);
+
+   /* бит шины через ленивый BitProxy, как его читают элементы осциллограммы */
+   void
+   BM_BitProxy(benchmark::State &state)
+   {
+      const vcd::Handle &h = TimelineHandle(state.range(0));
+      const auto &bus = static_cast<const vcd::BusPinDescription &>(Pin(h, "\""));
+      const auto &bits = bus.GetSubPins();
+      const auto probes = MakeProbes(h.GetMaxTs(), state.range(1));
+      state.SetLabel(PatternName(state.range(1)));
+
+      QueryCounters counters;
+      std::size_t i = 0;
+      for (auto _ : state)
+      {
+         const std::size_t bit = i % bits.size();
+         benchmark::DoNotOptimize(bits[bit]->GetValueChar(probes[i++ % kProbes], bit));
+      }
+      counters.Finish(state);
+   }
+   BENCHMARK(BM_BitProxy)->Apply(TimelineArgs);
+
+   /* Handle::GetValueChar(ts, alias): поиск пина + запрос */
+   void
+   BM_HandleValueChar(benchmark::State &state)
+   {
+      const vcd::Handle &h = TimelineHandle(state.range(0));
+      const auto probes = MakeProbes(h.GetMaxTs(), Pattern::randomAccess);
+
+      QueryCounters counters;
+      std::size_t i = 0;
+      for (auto _ : state)
+         benchmark::DoNotOptimize(h.GetValueChar(probes[i++ % kProbes], "!"));
+      counters.Finish(state);
+   }
+   BENCHMARK(BM_HandleValueChar)->Arg(1000)->Arg(1000000)->ArgName("entries");
+
+   /* путь SignalTreeModel::data() для шины без Qt: строка, проверка цифр, BinaryToHex */
+   void
+   BM_FormatBusValue(benchmark::State &state)
+   {
+      const vcd::Handle &h = TimelineHandle(state.range(0));
+      const vcd::IPinDescription &pin = Pin(h, "\"");
+      const auto probes = MakeProbes(h.GetMaxTs(), Pattern::randomAccess);
+
+      QueryCounters counters;
+      std::size_t i = 0;
+      for (auto _ : state)
+      {
+         std::string tmpVal = std::string(pin.GetValueBus(probes[i++ % kProbes]));
+         if (std::all_of(tmpVal.begin(), tmpVal.end(), isdigit))
+            tmpVal = utils::BinaryToHex(tmpVal);
+         benchmark::DoNotOptimize(tmpVal);
+      }
+      counters.Finish(state);
+   }
+   BENCHMARK(BM_FormatBusValue)->Arg(1000)->Arg(1000000)->ArgName("entries");
+
+   void
+   BM_BinaryToHex(benchmark::State &state)
+   {
+      std::string bits;
+      for (std::int64_t i = 0; i < state.range(0); ++i)
+         bits += (i * 7 % 3) ? '1' : '0';
+
+      for (auto _ : state)
+         benchmark::DoNotOptimize(utils::BinaryToHex(bits));
+   }
+   BENCHMARK(BM_BinaryToHex)->Arg(8)->Arg(64)->Arg(256)->ArgName("bits");
+
+   //---------------------------------------------------- много сигналов
+   void
+   BM_PinByAlias(benchmark::State &state)
+   {
+      const vcd::Handle &h = WideHandle();
+      std::vector<std::string> aliases;
+      for (const auto &[alias, pin] : h.GetAlias2pinMap())
+         aliases.emplace_back(alias);
+      std::sort(aliases.begin(), aliases.end());
+      std::vector<std::string_view> order;
+      std::uint64_t x = 12345;
+      for (std::size_t i = 0; i < kProbes; ++i)
+      {
+         x = x * 6364136223846793005ull + 1442695040888963407ull;
+         order.push_back(aliases[(x >> 33) % aliases.size()]);
+      }
+
+      QueryCounters counters;
+      std::size_t i = 0;
+      for (auto _ : state)
+         benchmark::DoNotOptimize(h.GetPinByAlias(order[i++ % kProbes]));
+      counters.Finish(state);
+   }
+   BENCHMARK(BM_PinByAlias);
+
+   /* значения всех сигналов в одной метке — то, что пересчитывает дерево сигналов при клике */
+   void
+   BM_Snapshot(benchmark::State &state)
+   {
+      const vcd::Handle &h = WideHandle();
+      std::vector<const vcd::IPinDescription *> pins;
+      for (const auto &pin : h.GetPins())
+      {
+         if (pin->GetPinType() != vcd::PinType::parameter)
+            pins.push_back(pin.get());
+      }
+      const auto probes = MakeProbes(h.GetMaxTs(), state.range(0));
+      state.SetLabel(PatternName(state.range(0)));
+
+      QueryCounters counters;
+      std::size_t i = 0;
+      for (auto _ : state)
+      {
+         const std::uint64_t ts = probes[i++ % kProbes];
+         for (const vcd::IPinDescription *pin : pins)
+            benchmark::DoNotOptimize(pin->GetValueBus(ts));
+      }
+      counters.Finish(state, static_cast<double>(pins.size()));
+      state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(pins.size()));
+      state.counters["pins"] = static_cast<double>(pins.size());
+   }
+   BENCHMARK(BM_Snapshot)->Arg(Pattern::randomAccess)->Arg(Pattern::clusteredAccess)->ArgName("pattern")->Unit(benchmark::kMicrosecond);
+
+   //---------------------------------------------------- конкурентные читатели
+   /* один Handle, разные метки у каждого потока */
+   void
+   BM_ConcurrentValueBus(benchmark::State &state)
+   {
+      const vcd::Handle &h = TimelineHandle(state.range(0));
+      const vcd::IPinDescription &pin = Pin(h, "\"");
+      const auto probes = MakeProbes(h.GetMaxTs(), Pattern::randomAccess, 12345 + state.thread_index());
+
+      QueryCounters counters;
+      std::size_t i = 0;
+      for (auto _ : state)
+         benchmark::DoNotOptimize(pin.GetValueBus(probes[i++ % kProbes]));
+      counters.Finish(state);
+   }
+   BENCHMARK(BM_ConcurrentValueBus)->Arg(1000000)->ArgName("entries")->ThreadRange(1, 8)->UseRealTime();
+
+   //---------------------------------------------------- база
+   /* консольный вывод плюс время на итерацию каждого бенчмарка, нс */
+   class BaselineReporter : public benchmark::ConsoleReporter
+   {
+   public:
+      void
+      ReportRuns(const std::vector<Run> &reports) override
+      {
+         ConsoleReporter::ReportRuns(reports);
+         for (const Run &run : reports)
+         {
+            /* при --benchmark_repetitions медиана (идёт после повторов) заменяет последний повтор */
+            if (run.error_occurred ||
+                (run.run_type == Run::RT_Aggregate && run.aggregate_name != "median"))
+               continue;
+            m_results[run.run_name.str()] =
+                run.GetAdjustedRealTime() * 1e9 / benchmark::GetTimeUnitMultiplier(run.time_unit);
+         }
+      }
+
+      const std::map<std::string, double> &
+      Results() const noexcept
+      {
+         return m_results;
+      }
+
+   private:
+      std::map<std::string, double> m_results;
+   };
+
+   /* строки «имя нс», '#' — комментарий */
+   std::map<std::string, double>
+   ReadBaseline(const std::filesystem::path &path)
+   {
+      std::map<std::string, double> base;
+      std::ifstream in(path);
+      for (std::string line; std::getline(in, line);)
+      {
+         if (line.empty() || line[0] == '#')
+            continue;
+         const auto space = line.rfind(' ');
+         if (space == std::string::npos)
+            continue;
+         base[line.substr(0, space)] = std::strtod(line.c_str() + space + 1, nullptr);
+      }
+      return base;
+   }
+
+   bool
+   WriteBaseline(const std::filesystem::path &path, const std::map<std::string, double> &results)
+   {
+      std::ofstream out(path, std::ios::trunc);
+      out << "# VcdQueryBench baseline: benchmark name, real time per iteration in ns\n";
+      for (const auto &[name, ns] : results)
+         out << name << ' ' << ns << '\n';
+      return static_cast<bool>(out);
+   }
+
+   /* @return число регрессий; запуски без записи в базе не сравниваются */
+   std::size_t
+   CompareWithBaseline(const std::map<std::string, double> &base,
+                       const std::map<std::string, double> &results, double thresholdPct)
+   {
+      std::size_t regressions = 0, compared = 0;
+      for (const auto &[name, ns] : results)
+      {
+         const auto it = base.find(name);
+         if (it == base.end() || it->second <= 0)
+            continue;
+         ++compared;
+         const double deltaPct = (ns / it->second - 1.0) * 100.0;
+         if (deltaPct > thresholdPct)
+         {
+            std::cerr << "regression: " << name << ": " << it->second << " ns -> " << ns << " ns (+"
+                      << deltaPct << "%)\n";
+            ++regressions;
+         }
+      }
+      std::cerr << compared << " benchmarks compared with the baseline, " << regressions
+                << " slower by more than " << thresholdPct << "%\n";
+      return regressions;
+   }
+} // namespace
+
+int main(int argc, char **argv)
+{
+   /* свои ключи убираются до benchmark::Initialize */
+   std::filesystem::path baseline;
+   bool updateBaseline = false;
+   double thresholdPct = 50.0;
+   int kept = 1;
+   for (int i = 1; i < argc; ++i)
+   {
+      const std::string_view arg = argv[i];
+      if (arg.rfind("--baseline=", 0) == 0)
+      {
+         baseline = std::string(arg.substr(std::strlen("--baseline=")));
+      }
+      else if (arg == "--update-baseline")
+      {
+         updateBaseline = true;
+      }
+      else if (arg.rfind("--threshold=", 0) == 0)
+      {
+         thresholdPct = std::strtod(argv[i] + std::strlen("--threshold="), nullptr);
+      }
+      else
+      {
+         argv[kept++] = argv[i];
+      }
+   }
+   argc = kept;
+
+   benchmark::Initialize(&argc, argv);
+   if (benchmark::ReportUnrecognizedArguments(argc, argv))
+      return 2;
+   if (updateBaseline && baseline.empty())
+   {
+      std::cerr << "--update-baseline needs --baseline=FILE\n";
+      return 2;
+   }
+
+   BaselineReporter reporter;
+   benchmark::RunSpecifiedBenchmarks(&reporter);
+   benchmark::Shutdown();
+
+   if (baseline.empty())
+      return 0;
+   if (updateBaseline)
+   {
+      if (!WriteBaseline(baseline, reporter.Results()))
+      {
+         std::cerr << "can't write " << baseline << '\n';
+         return 1;
+      }
+      return 0;
+   }
+   if (!std::filesystem::exists(baseline))
+   {
+      std::cerr << "no baseline " << baseline << ", nothing to compare\n";
+      return 0;
+   }
+   return CompareWithBaseline(ReadBaseline(baseline), reporter.Results(), thresholdPct) ? 1 : 0;
+}
@@ -0,0 +1,330 @@
+#include "BlockReader.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define VCD_HAS_IO_URING 1
+#endif
+
+namespace vcd
+{
+   namespace
+   {
+      //======================================================================
+      // Пул потоков, каждый делает блокирующий pread()
+      //======================================================================
+      class PreadPoolReader final : public BlockReader
+      {
+      public:
+         PreadPoolReader(int fd, unsigned depth)
+             : m_fd(fd)
+         {
+            const unsigned nThreads = std::max(1u, std::min(depth, 4u));
+            for (unsigned i = 0; i < nThreads; ++i)
+               m_threads.emplace_back(&PreadPoolReader::Worker, this);
+         }
+
+         ~PreadPoolReader() override
+         {
+            {
+               std::lock_guard lock(m_mtx);
+               m_stop = true;
+            }
+            m_reqCv.notify_all();
+            for (auto &t : m_threads)
+               t.join();
+         }
+
+         bool
+         Submit(std::size_t tag, char *dst, std::size_t len, std::uint64_t offset) override
+         {
+            {
+               std::lock_guard lock(m_mtx);
+               m_requests.push_back({tag, dst, len, offset});
+            }
+            m_reqCv.notify_one();
+            return true;
+         }
+
+         Completion
+         WaitOne() override
+         {
+            std::unique_lock lock(m_mtx);
+            m_doneCv.wait(lock, [this]
+                          { return !m_done.empty(); });
+            Completion c = m_done.front();
+            m_done.pop_front();
+            return c;
+         }
+
+         const char *
+         GetName() const noexcept override
+         {
+            return "pread";
+         }
+
+      private:
+         struct Request
+         {
+            std::size_t tag;
+            char *dst;
+            std::size_t len;
+            std::uint64_t offset;
+         };
+
+         void
+         Worker()
+         {
+            for (;;)
+            {
+               Request req;
+               {
+                  std::unique_lock lock(m_mtx);
+                  m_reqCv.wait(lock, [this]
+                               { return m_stop || !m_requests.empty(); });
+                  if (m_requests.empty())
+                     return;
+                  req = m_requests.front();
+                  m_requests.pop_front();
+               }
+
+               long total = 0;
+               while (static_cast<std::size_t>(total) < req.len)
+               {
+                  const ssize_t n = ::pread(m_fd, req.dst + total, req.len - total,
+                                            static_cast<off_t>(req.offset + total));
+                  if (n < 0 && errno == EINTR)
+                     continue;
+                  if (n < 0)
+                  {
+                     total = -errno;
+                     break;
+                  }
+                  if (n == 0)
+                     break; // EOF
+                  total += n;
+               }
+
+               {
+                  std::lock_guard lock(m_mtx);
+                  m_done.push_back({req.tag, total});
+               }
+               m_doneCv.notify_one();
+            }
+         }
+
+         int m_fd;
+         std::mutex m_mtx;
+         std::condition_variable m_reqCv;
+         std::condition_variable m_doneCv;
+         std::deque<Request> m_requests;
+         std::deque<Completion> m_done;
+         std::vector<std::thread> m_threads;
+         bool m_stop = false;
+      };
+
+#ifdef VCD_HAS_IO_URING
+      //======================================================================
+      // io_uring без liburing: кольца отображаются напрямую через mmap.
+      // Используется одним потоком (Submit и WaitOne не конкурируют).
+      //======================================================================
+      class UringReader final : public BlockReader
+      {
+      public:
+         static std::unique_ptr<UringReader>
+         Open(int fd, unsigned depth)
+         {
+            auto r = std::unique_ptr<UringReader>(new UringReader(fd));
+            if (!r->Setup(depth))
+               return nullptr;
+            return r;
+         }
+
+         ~UringReader() override
+         {
+            if (m_sqes)
+               ::munmap(m_sqes, m_sqesSize);
+            if (m_cqRing && m_cqRing != m_sqRing)
+               ::munmap(m_cqRing, m_cqRingSize);
+            if (m_sqRing)
+               ::munmap(m_sqRing, m_sqRingSize);
+            if (m_ringFd >= 0)
+               ::close(m_ringFd);
+         }
+
+         bool
+         Submit(std::size_t tag, char *dst, std::size_t len, std::uint64_t offset) override
+         {
+            const unsigned tail = *m_sqTail;
+            const unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+            if (tail - head >= m_sqEntries)
+               return false;
+
+            const unsigned idx = tail & *m_sqMask;
+            m_iov[idx].iov_base = dst;
+            m_iov[idx].iov_len = len;
+
+            io_uring_sqe *sqe = &m_sqes[idx];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = m_fd;
+            sqe->addr = reinterpret_cast<std::uint64_t>(&m_iov[idx]);
+            sqe->len = 1;
+            sqe->off = offset;
+            sqe->user_data = tag;
+
+            m_sqArray[idx] = idx;
+            __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+
+            for (;;)
+            {
+               const long r = ::syscall(__NR_io_uring_enter, m_ringFd, 1, 0, 0, nullptr, 0);
+               if (r >= 0)
+                  return true;
+               if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                  return false;
+            }
+         }
+
+         Completion
+         WaitOne() override
+         {
+            for (;;)
+            {
+               const unsigned head = *m_cqHead;
+               const unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+               if (head != tail)
+               {
+                  const io_uring_cqe &cqe = m_cqes[head & *m_cqMask];
+                  Completion c{static_cast<std::size_t>(cqe.user_data), cqe.res};
+                  __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+                  return c;
+               }
+               ::syscall(__NR_io_uring_enter, m_ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            }
+         }
+
+         const char *
+         GetName() const noexcept override
+         {
+            return "io_uring";
+         }
+
+      private:
+         explicit UringReader(int fd)
+             : m_fd(fd)
+         {
+         }
+
+         bool
+         Setup(unsigned depth)
+         {
+            io_uring_params p{};
+            m_ringFd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &p));
+            if (m_ringFd < 0)
+               return false; // ENOSYS / EPERM (seccomp) / …
+
+            m_sqEntries = p.sq_entries;
+            m_sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            m_cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+            if (single)
+               m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+
+            m_sqRing = ::mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+            if (m_sqRing == MAP_FAILED)
+            {
+               m_sqRing = nullptr;
+               return false;
+            }
+            if (single)
+            {
+               m_cqRing = m_sqRing;
+            }
+            else
+            {
+               m_cqRing = ::mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+               if (m_cqRing == MAP_FAILED)
+               {
+                  m_cqRing = nullptr;
+                  return false;
+               }
+            }
+
+            m_sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+            void *sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED)
+               return false;
+            m_sqes = static_cast<io_uring_sqe *>(sqes);
+
+            auto *sq = static_cast<char *>(m_sqRing);
+            auto *cq = static_cast<char *>(m_cqRing);
+            m_sqHead = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+            m_sqTail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+            m_sqMask = reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+            m_sqArray = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+            m_cqHead = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+            m_cqTail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+            m_cqMask = reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+
+            m_iov.resize(p.sq_entries);
+            return true;
+         }
+
+         int m_fd;
+         int m_ringFd = -1;
+         unsigned m_sqEntries = 0;
+
+         void *m_sqRing = nullptr;
+         void *m_cqRing = nullptr;
+         io_uring_sqe *m_sqes = nullptr;
+         std::size_t m_sqRingSize = 0;
+         std::size_t m_cqRingSize = 0;
+         std::size_t m_sqesSize = 0;
+
+         unsigned *m_sqHead = nullptr;
+         unsigned *m_sqTail = nullptr;
+         unsigned *m_sqMask = nullptr;
+         unsigned *m_sqArray = nullptr;
+         unsigned *m_cqHead = nullptr;
+         unsigned *m_cqTail = nullptr;
+         unsigned *m_cqMask = nullptr;
+         io_uring_cqe *m_cqes = nullptr;
+
+         std::vector<iovec> m_iov; //!< по одному на SQE, живут до io_uring_enter
+      };
+#endif // VCD_HAS_IO_URING
+   } // namespace
+
+   std::unique_ptr<BlockReader>
+   BlockReader::Create(int fd, unsigned depth, bool preferUring)
+   {
+#ifdef VCD_HAS_IO_URING
+      if (preferUring)
+      {
+         if (auto uring = UringReader::Open(fd, depth))
+            return uring;
+      }
+#else
+      (void)preferUring;
+#endif
+      return std::make_unique<PreadPoolReader>(fd, depth);
+   }
+} // namespace vcd
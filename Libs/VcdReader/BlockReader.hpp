@@ -0,0 +1,45 @@
+#pragma once
+/*****************************************************************************
+ *  BlockReader
+ *  -----------
+ *  Асинхронное чтение блоков файла для конвейерной загрузки тела VCD.
+ *  Реализации: io_uring (если ядро позволяет) и пул потоков с pread().
+ *****************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace vcd
+{
+   class BlockReader
+   {
+   public:
+      struct Completion
+      {
+         std::size_t tag = 0; //!< то, что передали в Submit()
+         long result = 0;     //!< прочитано байт или -errno
+      };
+
+      virtual ~BlockReader() = default;
+
+      /**  Ставит в очередь чтение [offset, offset + len) в dst. */
+      virtual bool
+      Submit(std::size_t tag, char *dst, std::size_t len, std::uint64_t offset) = 0;
+
+      /**  Блокируется до завершения хотя бы одного чтения. */
+      virtual Completion
+      WaitOne() = 0;
+
+      virtual const char *
+      GetName() const noexcept = 0;
+
+      /**
+       * @brief Открывает читатель для fd.
+       * @param depth  максимум одновременно висящих запросов.
+       * @param preferUring false — сразу пул pread-потоков.
+       */
+      static std::unique_ptr<BlockReader>
+      Create(int fd, unsigned depth, bool preferUring = true);
+   };
+} // namespace vcd
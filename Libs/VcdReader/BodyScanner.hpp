@@ -0,0 +1,94 @@
+#pragma once
+/*****************************************************************************
+ *  BodyScanner
+ *  -----------
+ *  Общий лексер тела VCD для всех загрузчиков и построителя индекса.
+ *****************************************************************************/
+
+#include <cstdint>
+#include <string_view>
+
+namespace vcd::detail
+{
+   inline bool
+   IsSpace(char c)
+   {
+      return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+   }
+
+   /*
+    * Разбор фрагмента тела VCD [p, e), начинающегося с начала строки.
+    *  onTs(ts)              — "#<ts>"
+    *  onChange(val, alias)  — "b<bits> <alias>" или "<0|1|x|z><alias>"
+    *  onCommand(cmd)        — "$dumpoff", "$dumpon", "$end", … (без '$')
+    * '\r' считается пробельным символом, поэтому CRLF-файлы не требуют
+    * предварительной очистки буфера.
+    */
+   template <class OnTs, class OnChange, class OnCommand>
+   void
+   ScanBody(const char *p, const char *e,
+            OnTs &&onTs, OnChange &&onChange, OnCommand &&onCommand)
+   {
+      auto skip_ws = [&]()
+      {
+         while (p < e && IsSpace(*p))
+            ++p;
+      };
+      auto skip_word = [&]()
+      {
+         while (p < e && !IsSpace(*p))
+            ++p;
+      };
+
+      while (p < e)
+      {
+         skip_ws();
+         if (p >= e)
+            break;
+
+         /*--- timestamp -------------------------------------*/
+         if (*p == '#')
+         {
+            ++p;
+            uint64_t ts = 0;
+            while (p < e && *p >= '0' && *p <= '9')
+               ts = ts * 10 + (*p++ - '0');
+            onTs(ts);
+            continue;
+         }
+
+         /*--- multibit  b<val> <alias> ----------------------*/
+         if (*p == 'b')
+         {
+            ++p;
+            const char *vBeg = p;
+            skip_word();
+            std::string_view bits(vBeg, p - vBeg);
+
+            skip_ws(); // alias
+            const char *aBeg = p;
+            skip_word();
+            onChange(bits, std::string_view(aBeg, p - aBeg));
+            continue;
+         }
+
+         /*--- $dumpXXX … ------------------------------------*/
+         if (*p == '$')
+         {
+            const char *cBeg = ++p;
+            skip_word();
+            std::string_view cmd(cBeg, p - cBeg);
+            while (p < e && *p != '\n')
+               ++p;
+            onCommand(cmd);
+            continue;
+         }
+
+         /*--- 1-бит  <val><alias> ---------------------------*/
+         std::string_view val(p++, 1);
+         const char *aBeg = p;
+         skip_word();
+         onChange(val, std::string_view(aBeg, p - aBeg));
+      }
+   }
+} // namespace vcd::detail
@@ -1,78 +1,1081 @@
 #include "Include/VcdStructs.hpp"
+#include "Include/VcdChangeIndex.hpp"
+#include "Include/VcdGen.hpp"
+#include "Include/VcdReport.hpp"
+#include "Include/VcdStatsIndex.hpp"
+#include "Include/VcdTrace.hpp"
+#include "Include/VcdWriter.hpp"
+#include <atomic>
 #include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <tuple>
 #include <gtest/gtest.h>
 
-// TEST(VcdReader, C17_flag)
-//{
-//    const std::filesystem::path fPath = "/home/justfunde/Work/vcd/test1.vcd";
-//
-//    vcdReader reader;
-//    const auto vcdHandle = reader.ParseFile(fPath);
-// }
-
-//"/home/justfunde/Projects/vcd/VcdTests/c432.gates.flat.synth - XXL.vcd"
-
-// TEST(VcdReader, DISABLED_LargeFile)
-//{
-//    const std::filesystem::path fPath = "/home/justfunde/Projects/vcd/VcdTests/c432.gates.flat.synth - XXL.vcd";
-//    // const std::filesystem::path fPath = "/home/justfunde/Projects/vcd/VcdTests/c432.gates.flat.synth - XXL.vcd";
-//
-//    vcdReader reader;
-//    auto vcdHandle = reader.ParseFile(fPath);
-//
-//    // vcdHandle->ensureSignalLoaded("'");
-//    for (auto [_, pin] : vcdHandle->pinAlias2DescriptionMap)
-//    {
-//       // vcdHandle->ensureSignalLoaded(pin->alias);
-//    }
-// }
-//
-// TEST(VcdReader, DISABLED_LargeParallel)
-//{
-//    const std::filesystem::path fPath = "/home/justfunde/Projects/vcd/VcdTests/c432.gates.flat.synth - XXL.vcd";
-//    // const std::filesystem::path fPath = "/home/justfunde/Projects/vcd/VcdTests/c432.gates.flat.synth - XXL.vcd";
-//
-//    vcdReader reader;
-//    auto vcdHandle = reader.ParseFile(fPath);
-//
-//    vcdHandle->loadParallel();
-//    for (auto [_, pin] : vcdHandle->pinAlias2DescriptionMap)
-//    {
-//    }
-// }
-//
 TEST(VcdReaderNew, majorityOf5)
 {
-   const std::filesystem::path fPath = "/home/justfunde/Projects/MIET/VcdViewer/VcdTests/test1.vcd";
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
 
    vcd::Handle h;
    h.Init(fPath);
    h.LoadHdr();
    h.LoadSignals();
-   // auto map = h.alias2pinMap();
-   // auto pPin = map["%"];
-   // auto pPin2 = std::static_pointer_cast<vcd::SimplePinDescription>(pPin);
-   int a = 5;
-   a += 5;
-   // const auto vcdHandle = reader.ParseFile(fPath);
-}
-
-// TEST(VcdReaderNew, majorityOf5_large)
-//{
-//    const std::filesystem::path fPath = "/home/justfunde/Projects/vcd/VcdTests/c432.gates.flat.synth - XXL.vcd";
-//
-//    vcd::Handle h;
-//    h.Init(fPath);
-//    h.LoadHdr();
-//    h.LoadSignalsParallel();
-//    // auto map = h.alias2pinMap();
-//    // auto pPin = map["%"];
-//    // auto pPin2 = std::static_pointer_cast<vcd::SimplePinDescription>(pPin);
-//    int a = 5;
-//    a += 5;
-//    // const auto vcdHandle = reader.ParseFile(fPath);
-// }
-//
+
+   ASSERT_TRUE(h.GetRootModule());
+   EXPECT_EQ(h.GetRootModule()->GetName(), "tb_majorityof5");
+   EXPECT_EQ(h.GetTimeScale(), "1ps");
+   ASSERT_TRUE(h.GetPinByAlias("!"));
+   EXPECT_EQ(h.GetPinByAlias("!")->GetName(), "led");
+   EXPECT_EQ(h.GetValueBus(95000, "\""), "1001");
+}
+
+TEST(VcdReaderNew, CompactReleasesRawData)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   vcd::Handle serial;
+   serial.Init(fPath);
+   serial.LoadHdr();
+   serial.LoadSignals();
+   EXPECT_FALSE(serial.HasRawData());
+
+   vcd::Handle parallel;
+   parallel.Init(fPath);
+   parallel.LoadHdr();
+   parallel.LoadSignalsParallel();
+   EXPECT_FALSE(parallel.HasRawData());
+   EXPECT_GT(parallel.GetRssInfo().peakBytes, 0u);
+
+   for (const vcd::Handle *h : {&serial, &parallel})
+   {
+      EXPECT_EQ(h->GetValueBus(95000, "\""), "1001");
+      EXPECT_EQ(h->GetValueBus(95000, "-"), "1001");
+      EXPECT_EQ(h->GetValueChar(75000, "!"), '1');
+      EXPECT_EQ(h->GetValueChar(85000, "!"), '0');
+   }
+}
+
+TEST(VcdReaderNew, ValuePoolEmptyAppend)
+{
+   vcd::ValuePool pool;
+   EXPECT_TRUE(pool.Append("").empty()); // первым, до выделения блока
+   EXPECT_EQ(pool.Append("1010"), "1010");
+   EXPECT_TRUE(pool.Append("").empty());
+}
+
+namespace
+{
+   std::vector<vcd::PinValue>
+   TimelineOf(const vcd::PinDescriptionPtr &pin)
+   {
+      if (pin->GetSignalType() == vcd::SignalType::simple)
+         return std::static_pointer_cast<vcd::SimplePinDescription>(pin)->GetTimeline();
+      return std::static_pointer_cast<vcd::BusPinDescription>(pin)->GetTimeline();
+   }
+} // namespace
+
+TEST(VcdReaderNew, PipelinedMatchesParallel)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   vcd::Handle reference;
+   reference.Init(fPath);
+   reference.LoadHdr();
+   reference.LoadSignalsParallel();
+
+   for (bool uring : {true, false})
+   {
+      // маленькие блоки, чтобы границы "\n#" попадали куда угодно
+      for (std::size_t blockSize : {std::size_t{7}, std::size_t{64}, std::size_t{4096}, std::size_t{0}})
+      {
+         SCOPED_TRACE("uring=" + std::to_string(uring) + " block=" + std::to_string(blockSize));
+
+         vcd::Handle h;
+         h.Init(fPath);
+         h.LoadHdr();
+         h.SetUseIoUring(uring);
+         h.SetReadBlockSize(blockSize);
+         h.LoadSignalsPipelined();
+
+         EXPECT_FALSE(h.HasRawData());
+         if (!uring)
+         {
+            EXPECT_EQ(h.GetReadBackend(), "pread");
+         }
+         EXPECT_EQ(h.GetMaxTs(), reference.GetMaxTs());
+         EXPECT_EQ(h.GetDumpoffIntervals(), reference.GetDumpoffIntervals());
+         ASSERT_EQ(h.GetPins().size(), reference.GetPins().size());
+
+         for (const auto &[alias, refPin] : reference.GetAlias2pinMap())
+         {
+            if (refPin->GetPinType() == vcd::PinType::parameter)
+               continue;
+            auto pin = h.GetPinByAlias(alias);
+            ASSERT_TRUE(pin);
+            const auto expected = TimelineOf(refPin);
+            const auto actual = TimelineOf(pin);
+            ASSERT_EQ(actual.size(), expected.size()) << alias;
+            for (std::size_t i = 0; i < expected.size(); ++i)
+            {
+               EXPECT_EQ(actual[i].timestamp, expected[i].timestamp) << alias;
+               EXPECT_EQ(actual[i].value, expected[i].value) << alias;
+            }
+         }
+      }
+   }
+}
+
+TEST(VcdReaderNew, SignalFilter)
+{
+   vcd::SignalFilter glob;
+   glob.Include("tb.dut.*").Exclude("*.abc");
+   EXPECT_TRUE(glob.Matches("tb.dut.core0.clk"));
+   EXPECT_FALSE(glob.Matches("tb.dut.abc"));
+   EXPECT_FALSE(glob.Matches("tb.dutx.clk"));
+   EXPECT_FALSE(glob.Matches("tb.led"));
+
+   vcd::SignalFilter re;
+   re.Include(R"(tb\.(led|sw))", vcd::SignalFilter::Syntax::regex);
+   EXPECT_TRUE(re.Matches("tb.sw"));
+   EXPECT_FALSE(re.Matches("tb.dut.sw"));
+
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+   for (bool pipelined : {false, true})
+   {
+      vcd::Handle h;
+      h.Init(fPath);
+      h.LoadHdr();
+      h.SetSignalFilter(vcd::SignalFilter{}.Include("tb_majorityof5.dut.*").Exclude("*.abc"));
+      pipelined ? h.LoadSignalsPipelined() : h.LoadSignalsParallel();
+
+      // заголовок целиком: отфильтрованные пины остаются в дереве
+      ASSERT_TRUE(h.GetPinByAlias("#"));
+      ASSERT_TRUE(h.GetPinByAlias("\""));
+      EXPECT_FALSE(h.IsPinLoaded(*h.GetPinByAlias("#")));
+      EXPECT_FALSE(h.IsPinLoaded(*h.GetPinByAlias("\"")));
+      EXPECT_TRUE(TimelineOf(h.GetPinByAlias("#")).empty());
+      EXPECT_TRUE(TimelineOf(h.GetPinByAlias("\"")).empty());
+
+      // "!" объявлен и в tb, и в dut — сохраняется
+      EXPECT_TRUE(h.IsPinLoaded(*h.GetPinByAlias("!")));
+      EXPECT_EQ(h.GetValueBus(95000, "-"), "1001");
+      EXPECT_EQ(h.GetValueChar(75000, "!"), '1');
+   }
+}
+
+TEST(VcdReaderNew, LoadWindowMatchesFullLoad)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+   const std::filesystem::path sidecar = std::filesystem::temp_directory_path() / "majorityof5.test.vcdidx";
+   std::filesystem::remove(sidecar);
+
+   vcd::Handle reference;
+   reference.Init(fPath);
+   reference.LoadHdr();
+   reference.LoadSignalsParallel();
+
+   vcd::VcdIndex::Options opt;
+   opt.checkpointBytes = 256; // несколько контрольных точек на маленьком файле
+   opt.seekBytes = 64;
+   opt.sidecar = sidecar;
+
+   const std::pair<std::uint64_t, std::uint64_t> windows[] = {
+       {10000, 40000}, {95000, 250000}, {333000, 500000}, {120000, 120000}};
+
+   for (int pass = 0; pass < 2; ++pass) // второй проход читает sidecar
+   {
+      for (const auto &[t0, t1] : windows)
+      {
+         SCOPED_TRACE("pass=" + std::to_string(pass) + " window=" + std::to_string(t0) + ".." + std::to_string(t1));
+
+         vcd::Handle h;
+         h.Init(fPath);
+         h.LoadHdr();
+         h.LoadWindow(t0, t1, opt);
+         EXPECT_FALSE(h.HasRawData());
+         EXPECT_EQ(h.GetMaxTs(), t1);
+
+         for (const auto &[alias, pin] : h.GetAlias2pinMap())
+         {
+            if (pin->GetPinType() == vcd::PinType::parameter)
+               continue;
+            for (const auto &v : TimelineOf(pin))
+            {
+               EXPECT_GE(v.timestamp, t0) << alias;
+               EXPECT_LE(v.timestamp, t1) << alias;
+            }
+            for (std::uint64_t ts = t0; ts <= t1; ts += 5000)
+            {
+               if (pin->GetSignalType() == vcd::SignalType::simple)
+                  EXPECT_EQ(h.GetValueChar(ts, alias), reference.GetValueChar(ts, alias)) << alias << " @" << ts;
+               else
+                  EXPECT_EQ(h.GetValueBus(ts, alias), reference.GetValueBus(ts, alias)) << alias << " @" << ts;
+            }
+         }
+      }
+      EXPECT_TRUE(std::filesystem::exists(sidecar));
+   }
+
+   const auto index = vcd::VcdIndex::Load(sidecar, fPath);
+   ASSERT_TRUE(index);
+   EXPECT_GT(index->GetCheckpoints().size(), 2u);
+   EXPECT_EQ(index->GetMaxTs(), reference.GetMaxTs());
+
+   /* битый sidecar того же размера: огромное число alias -> nullopt, не bad_alloc */
+   const std::filesystem::path good = sidecar.string() + ".good";
+   std::filesystem::copy_file(sidecar, good, std::filesystem::copy_options::overwrite_existing);
+   {
+      std::fstream f(sidecar, std::ios::binary | std::ios::in | std::ios::out);
+      const std::uint64_t huge = ~std::uint64_t{0} / 2;
+      f.seekp(8 + 4 * sizeof(std::uint64_t)); // magic, размер, mtime, bodyOffset, maxTs
+      f.write(reinterpret_cast<const char *>(&huge), sizeof(huge));
+   }
+   EXPECT_FALSE(vcd::VcdIndex::Load(sidecar, fPath));
+
+   /* обрезанный sidecar */
+   std::filesystem::copy_file(good, sidecar, std::filesystem::copy_options::overwrite_existing);
+   std::filesystem::resize_file(sidecar, std::filesystem::file_size(sidecar) / 2);
+   EXPECT_FALSE(vcd::VcdIndex::Load(sidecar, fPath));
+   std::filesystem::remove(good);
+   std::filesystem::remove(sidecar);
+}
+
+TEST(VcdReaderNew, LoadWindowEmptyRange)
+{
+   /* единственная метка #0: окно не читает из файла ничего, всё — из контрольной точки */
+   const std::filesystem::path fPath = std::filesystem::temp_directory_path() / "vcd_window_empty.vcd";
+   std::ofstream(fPath, std::ios::binary) << "$timescale 1ns $end\n"
+                                             "$scope module top $end\n"
+                                             "$var wire 1 ! a $end\n"
+                                             "$var wire 4 \" b [3:0] $end\n"
+                                             "$upscope $end\n"
+                                             "$enddefinitions $end\n"
+                                             "#0\n"
+                                             "$dumpvars\n"
+                                             "1!\n"
+                                             "b1010 \"\n"
+                                             "$end\n";
+
+   vcd::VcdIndex::Options opt;
+   opt.persist = false;
+
+   vcd::Handle h;
+   h.Init(fPath);
+   h.LoadHdr();
+   h.SetBuildChangeIndex(true);
+   h.SetBuildStatsIndex(true);
+   h.LoadWindow(0, 5000, opt);
+
+   EXPECT_EQ(h.GetValueChar(100, "!"), '1');
+   EXPECT_EQ(h.GetValueBus(100, "\""), "1010");
+   EXPECT_NE(h.GetChangeIndex(), nullptr);
+   std::filesystem::remove(fPath);
+}
+
+TEST(VcdReaderNew, SortPartsNaturally)
+{
+   std::vector<std::filesystem::path> parts = {"d/run_10.vcd", "d/run_2.vcd", "d/run.vcd", "d/run_1.vcd"};
+   vcd::Handle::SortPartsNaturally(parts);
+   const std::vector<std::filesystem::path> expected = {"d/run.vcd", "d/run_1.vcd", "d/run_2.vcd", "d/run_10.vcd"};
+   EXPECT_EQ(parts, expected);
+}
+
+TEST(VcdReaderNew, LoadSignalsFromParts)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   vcd::Handle reference;
+   reference.Init(fPath);
+   reference.LoadHdr();
+   reference.LoadSignalsParallel();
+
+   /* режем файл как симулятор: вторая часть повторяет заголовок и
+      начинается с $dumpall полного состояния */
+   std::ifstream in(fPath, std::ios::binary);
+   const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+   const std::size_t hdrEnd = text.find('\n', text.find("$enddefinitions")) + 1;
+   const std::size_t split = text.find("#200000");
+   const std::size_t splitEnd = text.find('\n', split) + 1;
+   ASSERT_NE(split, std::string::npos);
+
+   std::string dumpall = "#200000\n$dumpall\n";
+   for (const auto &[alias, pin] : reference.GetAlias2pinMap())
+   {
+      if (pin->GetPinType() == vcd::PinType::parameter)
+         continue;
+      if (pin->GetSignalType() == vcd::SignalType::simple)
+         dumpall += std::string(1, reference.GetValueChar(200000, alias)) + std::string(alias) + "\n";
+      else
+         dumpall += "b" + std::string(reference.GetValueBus(200000, alias)) + " " + std::string(alias) + "\n";
+   }
+   dumpall += "$end\n";
+
+   const auto dir = std::filesystem::temp_directory_path() / "vcd_parts_test";
+   std::filesystem::create_directories(dir);
+   std::vector<std::filesystem::path> parts = {dir / "run_1.vcd", dir / "run.vcd"};
+   std::ofstream(parts[1], std::ios::binary) << text.substr(0, split);
+   std::ofstream(parts[0], std::ios::binary) << text.substr(0, hdrEnd) << dumpall << text.substr(splitEnd);
+
+   vcd::Handle::SortPartsNaturally(parts);
+   vcd::Handle h;
+   h.Init(parts.front());
+   h.LoadHdr();
+   h.LoadSignalsFromParts(parts);
+
+   EXPECT_EQ(h.GetMaxTs(), reference.GetMaxTs());
+   EXPECT_EQ(h.GetDumpoffIntervals(), reference.GetDumpoffIntervals());
+   for (const auto &[alias, refPin] : reference.GetAlias2pinMap())
+   {
+      if (refPin->GetPinType() == vcd::PinType::parameter)
+         continue;
+      const auto expected = TimelineOf(refPin);
+      const auto actual = TimelineOf(h.GetPinByAlias(alias));
+      ASSERT_EQ(actual.size(), expected.size()) << alias;
+      for (std::size_t i = 0; i < expected.size(); ++i)
+      {
+         EXPECT_EQ(actual[i].timestamp, expected[i].timestamp) << alias;
+         EXPECT_EQ(actual[i].value, expected[i].value) << alias;
+      }
+   }
+
+   /* несовпадающий заголовок */
+   std::string renamed = text.substr(0, split);
+   renamed.replace(renamed.find(" abc "), 5, " xyz ");
+   std::ofstream(parts[1], std::ios::binary) << renamed;
+   vcd::Handle bad;
+   bad.Init(parts.front());
+   bad.LoadHdr();
+   EXPECT_THROW(bad.LoadSignalsFromParts(parts), std::runtime_error);
+
+   std::filesystem::remove_all(dir);
+}
+
+TEST(VcdReaderNew, ExactReservation)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   vcd::Handle reference;
+   reference.Init(fPath);
+   reference.LoadHdr();
+   reference.LoadSignalsParallel();
+
+   for (bool parallel : {false, true})
+   {
+      vcd::Handle h;
+      h.Init(fPath);
+      h.LoadHdr();
+      h.SetExactReservation(true);
+      parallel ? h.LoadSignalsParallel() : h.LoadSignals();
+
+      for (const auto &[alias, refPin] : reference.GetAlias2pinMap())
+      {
+         if (refPin->GetPinType() == vcd::PinType::parameter)
+            continue;
+         const auto expected = TimelineOf(refPin);
+         const auto actual = TimelineOf(h.GetPinByAlias(alias));
+         ASSERT_EQ(actual.size(), expected.size()) << alias;
+         for (std::size_t i = 0; i < expected.size(); ++i)
+         {
+            EXPECT_EQ(actual[i].timestamp, expected[i].timestamp) << alias;
+            EXPECT_EQ(actual[i].value, expected[i].value) << alias;
+         }
+      }
+
+      // одна аллокация точного размера
+      const auto &bus = std::static_pointer_cast<vcd::BusPinDescription>(h.GetPinByAlias("-"))->GetTimeline();
+      EXPECT_EQ(bus.capacity(), bus.size());
+   }
+}
+
+TEST(VcdReaderNew, ConcurrentQueries)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   auto h = std::make_shared<vcd::Handle>();
+   h->Init(fPath);
+   h->LoadHdr();
+   h->LoadSignalsParallel();
+
+   /* эталон одним потоком; GetSubPins() намеренно не трогаем до гонки */
+   std::vector<std::string> aliases;
+   for (const auto &[alias, pin] : h->GetAlias2pinMap())
+      aliases.emplace_back(alias);
+
+   constexpr std::uint64_t kStep = 2500;
+   std::vector<std::vector<std::string>> expected(aliases.size());
+   for (std::size_t a = 0; a < aliases.size(); ++a)
+   {
+      for (std::uint64_t ts = 0; ts <= h->GetMaxTs(); ts += kStep)
+         expected[a].emplace_back(h->GetValueBus(ts, aliases[a]));
+   }
+
+   constexpr unsigned kThreads = 8;
+   std::atomic<unsigned> mismatches{0};
+   std::vector<std::thread> threads;
+   for (unsigned t = 0; t < kThreads; ++t)
+   {
+      threads.emplace_back([&, t]
+                           {
+         for (int round = 0; round < 20; ++round)
+         {
+            for (std::size_t a = (t + round) % aliases.size(), n = 0; n < aliases.size(); a = (a + 1) % aliases.size(), ++n)
+            {
+               const auto pin = h->GetPinByAlias(aliases[a]);
+               if (pin->GetSignalType() == vcd::SignalType::bus && pin->GetPinType() != vcd::PinType::parameter)
+               {
+                  const auto bus = std::static_pointer_cast<vcd::BusPinDescription>(pin);
+                  for (const auto &bit : bus->GetSubPins())
+                     (void)bit->GetValueBus(h->GetMaxTs() / 2);
+               }
+
+               std::vector<std::string_view> views;
+               for (std::uint64_t ts = 0; ts <= h->GetMaxTs(); ts += kStep)
+                  views.push_back(h->GetValueBus(ts, aliases[a]));
+
+               /* view должны пережить последующие вызовы */
+               for (std::size_t i = 0; i < views.size(); ++i)
+               {
+                  if (views[i] != expected[a][i])
+                     ++mismatches;
+               }
+            }
+         } });
+   }
+   for (auto &th : threads)
+      th.join();
+
+   EXPECT_EQ(mismatches.load(), 0u);
+   const auto bus = std::static_pointer_cast<vcd::BusPinDescription>(h->GetPinByAlias("-"));
+   EXPECT_EQ(bus->GetSubPins().size(), 5u);
+}
+
+TEST(VcdReaderNew, ChangeIndex)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   for (bool pipelined : {false, true})
+   {
+      vcd::Handle h;
+      h.Init(fPath);
+      h.LoadHdr();
+      h.SetBuildChangeIndex(true);
+      if (pipelined)
+      {
+         h.SetReadBlockSize(64);
+         h.LoadSignalsPipelined();
+      }
+      else
+      {
+         h.LoadSignalsParallel();
+      }
+      const vcd::ChangeIndex *idx = h.GetChangeIndex();
+      ASSERT_NE(idx, nullptr);
+
+      /* эталон: все изменения всех пинов, по (ts, id) */
+      std::vector<std::tuple<std::uint64_t, std::uint32_t, std::uint32_t>> all;
+      for (const auto &[alias, pin] : h.GetAlias2pinMap())
+      {
+         if (pin->GetPinType() == vcd::PinType::parameter)
+            continue;
+         const auto tl = TimelineOf(pin);
+         for (std::size_t i = 0; i < tl.size(); ++i)
+            all.emplace_back(tl[i].timestamp, pin->GetId(), static_cast<std::uint32_t>(i));
+      }
+      std::sort(all.begin(), all.end());
+      ASSERT_EQ(idx->GetRecordCount(), all.size());
+
+      const std::uint64_t t0 = h.GetMaxTs() / 4, t1 = h.GetMaxTs() / 2;
+      const auto [b, e] = idx->Window(t0, t1);
+      std::vector<std::tuple<std::uint64_t, std::uint32_t, std::uint32_t>> got;
+      for (auto *r = b; r != e; ++r)
+         got.emplace_back(idx->TimestampOf(r), r->pinId, r->change);
+      std::vector<std::tuple<std::uint64_t, std::uint32_t, std::uint32_t>> expected;
+      for (const auto &c : all)
+      {
+         if (std::get<0>(c) >= t0 && std::get<0>(c) <= t1)
+            expected.push_back(c);
+      }
+      EXPECT_EQ(got, expected);
+
+      /* соседние события одного сигнала */
+      const auto pin = h.GetPinByAlias("!");
+      ASSERT_EQ(h.GetPinById(pin->GetId()), pin);
+      std::vector<std::uint8_t> mask(h.GetAlias2pinMap().size(), 0);
+      mask[pin->GetId()] = 1;
+      const auto tl = TimelineOf(pin);
+      ASSERT_GE(tl.size(), 2u);
+      EXPECT_EQ(idx->NextEvent(tl[0].timestamp, &mask), tl[1].timestamp);
+      EXPECT_EQ(idx->PrevEvent(tl[1].timestamp, &mask), tl[0].timestamp);
+      EXPECT_EQ(idx->NextEvent(tl.back().timestamp, &mask), std::nullopt);
+      EXPECT_EQ(idx->PrevEvent(tl[0].timestamp, &mask), std::nullopt);
+   }
+
+   /* редкий сигнал на фоне частого клока: дальше бюджета прохода по журналу */
+   const std::uint64_t n = 3 * vcd::ChangeIndex::kScanRecords;
+   std::vector<vcd::PinValue> clk, slow = {{5, "1"}, {n - 5, "0"}};
+   for (std::uint64_t ts = 1; ts <= n; ++ts)
+      clk.push_back({ts, ts % 2 ? "1" : "0"});
+   const auto sparse = vcd::ChangeIndex::Build({&clk, &slow}, {n / 2});
+   const std::vector<std::uint8_t> slowMask = {0, 1};
+   EXPECT_EQ(sparse.NextEvent(5, &slowMask), n - 5);
+   EXPECT_EQ(sparse.PrevEvent(n - 5, &slowMask), 5u);
+   EXPECT_EQ(sparse.PrevEvent(n, &slowMask), n - 5);
+   EXPECT_EQ(sparse.NextEvent(n - 5, &slowMask), std::nullopt);
+   EXPECT_EQ(sparse.PrevEvent(5, &slowMask), std::nullopt);
+   EXPECT_EQ(sparse.NextEvent(5), 6u);
+   EXPECT_EQ(sparse.PrevEvent(5), 4u);
+}
+
+TEST(VcdReaderNew, RangeStats)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   vcd::Handle indexed;
+   indexed.Init(fPath);
+   indexed.LoadHdr();
+   indexed.SetBuildStatsIndex(true);
+   indexed.LoadSignalsParallel();
+   ASSERT_NE(indexed.GetStatsIndex(), nullptr);
+
+   vcd::Handle plain;
+   plain.Init(fPath);
+   plain.LoadHdr();
+   plain.LoadSignalsParallel();
+   EXPECT_EQ(plain.GetStatsIndex(), nullptr);
+
+   const std::uint64_t maxTs = indexed.GetMaxTs();
+   const std::vector<std::pair<std::uint64_t, std::uint64_t>> windows = {
+       {0, maxTs}, {maxTs / 3, maxTs / 2}, {maxTs / 4, maxTs / 4}, {1, maxTs + 100}};
+
+   for (const auto &[alias, pin] : indexed.GetAlias2pinMap())
+   {
+      for (const auto &[t0, t1] : windows)
+      {
+         const vcd::SignalStats a = indexed.RangeStats(alias, t0, t1);
+         const vcd::SignalStats b = plain.RangeStats(alias, t0, t1);
+         EXPECT_EQ(a.toggles, b.toggles) << alias;
+         EXPECT_EQ(a.timeHigh, b.timeHigh) << alias;
+         EXPECT_EQ(a.timeLow + a.timeHigh + a.timeX + a.timeZ, t1 - t0) << alias;
+
+         if (pin->GetSignalType() != vcd::SignalType::simple || pin->GetPinType() == vcd::PinType::parameter)
+            continue;
+
+         /* эталон: линейный проход по шкале */
+         std::uint64_t high = 0, toggles = 0, rises = 0;
+         char prev = pin->GetValueChar(t0 ? t0 - 1 : 0);
+         if (t0 == 0)
+            prev = pin->GetInitState()[0];
+         std::uint64_t from = t0;
+         for (const auto &v : TimelineOf(pin))
+         {
+            if (v.timestamp < t0 || v.timestamp > t1)
+               continue;
+            if (prev == '1')
+               high += v.timestamp - from;
+            const char cur = v.value.front();
+            toggles += cur != prev;
+            rises += prev == '0' && cur == '1';
+            prev = cur;
+            from = v.timestamp;
+         }
+         if (prev == '1')
+            high += t1 - from;
+         EXPECT_EQ(a.timeHigh, high) << alias << " [" << t0 << ", " << t1 << "]";
+         EXPECT_EQ(a.toggles, toggles) << alias;
+         EXPECT_EQ(a.rises, rises) << alias;
+      }
+   }
+
+   /* бит шины считается по своему символу, а не по всей строке */
+   for (const auto &[alias, pin] : indexed.GetAlias2pinMap())
+   {
+      if (pin->GetSignalType() != vcd::SignalType::bus || pin->GetPinType() == vcd::PinType::parameter)
+         continue;
+      const auto &bus = static_cast<const vcd::BusPinDescription &>(*pin);
+      const auto &bits = bus.GetSubPins();
+      for (std::size_t b = 0; b < bits.size(); ++b)
+      {
+         std::uint64_t high = 0, toggles = 0, from = 0;
+         char prev = bus.GetInitState()[0];
+         for (const auto &v : bus.GetTimeline())
+         {
+            const char cur = bus.GetValueChar(v.timestamp, b);
+            EXPECT_EQ(bits[b]->GetValueChar(v.timestamp), cur) << alias << "[" << b << "]"; // свой бит без аргумента
+            if (prev == '1')
+               high += v.timestamp - from;
+            toggles += cur != prev;
+            prev = cur;
+            from = v.timestamp;
+         }
+         if (prev == '1')
+            high += maxTs - from;
+
+         for (const vcd::Handle *h : {&indexed, &plain})
+         {
+            const auto &pinBits = static_cast<const vcd::BusPinDescription &>(*h->GetPinByAlias(alias)).GetSubPins();
+            for (int repeat = 0; repeat < 2; ++repeat) // второй раз — из кеша
+            {
+               const vcd::SignalStats s = h->RangeStats(*pinBits[b], 0, maxTs);
+               EXPECT_EQ(s.timeHigh, high) << alias << "[" << b << "]";
+               EXPECT_EQ(s.toggles, toggles) << alias << "[" << b << "]";
+            }
+         }
+      }
+   }
+
+   /* без начального состояния — X, а не low; "0" -> "0000" той же шины — не переключение */
+   const std::vector<vcd::PinValue> noInit = {{10, "1"}};
+   const std::vector<vcd::PinValue> widths = {{10, "0000"}, {20, "01"}, {25, "1"}};
+   const auto idx = vcd::StatsIndex::Build({{&noInit, ""}, {&widths, "0"}}, 1);
+   const vcd::SignalStats a = idx.Query(0, 0, 30);
+   EXPECT_EQ(a.timeX, 10u);
+   EXPECT_EQ(a.timeLow, 0u);
+   EXPECT_EQ(a.timeHigh, 20u);
+   const vcd::SignalStats b = idx.Query(1, 0, 30);
+   EXPECT_EQ(b.toggles, 1u);
+   EXPECT_EQ(b.rises, 1u);
+}
+
+TEST(VcdReaderNew, Report)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   vcd::Handle h;
+   h.Init(fPath);
+   h.LoadHdr();
+   h.SetBuildStatsIndex(true);
+   h.LoadSignalsParallel();
+
+   const std::uint64_t maxTs = h.GetMaxTs();
+   vcd::ReportOptions opt;
+   opt.windows = {{0, maxTs}, {maxTs / 2, maxTs}};
+   opt.threads = 4;
+   std::atomic<std::size_t> lastDone{0};
+   opt.progress = [&](std::size_t done, std::size_t total)
+   {
+      EXPECT_LE(done, total);
+      std::size_t prev = lastDone;
+      while (done > prev && !lastDone.compare_exchange_weak(prev, done))
+      {
+      }
+   };
+   const vcd::Report rep = vcd::BuildReport(h, opt);
+
+   ASSERT_FALSE(rep.modules.empty());
+   EXPECT_EQ(lastDone.load(), rep.modules.size());
+   EXPECT_EQ(rep.modules.front().parent, SIZE_MAX);
+
+   /* строки сигналов сходятся с суммами модулей и с RangeStats */
+   std::vector<std::uint64_t> sum(opt.windows.size(), 0);
+   for (const auto &row : rep.signals)
+   {
+      for (std::size_t w = 0; w < opt.windows.size(); ++w)
+      {
+         sum[w] += row.stats[w].toggles;
+         EXPECT_EQ(row.stats[w].toggles, h.RangeStats(*row.pin, opt.windows[w].t0, opt.windows[w].t1).toggles)
+             << rep.SignalPath(row);
+      }
+   }
+   for (std::size_t w = 0; w < opt.windows.size(); ++w)
+   {
+      EXPECT_EQ(sum[w], rep.totalToggles[w]);
+      EXPECT_EQ(rep.modules.front().subtreeToggles[w], rep.totalToggles[w]);
+   }
+   EXPECT_GT(rep.totalToggles[0], rep.totalToggles[1]);
+
+   /* результат не зависит от числа потоков */
+   vcd::ReportOptions serialOpt;
+   serialOpt.windows = opt.windows;
+   serialOpt.threads = 1;
+   const vcd::Report serial = vcd::BuildReport(h, serialOpt);
+   ASSERT_EQ(serial.modules.size(), rep.modules.size());
+   for (std::size_t i = 0; i < rep.modules.size(); ++i)
+   {
+      EXPECT_EQ(serial.modules[i].path, rep.modules[i].path);
+      EXPECT_EQ(serial.modules[i].subtreeToggles, rep.modules[i].subtreeToggles);
+   }
+
+   /* без индекса статистики — то же; модули приходят по мере готовности */
+   vcd::Handle plain;
+   plain.Init(fPath);
+   plain.LoadHdr();
+   plain.LoadSignalsParallel();
+   std::mutex readyMutex;
+   std::vector<std::vector<std::uint64_t>> ready(rep.modules.size());
+   std::size_t readyRows = 0;
+   vcd::ReportOptions plainOpt = serialOpt;
+   plainOpt.threads = 4;
+   plainOpt.moduleReady = [&](std::size_t i, const vcd::ModuleReport &m, const std::vector<vcd::SignalReport> &rows)
+   {
+      std::lock_guard<std::mutex> lock(readyMutex);
+      ready[i] = m.toggles;
+      readyRows += rows.size();
+   };
+   const vcd::Report unindexed = vcd::BuildReport(plain, plainOpt);
+   ASSERT_EQ(unindexed.modules.size(), rep.modules.size());
+   EXPECT_EQ(readyRows, unindexed.signals.size());
+   for (std::size_t i = 0; i < rep.modules.size(); ++i)
+   {
+      EXPECT_EQ(unindexed.modules[i].subtreeToggles, rep.modules[i].subtreeToggles) << rep.modules[i].path;
+      EXPECT_EQ(ready[i], unindexed.modules[i].toggles) << rep.modules[i].path;
+   }
+}
+
+TEST(VcdReaderNew, WriteVcdRoundTrip)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+   const std::filesystem::path out = std::filesystem::temp_directory_path() / "vcd_writer_test.vcd";
+
+   vcd::Handle src;
+   src.Init(fPath);
+   src.LoadHdr();
+   src.LoadSignalsParallel();
+
+   auto reload = [&]
+   {
+      auto h = std::make_unique<vcd::Handle>();
+      h->Init(out);
+      h->LoadHdr();
+      h->LoadSignalsParallel();
+      return h;
+   };
+
+   /* весь файл */
+   const vcd::WriteResult full = vcd::WriteVcd(src, out);
+   EXPECT_EQ(full.signals, src.GetAlias2pinMap().size());
+   EXPECT_EQ(full.bytes, std::filesystem::file_size(out));
+   {
+      const auto copy = reload();
+      EXPECT_EQ(copy->GetMaxTs(), src.GetMaxTs());
+      for (const auto &[alias, pin] : src.GetAlias2pinMap())
+      {
+         for (std::uint64_t ts = 0; ts <= src.GetMaxTs(); ts += 1000)
+            EXPECT_EQ(copy->GetValueBus(ts, alias), src.GetValueBus(ts, alias)) << alias << " @" << ts;
+      }
+   }
+
+   /* поддерево dut + один сигнал верхнего уровня, окно */
+   vcd::WriteOptions opt;
+   opt.t0 = 120000;
+   opt.t1 = 330000;
+   opt.scopes = {src.GetRootModule()->subModules().front()};
+   opt.signals = {src.GetPinByAlias("\"")};
+   const vcd::WriteResult part = vcd::WriteVcd(src, out, opt);
+   {
+      const auto copy = reload();
+      EXPECT_EQ(copy->GetAlias2pinMap().size(), part.signals);
+      EXPECT_EQ(copy->GetMaxTs(), opt.t1);
+      EXPECT_NE(copy->GetPinByAlias("\""), nullptr);
+      EXPECT_NE(copy->GetPinByAlias("#"), nullptr);
+      for (const auto &[alias, pin] : copy->GetAlias2pinMap())
+      {
+         /* $dumpvars прочитан заголовком: значения в t0 — начальные состояния */
+         EXPECT_EQ(pin->GetInitState(), src.GetValueBus(opt.t0, alias)) << alias;
+         for (std::uint64_t ts = opt.t0; ts <= opt.t1; ts += 1000)
+            EXPECT_EQ(copy->GetValueBus(ts, alias), src.GetValueBus(ts, alias)) << alias << " @" << ts;
+      }
+   }
+
+   /* x/z без изменений и окно до первого изменения: начальные состояния, а не '0' */
+   const std::filesystem::path xz = std::filesystem::temp_directory_path() / "vcd_writer_xz.vcd";
+   std::ofstream(xz, std::ios::binary) << "$timescale 1ns $end\n"
+                                          "$scope module top $end\n"
+                                          "$var wire 1 ! a $end\n"
+                                          "$var wire 1 # b $end\n"
+                                          "$var wire 1 \" c $end\n"
+                                          "$upscope $end\n"
+                                          "$enddefinitions $end\n"
+                                          "#0\n"
+                                          "$dumpvars\n"
+                                          "x!\n"
+                                          "z#\n"
+                                          "x\"\n"
+                                          "$end\n"
+                                          "#30\n"
+                                          "1\"\n";
+   vcd::Handle xzSrc;
+   xzSrc.Init(xz);
+   xzSrc.LoadHdr();
+   xzSrc.LoadSignalsParallel();
+   vcd::WriteOptions xzOpt;
+   xzOpt.t0 = 5;
+   xzOpt.t1 = 20;
+   vcd::WriteVcd(xzSrc, out, xzOpt);
+   {
+      const auto copy = reload();
+      EXPECT_EQ(copy->GetPinByAlias("!")->GetInitState(), "x");
+      EXPECT_EQ(copy->GetPinByAlias("#")->GetInitState(), "z");
+      EXPECT_EQ(copy->GetPinByAlias("\"")->GetInitState(), "x");
+      EXPECT_EQ(copy->GetValueChar(10, "!"), xzSrc.GetValueChar(10, "!"));
+   }
+   std::filesystem::remove(xz);
+   std::filesystem::remove(out);
+}
+
+TEST(VcdReaderNew, MemoryUsage)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   vcd::Handle h;
+   h.Init(fPath);
+   h.LoadHdr();
+   h.SetBuildChangeIndex(true);
+   h.SetBuildStatsIndex(true);
+   h.LoadSignalsParallel();
+
+   const vcd::MemoryBreakdown m = h.MemoryUsage(3);
+   std::cout << m;
+
+   EXPECT_EQ(m.rawBuffer, 0u);
+   EXPECT_GT(m.hierarchy, 0u);
+   EXPECT_EQ(m.changeIndex, h.GetChangeIndex()->GetBytes());
+   EXPECT_GT(m.statsIndex, 0u);
+
+   std::size_t simple = 0, bus = 0;
+   for (const auto &[alias, pin] : h.GetAlias2pinMap())
+   {
+      if (pin->GetPinType() == vcd::PinType::parameter)
+         continue;
+      const bool isSimple = pin->GetSignalType() == vcd::SignalType::simple;
+      const std::size_t cap = isSimple ? std::static_pointer_cast<vcd::SimplePinDescription>(pin)->GetTimeline().capacity()
+                                       : std::static_pointer_cast<vcd::BusPinDescription>(pin)->GetTimeline().capacity();
+      (isSimple ? simple : bus) += cap * sizeof(vcd::PinValue);
+   }
+   EXPECT_EQ(m.simpleTimelines, simple);
+   EXPECT_EQ(m.busTimelines, bus);
+   EXPECT_EQ(m.Total(), m.simpleTimelines + m.busTimelines + m.valuePools + m.hierarchy + m.changeIndex + m.statsIndex);
+
+   ASSERT_EQ(m.largest.size(), 3u);
+   for (std::size_t i = 1; i < m.largest.size(); ++i)
+      EXPECT_GE(m.largest[i - 1].bytes, m.largest[i].bytes);
+   EXPECT_GE(m.largest.front().bytes, m.largest.front().changes * sizeof(vcd::PinValue));
+}
+
+TEST(VcdReaderNew, LoadStats)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   for (int mode = 0; mode < 3; ++mode)
+   {
+      vcd::Handle h;
+      h.Init(fPath);
+      h.LoadHdr();
+      h.SetBuildChangeIndex(true);
+      if (mode == 0)
+         h.LoadSignals();
+      else if (mode == 1)
+         h.LoadSignalsParallel();
+      else
+         h.LoadSignalsPipelined();
+
+      const vcd::LoadStats &st = h.GetLoadStats();
+      EXPECT_EQ(st.loader, std::vector<std::string_view>({"serial", "parallel", "pipelined"})[mode]);
+      EXPECT_EQ(st.bytes, std::filesystem::file_size(fPath));
+      EXPECT_EQ(st.changes, h.GetChangeIndex()->GetRecordCount());
+      EXPECT_EQ(st.threadParseMs.size(), st.threads);
+      EXPECT_GE(st.Imbalance(), 1.0);
+      EXPECT_GT(st.bodyMs, 0.0);
+      EXPECT_GE(st.totalMs, st.bodyMs + st.loadHdrMs);
+      EXPECT_GE(st.bodyMs, st.compactMs + st.indexMs);
+      EXPECT_GT(st.BytesPerSecond(), 0.0);
+   }
+}
+
+TEST(VcdReaderNew, TraceJson)
+{
+   vcd::trace::Clear();
+   const std::uint64_t t0 = vcd::trace::NowNs();
+   std::thread other([&]
+                     {
+      vcd::trace::SetThreadName("test worker");
+      vcd::trace::Record("worker", t0, t0 + 2500); });
+   other.join();
+   vcd::trace::Record("main", t0, t0 + 1000);
+
+   const std::filesystem::path out = std::filesystem::temp_directory_path() / "vcd_trace_test.json";
+   EXPECT_EQ(vcd::trace::WriteJson(out), 2u);
+
+   std::ifstream in(out);
+   const std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+   EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+   EXPECT_NE(json.find("\"args\":{\"name\":\"test worker\"}"), std::string::npos);
+   EXPECT_NE(json.find("\"name\":\"worker\",\"cat\":\"vcd\",\"ph\":\"X\""), std::string::npos);
+   EXPECT_NE(json.find("\"dur\":2.5}"), std::string::npos);
+   EXPECT_NE(json.find("\"dur\":1.0}"), std::string::npos);
+
+   /* разные потоки — разные дорожки */
+   auto tidOf = [&](std::string_view name)
+   {
+      const auto at = json.find("\"name\":\"" + std::string(name) + "\",\"cat\"");
+      const auto tid = json.find("\"tid\":", at) + 6;
+      return json.substr(tid, json.find(',', tid) - tid);
+   };
+   EXPECT_NE(tidOf("worker"), tidOf("main"));
+
+   vcd::trace::Clear();
+   EXPECT_EQ(vcd::trace::WriteJson(out), 0u);
+   std::filesystem::remove(out);
+}
+
+TEST(VcdReaderNew, PhaseCounters)
+{
+   const std::filesystem::path fPath = std::filesystem::path(VCD_TEST_FILES_DIR) / "majorityof5.hier.vcd";
+
+   for (int mode = 0; mode < 3; ++mode)
+   {
+      vcd::Handle h;
+      h.SetCollectCounters(true);
+      h.SetMaxThreads(2);
+      h.Init(fPath);
+      h.LoadHdr();
+      h.SetBuildStatsIndex(true);
+      if (mode == 0)
+         h.LoadSignals();
+      else if (mode == 1)
+         h.LoadSignalsParallel();
+      else
+         h.LoadSignalsPipelined();
+
+      const vcd::LoadStats &st = h.GetLoadStats();
+      std::set<std::string_view> phases;
+      std::size_t parseThreads = 0;
+      for (const auto &pc : st.counters)
+      {
+         phases.insert(pc.phase);
+         parseThreads += pc.phase == "parse";
+         /* perf_event_open может быть запрещён — тогда только программные */
+         EXPECT_EQ(pc.values.cycles.has_value(), pc.values.instructions.has_value());
+      }
+      EXPECT_EQ(parseThreads, st.threads);
+      for (std::string_view phase : {"init", "loadHdr", "read", "parse", "index"})
+         EXPECT_TRUE(phases.count(phase)) << phase << " in mode " << mode;
+      EXPECT_EQ(phases.count("compact") != 0, mode != 2); // конвейер пишет сразу в пулы
+      EXPECT_GT(st.PhaseTotal("parse").cpuTimeNs, 0u);
+   }
+
+   vcd::Handle off;
+   off.Init(fPath);
+   off.LoadHdr();
+   off.LoadSignals();
+   EXPECT_TRUE(off.GetLoadStats().counters.empty());
+}
+
+namespace
+{
+   /* сравнение всех временных шкал и служебных интервалов двух загрузок */
+   void
+   ExpectSameTimelines(const vcd::Handle &expected, const vcd::Handle &actual)
+   {
+      EXPECT_EQ(actual.GetMaxTs(), expected.GetMaxTs());
+      EXPECT_EQ(actual.GetDumpoffIntervals(), expected.GetDumpoffIntervals());
+      for (const auto &[alias, pin] : expected.GetAlias2pinMap())
+      {
+         if (pin->GetPinType() == vcd::PinType::parameter)
+            continue;
+         const auto other = actual.GetPinByAlias(alias);
+         ASSERT_TRUE(other) << alias;
+         const auto a = TimelineOf(pin);
+         const auto b = TimelineOf(other);
+         ASSERT_EQ(b.size(), a.size()) << alias;
+         for (std::size_t i = 0; i < a.size(); ++i)
+         {
+            ASSERT_EQ(b[i].timestamp, a[i].timestamp) << alias;
+            ASSERT_EQ(b[i].value, a[i].value) << alias;
+         }
+      }
+   }
+
+   void
+   CheckGeneratedCorpus(const vcd::GenOptions &opt, const std::string &name)
+   {
+      const std::filesystem::path fPath = std::filesystem::temp_directory_path() / name;
+      const vcd::GenResult res = vcd::GenerateVcd(fPath, opt);
+      EXPECT_GE(res.bytes, opt.targetBytes);
+      EXPECT_EQ(res.bytes, std::filesystem::file_size(fPath));
+
+      vcd::Handle serial;
+      serial.Init(fPath);
+      serial.LoadHdr();
+      serial.LoadSignals();
+      EXPECT_EQ(serial.GetAlias2pinMap().size(), opt.signals);
+      EXPECT_EQ(serial.GetMaxTs(), res.maxTs);
+      EXPECT_EQ(serial.GetDumpoffIntervals().size(), res.dumpoffBlocks);
+      EXPECT_EQ(serial.GetLoadStats().changes, res.changes); // $dumpvars — начальные состояния
+
+      for (unsigned threads : {1u, 3u, 8u})
+      {
+         SCOPED_TRACE("threads=" + std::to_string(threads));
+         vcd::Handle parallel;
+         parallel.Init(fPath);
+         parallel.LoadHdr();
+         parallel.SetMaxThreads(threads);
+         parallel.LoadSignalsParallel();
+         ExpectSameTimelines(serial, parallel);
+      }
+
+      vcd::Handle pipelined;
+      pipelined.Init(fPath);
+      pipelined.LoadHdr();
+      pipelined.SetReadBlockSize(4096);
+      pipelined.LoadSignalsPipelined();
+      ExpectSameTimelines(serial, pipelined);
+
+      std::filesystem::remove(fPath);
+   }
+} // namespace
+
+TEST(VcdReaderNew, GeneratorIsDeterministic)
+{
+   vcd::GenOptions opt;
+   opt.targetBytes = 64 * 1024;
+   opt.signals = 200;
+   opt.dumpoffEvery = 20;
+
+   std::ostringstream a, b, c;
+   vcd::GenerateVcd(a, opt);
+   vcd::GenerateVcd(b, opt);
+   opt.seed = 2;
+   vcd::GenerateVcd(c, opt);
+   EXPECT_EQ(a.str(), b.str());
+   EXPECT_NE(a.str(), c.str());
+
+   opt.crlf = true;
+   std::ostringstream crlf;
+   vcd::GenerateVcd(crlf, opt);
+   EXPECT_NE(crlf.str().find("\r\n$dumpoff\r\n"), std::string::npos);
+}
+
+TEST(VcdReaderNew, GeneratedCorpusSerialMatchesParallel)
+{
+   for (bool crlf : {false, true})
+   {
+      SCOPED_TRACE(crlf ? "CRLF" : "LF");
+      vcd::GenOptions opt;
+      opt.seed = 7;
+      opt.targetBytes = 512 * 1024;
+      opt.signals = 300;
+      opt.depth = 4;
+      opt.fanout = 3;
+      opt.busFraction = 0.3;
+      opt.xzDensity = 0.05;
+      opt.crlf = crlf;
+      opt.dumpoffEvery = 100;
+      CheckGeneratedCorpus(opt, crlf ? "vcdreader-test-crlf.vcd" : "vcdreader-test-lf.vcd");
+   }
+}
+
+/* запуск: --gtest_also_run_disabled_tests --gtest_filter=*LargeGenerated* */
+TEST(VcdReaderNew, DISABLED_LargeGeneratedCorpus)
+{
+   vcd::GenOptions opt;
+   opt.targetBytes = 512u << 20;
+   opt.signals = 20000;
+   opt.dumpoffEvery = 10000;
+   CheckGeneratedCorpus(opt, "vcdreader-test-large.vcd");
+}
+
 int main(int argc, char **argv)
 {
    ::testing::InitGoogleTest(&argc, argv);
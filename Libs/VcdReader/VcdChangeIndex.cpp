@@ -0,0 +1,216 @@
+#include "Include/VcdChangeIndex.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace vcd
+{
+   /*
+    * Каждый поток собирает записи своего временного диапазона
+    * [splits[p-1], splits[p]) двоичным поиском по всем шкалам и сортирует
+    * их локально; диапазоны не пересекаются, поэтому результат — простая
+    * конкатенация в порядке диапазонов.
+    */
+   ChangeIndex
+   ChangeIndex::Build(const std::vector<const std::vector<PinValue> *> &timelineById,
+                      std::vector<std::uint64_t> splits)
+   {
+      struct Entry
+      {
+         std::uint64_t ts;
+         Record rec;
+      };
+
+      /* Record — два uint32: проверяем до потоков, чтобы не обрезать молча */
+      constexpr std::uint64_t kMaxField = std::numeric_limits<std::uint32_t>::max();
+      if (timelineById.size() > kMaxField)
+         throw std::length_error("ChangeIndex: too many pins (" + std::to_string(timelineById.size()) + ")");
+      for (std::size_t id = 0; id < timelineById.size(); ++id)
+      {
+         if (timelineById[id] && timelineById[id]->size() > kMaxField)
+            throw std::length_error("ChangeIndex: pin " + std::to_string(id) + " has " +
+                                    std::to_string(timelineById[id]->size()) + " changes, more than 2^32-1");
+      }
+
+      std::sort(splits.begin(), splits.end());
+      splits.erase(std::unique(splits.begin(), splits.end()), splits.end());
+      splits.push_back(std::numeric_limits<std::uint64_t>::max());
+      const std::size_t nParts = splits.size();
+
+      auto byTs = [](const PinValue &v, std::uint64_t t)
+      { return v.timestamp < t; };
+
+      std::vector<std::vector<Entry>> parts(nParts);
+      auto worker = [&](std::size_t p)
+      {
+         const std::uint64_t beg = p ? splits[p - 1] : 0;
+         const std::uint64_t end = splits[p];
+         const bool last = p + 1 == nParts; // последний диапазон включает max()
+         auto &out = parts[p];
+
+         for (std::size_t id = 0; id < timelineById.size(); ++id)
+         {
+            const auto *tl = timelineById[id];
+            if (!tl || tl->empty())
+               continue;
+            auto lo = std::lower_bound(tl->begin(), tl->end(), beg, byTs);
+            auto hi = last ? tl->end() : std::lower_bound(lo, tl->end(), end, byTs);
+            for (auto it = lo; it != hi; ++it)
+            {
+               out.push_back({it->timestamp,
+                              {static_cast<std::uint32_t>(id),
+                               static_cast<std::uint32_t>(it - tl->begin())}});
+            }
+         }
+         std::sort(out.begin(), out.end(), [](const Entry &a, const Entry &b)
+                   { return a.ts != b.ts ? a.ts < b.ts : a.rec.pinId < b.rec.pinId; });
+      };
+
+      std::vector<std::thread> workers;
+      for (std::size_t p = 1; p < nParts; ++p)
+         workers.emplace_back(worker, p);
+      worker(0);
+      for (auto &t : workers)
+         t.join();
+
+      ChangeIndex idx;
+      std::size_t total = 0;
+      for (const auto &part : parts)
+         total += part.size();
+      idx.m_records.reserve(total);
+
+      for (const auto &part : parts)
+      {
+         for (const Entry &e : part)
+         {
+            if (idx.m_times.empty() || idx.m_times.back() != e.ts)
+            {
+               idx.m_times.push_back(e.ts);
+               idx.m_offsets.push_back(idx.m_records.size());
+            }
+            idx.m_records.push_back(e.rec);
+         }
+      }
+      idx.m_offsets.push_back(idx.m_records.size());
+      idx.m_timelines = timelineById;
+      idx.m_times.shrink_to_fit();
+      idx.m_offsets.shrink_to_fit();
+      return idx;
+   }
+
+   ChangeIndex::Range
+   ChangeIndex::At(std::uint64_t ts) const
+   {
+      auto it = std::lower_bound(m_times.begin(), m_times.end(), ts);
+      if (it == m_times.end() || *it != ts)
+         return {nullptr, nullptr};
+      const std::size_t i = static_cast<std::size_t>(it - m_times.begin());
+      return {m_records.data() + m_offsets[i], m_records.data() + m_offsets[i + 1]};
+   }
+
+   ChangeIndex::Range
+   ChangeIndex::Window(std::uint64_t t0, std::uint64_t t1) const
+   {
+      if (t1 < t0 || m_records.empty())
+         return {nullptr, nullptr};
+      const auto b = std::lower_bound(m_times.begin(), m_times.end(), t0) - m_times.begin();
+      const auto e = std::upper_bound(m_times.begin(), m_times.end(), t1) - m_times.begin();
+      return {m_records.data() + m_offsets[b], m_records.data() + m_offsets[e]};
+   }
+
+   std::uint64_t
+   ChangeIndex::TimestampOf(const Record *r) const
+   {
+      const auto pos = static_cast<std::uint64_t>(r - m_records.data());
+      const auto it = std::upper_bound(m_offsets.begin(), m_offsets.end(), pos);
+      return m_times[static_cast<std::size_t>(it - m_offsets.begin()) - 1];
+   }
+
+   /*
+    * Маска: сначала короткий проход по журналу (плотные сигналы находятся
+    * за несколько записей), затем двоичный поиск по шкале каждого пина из
+    * маски — редкий сигнал на фоне частого клока не тянет за собой весь
+    * хвост журнала.
+    */
+   std::optional<std::uint64_t>
+   ChangeIndex::NextEvent(std::uint64_t ts, const std::vector<std::uint8_t> *pinMask) const
+   {
+      auto i = static_cast<std::size_t>(std::upper_bound(m_times.begin(), m_times.end(), ts) - m_times.begin());
+      if (i == m_times.size())
+         return std::nullopt;
+      if (!pinMask)
+         return m_times[i];
+
+      for (const std::uint64_t stop = m_offsets[i] + kScanRecords; i < m_times.size() && m_offsets[i] < stop; ++i)
+      {
+         if (Matches(i, *pinMask))
+            return m_times[i];
+      }
+      if (i == m_times.size())
+         return std::nullopt;
+
+      std::optional<std::uint64_t> best;
+      ForEachMasked(*pinMask, [&](const std::vector<PinValue> &tl)
+                    {
+         const auto it = std::upper_bound(tl.begin(), tl.end(), ts, [](std::uint64_t t, const PinValue &v)
+                                          { return t < v.timestamp; });
+         if (it != tl.end() && (!best || it->timestamp < *best))
+            best = it->timestamp; });
+      return best;
+   }
+
+   std::optional<std::uint64_t>
+   ChangeIndex::PrevEvent(std::uint64_t ts, const std::vector<std::uint8_t> *pinMask) const
+   {
+      auto i = static_cast<std::size_t>(std::lower_bound(m_times.begin(), m_times.end(), ts) - m_times.begin());
+      if (i == 0)
+         return std::nullopt;
+      if (!pinMask)
+         return m_times[i - 1];
+
+      for (const std::uint64_t stop = m_offsets[i] - std::min<std::uint64_t>(m_offsets[i], kScanRecords);
+           i > 0 && m_offsets[i] > stop; --i)
+      {
+         if (Matches(i - 1, *pinMask))
+            return m_times[i - 1];
+      }
+      if (i == 0)
+         return std::nullopt;
+
+      std::optional<std::uint64_t> best;
+      ForEachMasked(*pinMask, [&](const std::vector<PinValue> &tl)
+                    {
+         const auto it = std::lower_bound(tl.begin(), tl.end(), ts, [](const PinValue &v, std::uint64_t t)
+                                          { return v.timestamp < t; });
+         if (it != tl.begin() && (!best || std::prev(it)->timestamp > *best))
+            best = std::prev(it)->timestamp; });
+      return best;
+   }
+
+   bool
+   ChangeIndex::Matches(std::size_t timeIdx, const std::vector<std::uint8_t> &pinMask) const
+   {
+      for (std::uint64_t r = m_offsets[timeIdx]; r < m_offsets[timeIdx + 1]; ++r)
+      {
+         const auto id = m_records[r].pinId;
+         if (id < pinMask.size() && pinMask[id])
+            return true;
+      }
+      return false;
+   }
+
+   template <typename Fn>
+   void
+   ChangeIndex::ForEachMasked(const std::vector<std::uint8_t> &pinMask, Fn &&fn) const
+   {
+      const std::size_t n = std::min(pinMask.size(), m_timelines.size());
+      for (std::size_t id = 0; id < n; ++id)
+      {
+         if (pinMask[id] && m_timelines[id])
+            fn(*m_timelines[id]);
+      }
+   }
+} // namespace vcd
@@ -0,0 +1,331 @@
+#include "Include/VcdIndex.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+
+#include "BodyScanner.hpp"
+
+namespace vcd
+{
+   namespace
+   {
+      constexpr char kMagic[8] = {'V', 'C', 'D', 'I', 'D', 'X', '0', '1'};
+
+      std::int64_t
+      FileMtime(const std::filesystem::path &p)
+      {
+         return static_cast<std::int64_t>(
+             std::filesystem::last_write_time(p).time_since_epoch().count());
+      }
+
+      void
+      WriteU64(std::ostream &os, std::uint64_t v)
+      {
+         os.write(reinterpret_cast<const char *>(&v), sizeof(v));
+      }
+
+      void
+      WriteStr(std::ostream &os, std::string_view s)
+      {
+         WriteU64(os, s.size());
+         os.write(s.data(), static_cast<std::streamsize>(s.size()));
+      }
+
+      bool
+      ReadU64(std::istream &is, std::uint64_t &v)
+      {
+         return static_cast<bool>(is.read(reinterpret_cast<char *>(&v), sizeof(v)));
+      }
+
+      /* n записей не короче minBytes каждая помещаются в остаток файла */
+      bool
+      Fits(std::istream &is, std::uint64_t fileBytes, std::uint64_t n, std::uint64_t minBytes)
+      {
+         const std::streamoff pos = is.tellg();
+         if (pos < 0 || static_cast<std::uint64_t>(pos) > fileBytes)
+            return false;
+         return n <= (fileBytes - static_cast<std::uint64_t>(pos)) / minBytes;
+      }
+
+      bool
+      ReadStr(std::istream &is, std::string &s, std::uint64_t fileBytes)
+      {
+         std::uint64_t n = 0;
+         if (!ReadU64(is, n) || n > (1u << 30) || !Fits(is, fileBytes, n, 1))
+            return false;
+         s.resize(n);
+         return static_cast<bool>(is.read(s.data(), static_cast<std::streamsize>(n)));
+      }
+
+      /* "#<digits>" в начале фрагмента */
+      std::uint64_t
+      LeadingTimestamp(std::string_view seg, std::uint64_t fallback)
+      {
+         if (seg.empty() || seg.front() != '#')
+            return fallback;
+         std::uint64_t ts = 0;
+         for (std::size_t i = 1; i < seg.size() && seg[i] >= '0' && seg[i] <= '9'; ++i)
+            ts = ts * 10 + static_cast<std::uint64_t>(seg[i] - '0');
+         return ts;
+      }
+   } // namespace
+
+   /*
+    * Тело читается кусками по ~seekBytes, каждый кусок обрезается по
+    * первой границе "\n#" после seekBytes, поэтому любой фрагмент
+    * начинается со строки метки времени и его начало — точка поиска.
+    */
+   VcdIndex
+   VcdIndex::Build(const std::filesystem::path &vcd, std::uint64_t bodyOffset,
+                   const std::vector<std::pair<std::string, std::string>> &aliasInit,
+                   const Options &opt)
+   {
+      std::ifstream file(vcd, std::ios::binary);
+      if (!file)
+         throw std::system_error(errno, std::generic_category(), "Can't open " + vcd.string());
+
+      VcdIndex idx;
+      idx.m_fileSize = std::filesystem::file_size(vcd);
+      idx.m_mtime = FileMtime(vcd);
+      idx.m_bodyOffset = bodyOffset;
+
+      std::vector<std::string> states;
+      for (const auto &[alias, init] : aliasInit)
+      {
+         idx.m_aliases.push_back(alias);
+         states.push_back(init);
+      }
+      std::unordered_map<std::string_view, std::size_t> aliasPos;
+      for (std::size_t i = 0; i < idx.m_aliases.size(); ++i)
+         aliasPos.emplace(idx.m_aliases[i], i);
+
+      const std::size_t seekBytes = std::max<std::size_t>(opt.seekBytes, 1);
+      const std::size_t cpBytes = std::max(opt.checkpointBytes, seekBytes);
+
+      file.seekg(static_cast<std::streamoff>(bodyOffset));
+      std::string buf;
+      std::vector<char> chunk(seekBytes);
+      std::uint64_t bufOff = bodyOffset;
+      bool eof = false;
+
+      std::uint64_t curTs = 0;
+      bool inDumpoff = false;
+      std::uint64_t dumpoffBegin = 0;
+      std::uint64_t lastCp = 0;
+
+      auto readMore = [&]
+      {
+         file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+         const auto n = static_cast<std::size_t>(file.gcount());
+         buf.append(chunk.data(), n);
+         if (n < chunk.size())
+            eof = true;
+      };
+
+      for (;;)
+      {
+         while (!eof && buf.size() <= seekBytes)
+            readMore();
+         if (buf.empty())
+            break;
+
+         /* граница фрагмента: первое "\n#" не раньше seekBytes */
+         std::size_t cut = std::string::npos;
+         std::size_t from = seekBytes;
+         for (;;)
+         {
+            const std::size_t nl = buf.find("\n#", from - 1);
+            if (nl != std::string::npos)
+            {
+               cut = nl + 1;
+               break;
+            }
+            if (eof)
+               break;
+            from = std::max<std::size_t>(buf.size(), 1);
+            readMore();
+         }
+         if (cut == std::string::npos)
+            cut = buf.size();
+
+         const std::string_view seg(buf.data(), cut);
+         const SeekPoint sp{LeadingTimestamp(seg, curTs), bufOff};
+         idx.m_seek.push_back(sp);
+         if (idx.m_checkpoints.empty() || bufOff - lastCp >= cpBytes)
+         {
+            idx.m_checkpoints.push_back({sp, states, inDumpoff, dumpoffBegin});
+            lastCp = bufOff;
+         }
+
+         detail::ScanBody(
+             seg.data(), seg.data() + seg.size(),
+             [&](std::uint64_t ts)
+             {
+                curTs = ts;
+                idx.m_maxTs = std::max(idx.m_maxTs, ts);
+             },
+             [&](std::string_view val, std::string_view alias)
+             {
+                auto it = aliasPos.find(alias);
+                if (it != aliasPos.end())
+                   states[it->second].assign(val);
+             },
+             [&](std::string_view cmd)
+             {
+                if (cmd == "dumpoff" && !inDumpoff)
+                {
+                   inDumpoff = true;
+                   dumpoffBegin = curTs;
+                }
+                else if (cmd == "dumpon")
+                {
+                   inDumpoff = false;
+                }
+             });
+
+         buf.erase(0, cut);
+         bufOff += cut;
+      }
+
+      if (idx.m_checkpoints.empty())
+         idx.m_checkpoints.push_back({{0, bodyOffset}, states, false, 0});
+      return idx;
+   }
+
+   const VcdIndex::Checkpoint &
+   VcdIndex::FindCheckpoint(std::uint64_t ts) const
+   {
+      /* строго меньше: изменения ровно в ts должны попасть в проход */
+      auto it = std::lower_bound(m_checkpoints.begin(), m_checkpoints.end(), ts,
+                                 [](const Checkpoint &cp, std::uint64_t t)
+                                 { return cp.at.timestamp < t; });
+      if (it != m_checkpoints.begin())
+         --it;
+      return *it;
+   }
+
+   std::uint64_t
+   VcdIndex::FindEndOffset(std::uint64_t ts) const
+   {
+      auto it = std::upper_bound(m_seek.begin(), m_seek.end(), ts,
+                                 [](std::uint64_t t, const SeekPoint &sp)
+                                 { return t < sp.timestamp; });
+      return it == m_seek.end() ? m_fileSize : it->offset;
+   }
+
+   bool
+   VcdIndex::Save(const std::filesystem::path &sidecar) const
+   {
+      const std::filesystem::path tmp = sidecar.string() + ".tmp";
+      {
+         std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+         if (!os)
+            return false;
+
+         os.write(kMagic, sizeof(kMagic));
+         WriteU64(os, m_fileSize);
+         WriteU64(os, static_cast<std::uint64_t>(m_mtime));
+         WriteU64(os, m_bodyOffset);
+         WriteU64(os, m_maxTs);
+
+         WriteU64(os, m_aliases.size());
+         for (const auto &a : m_aliases)
+            WriteStr(os, a);
+
+         WriteU64(os, m_seek.size());
+         for (const auto &sp : m_seek)
+         {
+            WriteU64(os, sp.timestamp);
+            WriteU64(os, sp.offset);
+         }
+
+         WriteU64(os, m_checkpoints.size());
+         for (const auto &cp : m_checkpoints)
+         {
+            WriteU64(os, cp.at.timestamp);
+            WriteU64(os, cp.at.offset);
+            WriteU64(os, cp.inDumpoff);
+            WriteU64(os, cp.dumpoffBegin);
+            for (const auto &s : cp.states)
+               WriteStr(os, s);
+         }
+         if (!os)
+            return false;
+      }
+
+      std::error_code ec;
+      std::filesystem::rename(tmp, sidecar, ec);
+      return !ec;
+   }
+
+   std::optional<VcdIndex>
+   VcdIndex::Load(const std::filesystem::path &sidecar, const std::filesystem::path &vcd)
+   {
+      std::error_code ec;
+      const auto size = std::filesystem::file_size(vcd, ec);
+      if (ec || !std::filesystem::exists(sidecar, ec))
+         return std::nullopt;
+      /* счётчики ниже сверяются с остатком файла: битый sidecar -> nullopt, а не bad_alloc */
+      const std::uint64_t sidecarBytes = std::filesystem::file_size(sidecar, ec);
+      if (ec)
+         return std::nullopt;
+
+      std::ifstream is(sidecar, std::ios::binary);
+      char magic[sizeof(kMagic)] = {};
+      if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+         return std::nullopt;
+
+      VcdIndex idx;
+      std::uint64_t mtime = 0;
+      if (!ReadU64(is, idx.m_fileSize) || !ReadU64(is, mtime) ||
+          !ReadU64(is, idx.m_bodyOffset) || !ReadU64(is, idx.m_maxTs))
+         return std::nullopt;
+      idx.m_mtime = static_cast<std::int64_t>(mtime);
+      if (idx.m_fileSize != size || idx.m_mtime != FileMtime(vcd))
+         return std::nullopt; // файл изменился после построения индекса
+
+      std::uint64_t n = 0;
+      if (!ReadU64(is, n) || !Fits(is, sidecarBytes, n, sizeof(std::uint64_t)))
+         return std::nullopt;
+      idx.m_aliases.resize(n);
+      for (auto &a : idx.m_aliases)
+      {
+         if (!ReadStr(is, a, sidecarBytes))
+            return std::nullopt;
+      }
+
+      if (!ReadU64(is, n) || !Fits(is, sidecarBytes, n, 2 * sizeof(std::uint64_t)))
+         return std::nullopt;
+      idx.m_seek.resize(n);
+      for (auto &sp : idx.m_seek)
+      {
+         if (!ReadU64(is, sp.timestamp) || !ReadU64(is, sp.offset))
+            return std::nullopt;
+      }
+
+      const std::uint64_t checkpointBytes = (4 + idx.m_aliases.size()) * sizeof(std::uint64_t);
+      if (!ReadU64(is, n) || n == 0 || !Fits(is, sidecarBytes, n, checkpointBytes))
+         return std::nullopt;
+      idx.m_checkpoints.resize(n);
+      for (auto &cp : idx.m_checkpoints)
+      {
+         std::uint64_t inDumpoff = 0;
+         if (!ReadU64(is, cp.at.timestamp) || !ReadU64(is, cp.at.offset) ||
+             !ReadU64(is, inDumpoff) || !ReadU64(is, cp.dumpoffBegin))
+            return std::nullopt;
+         cp.inDumpoff = inDumpoff != 0;
+         cp.states.resize(idx.m_aliases.size());
+         for (auto &s : cp.states)
+         {
+            if (!ReadStr(is, s, sidecarBytes))
+               return std::nullopt;
+         }
+      }
+      return idx;
+   }
+} // namespace vcd
@@ -0,0 +1,148 @@
+#include "Include/VcdPerfCounters.hpp"
+
+#include <cstring>
+#include <ctime>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace vcd
+{
+   namespace
+   {
+      int
+      OpenEvent(std::uint64_t config)
+      {
+         perf_event_attr attr;
+         std::memset(&attr, 0, sizeof(attr));
+         attr.type = PERF_TYPE_HARDWARE;
+         attr.size = sizeof(attr);
+         attr.config = config;
+         attr.disabled = 1;
+         attr.exclude_kernel = 1;
+         attr.exclude_hv = 1;
+         attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+         /* pid = 0, cpu = -1: только вызывающий поток, на любом ядре */
+         return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+      }
+
+      /* значение с поправкой на время, когда счётчик был вытеснен */
+      std::optional<std::uint64_t>
+      ReadScaled(int fd)
+      {
+         if (fd < 0)
+            return std::nullopt;
+         std::uint64_t buf[3] = {}; // value, time_enabled, time_running
+         if (::read(fd, buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf)))
+            return std::nullopt;
+         if (buf[2] == 0)
+            return buf[1] == 0 ? std::optional<std::uint64_t>(0) : std::nullopt;
+         if (buf[2] >= buf[1])
+            return buf[0];
+         return static_cast<std::uint64_t>(static_cast<double>(buf[0]) * static_cast<double>(buf[1]) /
+                                           static_cast<double>(buf[2]));
+      }
+
+      std::uint64_t
+      ThreadCpuNs()
+      {
+         timespec ts{};
+         ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+         return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000u + static_cast<std::uint64_t>(ts.tv_nsec);
+      }
+
+      void
+      ThreadUsage(std::uint64_t &faults, std::uint64_t &switches)
+      {
+         rusage ru{};
+         ::getrusage(RUSAGE_THREAD, &ru);
+         faults = static_cast<std::uint64_t>(ru.ru_minflt + ru.ru_majflt);
+         switches = static_cast<std::uint64_t>(ru.ru_nvcsw + ru.ru_nivcsw);
+      }
+
+      void
+      Add(std::optional<std::uint64_t> &a, const std::optional<std::uint64_t> &b)
+      {
+         if (b)
+            a = a.value_or(0) + *b;
+      }
+   } // namespace
+
+   CounterValues &
+   CounterValues::operator+=(const CounterValues &o) noexcept
+   {
+      Add(cycles, o.cycles);
+      Add(instructions, o.instructions);
+      Add(llcMisses, o.llcMisses);
+      Add(branchMisses, o.branchMisses);
+      cpuTimeNs += o.cpuTimeNs;
+      pageFaults += o.pageFaults;
+      ctxSwitches += o.ctxSwitches;
+      return *this;
+   }
+
+   PerfCounters::PerfCounters(bool hardware)
+   {
+      if (!hardware)
+         return;
+      static constexpr std::uint64_t kConfig[kEvents] = {
+          PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+          PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+      /* без тактов остальные значения не интерпретировать — всё или ничего по циклам */
+      m_fds[0] = OpenEvent(kConfig[0]);
+      if (m_fds[0] < 0)
+         return;
+      for (int i = 1; i < kEvents; ++i)
+         m_fds[i] = OpenEvent(kConfig[i]);
+   }
+
+   PerfCounters::~PerfCounters()
+   {
+      for (int fd : m_fds)
+      {
+         if (fd >= 0)
+            ::close(fd);
+      }
+   }
+
+   void
+   PerfCounters::Start()
+   {
+      ThreadUsage(m_faultsStart, m_switchesStart);
+      m_cpuStart = ThreadCpuNs();
+      for (int fd : m_fds)
+      {
+         if (fd < 0)
+            continue;
+         ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+         ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+   }
+
+   CounterValues
+   PerfCounters::Stop()
+   {
+      for (int fd : m_fds)
+      {
+         if (fd >= 0)
+            ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      }
+
+      CounterValues v;
+      v.cpuTimeNs = ThreadCpuNs() - m_cpuStart;
+      std::uint64_t faults = 0, switches = 0;
+      ThreadUsage(faults, switches);
+      v.pageFaults = faults - m_faultsStart;
+      v.ctxSwitches = switches - m_switchesStart;
+
+      v.cycles = ReadScaled(m_fds[0]);
+      v.instructions = ReadScaled(m_fds[1]);
+      v.llcMisses = ReadScaled(m_fds[2]);
+      v.branchMisses = ReadScaled(m_fds[3]);
+      return v;
+   }
+} // namespace vcd
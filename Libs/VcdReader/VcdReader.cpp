@@ -1,9 +1,15 @@
 #include "Include/VcdStructs.hpp"
+#include "Include/VcdChangeIndex.hpp"
+#include "Include/VcdStatsIndex.hpp"
+#include "Include/VcdTrace.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <mutex>
 #include <thread>
@@ -12,9 +18,179 @@
 #include <cassert>
 
 #include <fstream>
+#include <cstring>
+#include <condition_variable>
+#include <deque>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "BlockReader.hpp"
+#include "BodyScanner.hpp"
 
 namespace vcd
 {
+   using detail::ScanBody;
+
+   namespace
+   {
+      using Clock = std::chrono::steady_clock;
+
+      double
+      MsSince(Clock::time_point t0)
+      {
+         return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+      }
+
+      /* счётчики одной фазы в одном потоке; пустышка, если сбор выключен */
+      class PhaseCounterScope
+      {
+      public:
+         explicit PhaseCounterScope(bool enabled)
+         {
+            if (enabled)
+            {
+               m_counters.emplace();
+               m_counters->Start();
+            }
+         }
+
+         std::optional<CounterValues>
+         Stop()
+         {
+            if (!m_counters)
+               return std::nullopt;
+            CounterValues v = m_counters->Stop();
+            m_counters.reset();
+            return v;
+         }
+
+         void
+         Finish(std::vector<LoadStats::PhaseCounters> &out, std::string_view phase, unsigned thread = 0)
+         {
+            if (auto v = Stop())
+               out.push_back({phase, thread, *v});
+         }
+
+      private:
+         std::optional<PerfCounters> m_counters;
+      };
+
+      /* значение поля "<key> <n> kB" из /proc/self/status, в байтах */
+      std::size_t
+      ReadProcStatusBytes(std::string_view key)
+      {
+         std::ifstream status("/proc/self/status");
+         std::string line;
+         while (std::getline(status, line))
+         {
+            if (line.compare(0, key.size(), key) == 0)
+            {
+               return std::strtoull(line.c_str() + key.size(), nullptr, 10) * 1024;
+            }
+         }
+         return 0;
+      }
+   } // namespace
+
+   std::string_view
+   ValuePool::Append(std::string_view v)
+   {
+      if (v.empty())
+         return std::string_view{}; // пустой view не требует блока: m_blocks может быть ещё пуст
+
+      if (v.size() > kBlockSize / 4)
+      {
+         /* очень широкие шины — отдельным блоком, чтобы не оставлять дыр в общих */
+         auto &blk = m_large.emplace_back(std::make_unique<char[]>(v.size()));
+         std::memcpy(blk.get(), v.data(), v.size());
+         m_bytes += v.size();
+         return std::string_view(blk.get(), v.size());
+      }
+
+      if (m_used + v.size() > kBlockSize)
+      {
+         m_blocks.emplace_back(std::make_unique<char[]>(kBlockSize));
+         m_bytes += kBlockSize;
+         m_used = 0;
+      }
+      char *dst = m_blocks.back().get() + m_used;
+      std::memcpy(dst, v.data(), v.size());
+      m_used += v.size();
+      return std::string_view(dst, v.size());
+   }
+
+   std::string_view
+   ValuePool::StateView(char c) noexcept
+   {
+      static const auto table = []
+      {
+         std::array<char, 256> t{};
+         for (std::size_t i = 0; i < t.size(); ++i)
+            t[i] = static_cast<char>(i);
+         return t;
+      }();
+      return std::string_view(&table[static_cast<unsigned char>(c)], 1);
+   }
+
+   std::regex
+   SignalFilter::Compile(std::string_view pattern, Syntax syntax)
+   {
+      constexpr auto flags = std::regex::ECMAScript | std::regex::optimize;
+      if (syntax == Syntax::regex)
+         return std::regex(std::string(pattern), flags);
+
+      std::string re;
+      re.reserve(pattern.size() * 2);
+      for (char c : pattern)
+      {
+         switch (c)
+         {
+         case '*':
+            re += ".*";
+            break;
+         case '?':
+            re += '.';
+            break;
+         case '.': case '[': case ']': case '(': case ')': case '{': case '}':
+         case '+': case '^': case '$': case '|': case '\\':
+            re += '\\';
+            re += c;
+            break;
+         default:
+            re += c;
+         }
+      }
+      return std::regex(re, flags);
+   }
+
+   SignalFilter &
+   SignalFilter::Include(std::string_view pattern, Syntax syntax)
+   {
+      m_include.push_back(Compile(pattern, syntax));
+      return *this;
+   }
+
+   SignalFilter &
+   SignalFilter::Exclude(std::string_view pattern, Syntax syntax)
+   {
+      m_exclude.push_back(Compile(pattern, syntax));
+      return *this;
+   }
+
+   bool
+   SignalFilter::Matches(const std::string &path) const
+   {
+      auto match = [&](const std::regex &re)
+      { return std::regex_match(path, re); };
+
+      if (!m_include.empty() && std::none_of(m_include.begin(), m_include.end(), match))
+         return false;
+      return std::none_of(m_exclude.begin(), m_exclude.end(), match);
+   }
+
    std::string
    Handle::ExtractDate()
    {
@@ -30,7 +206,10 @@ namespace vcd
 
          currToken = m_tokens.front();
       }
-      date.pop_back();
+      if (!date.empty())
+      {
+         date.pop_back();
+      }
       return date;
    }
 
@@ -47,7 +226,10 @@ namespace vcd
 
          currToken = m_tokens.front();
       }
-      version.pop_back();
+      if (!version.empty())
+      {
+         version.pop_back();
+      }
       return version;
    }
 
@@ -247,6 +429,11 @@ namespace vcd
    void
    Handle::Init(const std::filesystem::path &fileName)
    {
+      VCD_TRACE_SCOPE("Handle::Init");
+      m_loadStats = LoadStats{};
+      m_loadStats.openedAt = Clock::now();
+      PhaseCounterScope counters(m_collectCounters);
+
       std::ifstream file(fileName, std::ios::binary);
       if (!file)
       {
@@ -276,20 +463,40 @@ namespace vcd
          headerBuf << tok << ' ';
       }
 
-      /* позиция начала времянки */
-      m_tsOffset = file.tellg();
+      m_loadStats.headerScanMs = MsSince(m_loadStats.openedAt);
 
       /* токенизируем накопленный header */
+      const auto tokenizeStart = Clock::now();
       m_tokens = Tokenize(headerBuf.str());
+      m_loadStats.tokenizeMs = MsSince(tokenizeStart);
 
       m_filepath = fileName;
       m_size = std::filesystem::file_size(fileName);
+
+      /* позиция начала времянки (tellg() == -1, если тела нет вовсе) */
+      file.clear();
+      const std::streamoff tsPos = file.tellg();
+      m_tsOffset = tsPos < 0 ? m_size : static_cast<std::size_t>(tsPos);
+      counters.Finish(m_loadStats.counters, "init");
+
+      /* тело читается позже: целиком (LoadSignals / LoadSignalsParallel)
+         или блоками параллельно с разбором (LoadSignalsPipelined) */
+   }
+
+   void
+   Handle::ReadRawData()
+   {
+      VCD_TRACE_SCOPE("Handle::ReadRawData");
+      const auto t0 = Clock::now();
+      PhaseCounterScope counters(m_collectCounters);
       m_data.resize(m_size);
 
       std::ifstream f(m_filepath.string(), std::ios::binary);
       f.read(m_data.data(), m_size);
-
-      m_data.erase(std::remove(m_data.begin(), m_data.end(), '\r'), m_data.end());
+      m_data.resize(static_cast<std::size_t>(f.gcount()));
+      m_size = m_data.size();
+      m_loadStats.readMs = MsSince(t0);
+      counters.Finish(m_loadStats.counters, "read");
    }
 
    void
@@ -318,6 +525,9 @@ namespace vcd
    void
    Handle::LoadHdr()
    {
+      VCD_TRACE_SCOPE("Handle::LoadHdr");
+      const auto t0 = Clock::now();
+      PhaseCounterScope counters(m_collectCounters);
       std::string token;
       while (!m_tokens.empty())
       {
@@ -362,6 +572,62 @@ namespace vcd
       {
          LinkParent(m_root, m_root->subModules());
       }
+      AssignPinIds();
+      m_loadStats.loadHdrMs = MsSince(t0);
+      counters.Finish(m_loadStats.counters, "loadHdr");
+   }
+
+   void
+   Handle::AssignPinIds()
+   {
+      std::uint32_t id = 0;
+      m_pinById.clear();
+      m_pinById.reserve(m_alias2pin.size());
+      for (auto &[alias, pin] : m_alias2pin)
+      {
+         pin->m_id = id++;
+         m_pinById.push_back(pin);
+      }
+   }
+
+   /*
+    * Один проход по дереву модулей: путь каждого $var сравнивается с
+    * фильтром, результат кладётся в плотную маску по m_id, которую
+    * проверяют циклы разбора тела.
+    */
+   void
+   Handle::BuildKeepMask()
+   {
+      m_keep.clear();
+      if (m_filter.IsEmpty())
+         return;
+
+      m_keep.assign(m_alias2pin.size(), 0);
+      std::string path;
+      auto walk = [&](auto &&self, const Module &module) -> void
+      {
+         const std::size_t base = path.size();
+         if (!path.empty())
+            path += '.';
+         path += module.GetName();
+
+         for (const auto &pin : module.GetPins())
+         {
+            if (m_keep[pin->GetId()])
+               continue;
+            const std::size_t len = path.size();
+            path += '.';
+            path += pin->GetName();
+            m_keep[pin->GetId()] = m_filter.Matches(path);
+            path.resize(len);
+         }
+         for (const auto &sub : module.subModules())
+            self(self, *sub);
+
+         path.resize(base);
+      };
+      if (m_root)
+         walk(walk, *m_root);
    }
 
    std::queue<std::string>
@@ -396,113 +662,103 @@ namespace vcd
       return tokens;
    }
 
+   std::vector<PinValue> *
+   Handle::GetMutableTimeline(IPinDescription &pin) noexcept
+   {
+      if (pin.GetPinType() == PinType::parameter)
+         return nullptr;
+      if (pin.GetSignalType() == SignalType::simple)
+         return &static_cast<SimplePinDescription &>(pin).m_values;
+      return &static_cast<BusPinDescription &>(pin).m_values;
+   }
+
    void
    Handle::LoadSignals()
    {
-      using clock = std::chrono::high_resolution_clock;
-      auto t0 = clock::now();
+      if (m_bodyLoaded)
+         return;
+      VCD_TRACE_SCOPE("Handle::LoadSignals");
+      const auto bodyStart = Clock::now();
+      if (m_data.empty())
+         ReadRawData();
+      BuildKeepMask();
+      const auto parseStart = Clock::now();
+      PhaseCounterScope counters(m_collectCounters);
 
-      const char *p = m_data.data() + m_tsOffset;
-      const char *end = m_data.data() + m_size;
       uint64_t curTs = 0;
-
       uint64_t dumpoffBeginTs = 0;
 
-      auto skip_ws = [&]()
-      {
-         while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
-            ++p;
-      };
-
-      // std::cout << "---- begin waveform parse ----\n";
-
-      while (p < end)
+      if (m_exactReservation)
       {
-         skip_ws();
-         if (p >= end)
-            break;
-
-         /* ---------- timestamp ---------- */
-         if (*p == '#')
-         {
-            ++p;
-            uint64_t ts = 0;
-            while (p < end && *p >= '0' && *p <= '9')
-               ts = ts * 10 + (*p++ - '0');
-            curTs = ts;
-            continue;
-         }
-
-         /* ---------- multibit ---------- */
-         if (*p == 'b')
-         {
-            ++p;
-            const char *vBeg = p;
-            while (p < end && *p != ' ' && *p != '\t' &&
-                   *p != '\r' && *p != '\n')
-               ++p;
-            std::string_view bits(vBeg, p - vBeg);
-
-            skip_ws(); //  alias
-            const char *aBeg = p;
-            while (p < end && *p != ' ' && *p != '\t' &&
-                   *p != '\r' && *p != '\n')
-               ++p;
-            std::string_view al(aBeg, p - aBeg);
-
-            std::static_pointer_cast<BusPinDescription>(m_alias2pin[al])->m_values.push_back(PinValue{.timestamp = curTs, .value = bits});
-            continue;
-         }
-
-         /* ---------- $dumpXXX … $end ---------- */
-         if (*p == '$')
+         std::vector<std::size_t> counts(m_alias2pin.size(), 0);
+         ScanBody(
+             m_data.data() + m_tsOffset, m_data.data() + m_data.size(),
+             [](uint64_t) {},
+             [&](std::string_view, std::string_view al)
+             {
+                auto it = m_alias2pin.find(al);
+                if (it != m_alias2pin.end())
+                   ++counts[it->second->GetId()];
+             },
+             [](std::string_view) {});
+         for (const auto &[alias, pin] : m_alias2pin)
          {
-            const char *lineBeg = p;
-            while (p < end && *p != '\n')
-               ++p;
-            std::string_view val(lineBeg + 1, p - lineBeg - 2); // skip $ from left and \r from right
-            if (val == "dumpoff")
-            {
-               dumpoffBeginTs = curTs;
-            }
-            else if (val == "dumpon")
-            {
-               m_dumpoffIntervals.emplace_back(std::make_pair(dumpoffBeginTs, curTs));
-            }
-
-            continue;
+            if (auto *timeline = GetMutableTimeline(*pin); timeline && IsPinLoaded(*pin))
+               timeline->reserve(counts[pin->GetId()]);
          }
-
-         /* ---------- однобитовый ---------- */
-         std::string_view val(p++, 1); // '0','1','x','z'
-         const char *aBeg = p;
-         while (p < end && *p != ' ' && *p != '\t' &&
-                *p != '\r' && *p != '\n')
-            ++p;
-         std::string_view al(aBeg, p - aBeg);
-
-         std::static_pointer_cast<SimplePinDescription>(m_alias2pin[al])->m_values.push_back(PinValue{.timestamp = curTs, .value = val});
       }
 
+      ScanBody(
+          m_data.data() + m_tsOffset, m_data.data() + m_data.size(),
+          [&](uint64_t ts)
+          { curTs = ts; },
+          [&](std::string_view val, std::string_view al)
+          {
+             auto it = m_alias2pin.find(al);
+             if (it == m_alias2pin.end() || !IsPinLoaded(*it->second))
+                return;
+             if (auto *timeline = GetMutableTimeline(*it->second))
+                timeline->push_back(PinValue{.timestamp = curTs, .value = val});
+          },
+          [&](std::string_view cmd)
+          {
+             if (cmd == "dumpoff")
+             {
+                dumpoffBeginTs = curTs;
+             }
+             else if (cmd == "dumpon")
+             {
+                m_dumpoffIntervals.emplace_back(std::make_pair(dumpoffBeginTs, curTs));
+             }
+          });
+
       m_maxTimestamp = curTs;
-      auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    clock::now() - t0)
-                    .count();
-      // std::cout << "[ensureSignalLoaded] loaded in " << ms << " ms\n";
+      m_loadStats.parseMs = MsSince(parseStart);
+      m_loadStats.threadParseMs = {m_loadStats.parseMs};
+      counters.Finish(m_loadStats.counters, "parse");
+      CompactValues();
+      BuildIndexes({});
+      FinishLoadStats("serial", 1, bodyStart);
    }
 
    void
    Handle::LoadSignalsParallel()
    {
-      using clock = std::chrono::high_resolution_clock;
-      auto t0 = clock::now();
+      if (m_bodyLoaded)
+         return;
+      VCD_TRACE_SCOPE("Handle::LoadSignalsParallel");
+      const auto bodyStart = Clock::now();
+      if (m_data.empty())
+         ReadRawData();
+      BuildKeepMask();
+      const auto parseStart = Clock::now();
 
       /*------------- 1. выбираем число потоков ------------------*/
       const std::size_t bodySize = m_size - m_tsOffset;
-      unsigned hw = std::thread::hardware_concurrency();
       unsigned nThreads =
           (bodySize < 10 * 1024 * 1024) ? 2 : (bodySize < 20 * 1024 * 1024) ? 4
-                                                                            : (hw ? hw : 8);
+                                                                            : GetThreadBudget();
+      nThreads = std::min(nThreads, GetThreadBudget());
 
       /*------------- 2. вычисляем границы кусков ----------------*/
       std::vector<const char *> chunkBeg(nThreads + 1);
@@ -512,7 +768,7 @@ namespace vcd
 
       for (unsigned i = 1; i < nThreads; ++i)
       {
-         const char *p = chunkBeg[0] + i * chunkSz;
+         const char *p = std::max(chunkBeg[0] + i * chunkSz, chunkBeg[i - 1]);
          while (p < bodyEnd - 1 && !(p[0] == '\n' && p[1] == '#'))
             ++p;              // двигаемся вперёд до начала строки "#…"
          chunkBeg[i] = p + 1; // ставим точно на '#'
@@ -520,133 +776,175 @@ namespace vcd
       chunkBeg.back() = bodyEnd; // sentinel
 
       /*------------- 3. локальные буферы потоков ----------------*/
+      /* приёмники по плотному m_id; nullptr — параметр или отфильтрован */
+      std::vector<std::vector<PinValue> *> timelineById(m_alias2pin.size(), nullptr);
+      for (const auto &[alias, pin] : m_alias2pin)
+      {
+         if (IsPinLoaded(*pin))
+            timelineById[pin->GetId()] = GetMutableTimeline(*pin);
+      }
+
       struct LocalBuf
       {
-         std::unordered_map<std::string_view,
-                            std::vector<PinValue>>
-             pinData;
+         std::vector<std::vector<PinValue>> pinData; //!< по m_id
          uint64_t maxTs = 0;
 
          std::map<uint64_t, std::string> m_ranges;
       };
       std::vector<LocalBuf> locals(nThreads);
 
-      /*------------- 4. worker-функция --------------------------*/
-      auto worker = [&](unsigned idx)
+      /* время и счётчики каждого потока копятся по всем проходам */
+      std::vector<double> threadMs(nThreads, 0.0);
+      std::vector<LoadStats::PhaseCounters> threadCounters(nThreads);
+      for (unsigned i = 0; i < nThreads; ++i)
+         threadCounters[i] = {"parse", i, {}};
+      auto runWorkers = [&](auto &&fn)
       {
-         LocalBuf &L = locals[idx];
-         const char *p = chunkBeg[idx];
-         const char *e = chunkBeg[idx + 1];
-         uint64_t curTs = 0;
-
-         auto skip_ws = [&]()
-         {
-            while (p < e &&
-                   (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
-               ++p;
-         };
-
-         while (p < e)
+         std::vector<std::thread> workers;
+         for (unsigned i = 0; i < nThreads; ++i)
          {
-            skip_ws();
-            if (p >= e)
-               break;
+            workers.emplace_back([&, i]
+                                 {
+               VCD_TRACE_THREAD("parse worker " + std::to_string(i));
+               VCD_TRACE_SCOPE("LoadSignalsParallel/worker");
+               const auto start = Clock::now();
+               PhaseCounterScope counters(m_collectCounters);
+               fn(i);
+               if (auto v = counters.Stop())
+                  threadCounters[i].values += *v;
+               threadMs[i] += MsSince(start); });
+         }
+         for (auto &t : workers)
+            t.join();
+      };
 
-            /*--- timestamp -------------------------------------*/
-            if (*p == '#')
-            {
-               ++p;
-               uint64_t ts = 0;
-               while (p < e && *p >= '0' && *p <= '9')
-                  ts = ts * 10 + (*p++ - '0');
-               curTs = ts;
-               L.maxTs = std::max(L.maxTs, curTs);
-               continue;
-            }
+      /* id пина, если его изменения сохраняются, иначе SIZE_MAX */
+      auto keptId = [&](std::string_view al) -> std::size_t
+      {
+         auto it = m_alias2pin.find(al);
+         if (it == m_alias2pin.end() || !timelineById[it->second->GetId()])
+            return SIZE_MAX;
+         return it->second->GetId();
+      };
 
-            /*--- multibit  b<val> <alias> ----------------------*/
-            if (*p == 'b')
-            {
-               ++p;
-               const char *vBeg = p;
-               while (p < e && *p != ' ' && *p != '\t' &&
-                      *p != '\r' && *p != '\n')
-                  ++p;
-               std::string_view bits(vBeg, p - vBeg);
-
-               skip_ws(); // alias
-               const char *aBeg = p;
-               while (p < e && *p != ' ' && *p != '\t' &&
-                      *p != '\r' && *p != '\n')
-                  ++p;
-               std::string_view al(aBeg, p - aBeg);
-
-               L.pinData[al].push_back({curTs, bits});
-               continue;
-            }
+      auto onCommand = [&](LocalBuf &L, uint64_t curTs, std::string_view cmd)
+      {
+         if (cmd == "dumpoff" || cmd == "dumpon")
+         {
+            L.m_ranges[curTs] = cmd;
+         }
+      };
 
-            /*--- пропускаем $dumpXXX … $end --------------------*/
-            if (*p == '$')
+      if (m_exactReservation)
+      {
+         /*------------- 4a. подсчёт изменений по кускам -----------*/
+         std::vector<std::vector<std::size_t>> offsets(nThreads);
+         runWorkers([&](unsigned idx)
+                    {
+            LocalBuf &L = locals[idx];
+            auto &cnt = offsets[idx];
+            cnt.assign(timelineById.size(), 0);
+            uint64_t curTs = 0;
+            ScanBody(
+                chunkBeg[idx], chunkBeg[idx + 1],
+                [&](uint64_t ts)
+                {
+                   curTs = ts;
+                   L.maxTs = std::max(L.maxTs, curTs);
+                },
+                [&](std::string_view, std::string_view al)
+                {
+                   if (const auto id = keptId(al); id != SIZE_MAX)
+                      ++cnt[id];
+                },
+                [&](std::string_view cmd)
+                { onCommand(L, curTs, cmd); }); });
+
+         /*------------- 4b. смещения кусков + одна аллокация ------*/
+         for (std::size_t id = 0; id < timelineById.size(); ++id)
+         {
+            std::size_t total = 0;
+            for (auto &cnt : offsets)
             {
-               const char *lineBeg = p;
-               while (p < e && *p != '\n')
-                  ++p;
-               std::string_view val(lineBeg + 1, p - lineBeg - 2); // skip $ from left and \r from right
-               if (val == "dumpoff" || val == "dumpon")
-               {
-                  L.m_ranges[curTs] = val;
-               }
-
-               continue;
+               const std::size_t n = cnt[id];
+               cnt[id] = total;
+               total += n;
             }
+            if (timelineById[id])
+               timelineById[id]->resize(total);
+         }
 
-            /*--- 1-бит  <val><alias> ---------------------------*/
-            std::string_view val(p++, 1);
-            const char *aBeg = p;
-            while (p < e && *p != ' ' && *p != '\t' &&
-                   *p != '\r' && *p != '\n')
-               ++p;
-            std::string_view al(aBeg, p - aBeg);
+         /*------------- 4c. запись по месту -----------------------*/
+         runWorkers([&](unsigned idx)
+                    {
+            auto &pos = offsets[idx];
+            uint64_t curTs = 0;
+            ScanBody(
+                chunkBeg[idx], chunkBeg[idx + 1],
+                [&](uint64_t ts)
+                { curTs = ts; },
+                [&](std::string_view val, std::string_view al)
+                {
+                   if (const auto id = keptId(al); id != SIZE_MAX)
+                      (*timelineById[id])[pos[id]++] = {curTs, val};
+                },
+                [](std::string_view) {}); });
+      }
+      else
+      {
+         /*------------- 4. worker-функция -------------------------*/
+         auto worker = [&](unsigned idx)
+         {
+            LocalBuf &L = locals[idx];
+            L.pinData.resize(timelineById.size());
+            uint64_t curTs = 0;
+
+            ScanBody(
+                chunkBeg[idx], chunkBeg[idx + 1],
+                [&](uint64_t ts)
+                {
+                   curTs = ts;
+                   L.maxTs = std::max(L.maxTs, curTs);
+                },
+                [&](std::string_view val, std::string_view al)
+                {
+                   if (const auto id = keptId(al); id != SIZE_MAX)
+                      L.pinData[id].push_back({curTs, val});
+                },
+                [&](std::string_view cmd)
+                { onCommand(L, curTs, cmd); });
+         };
 
-            L.pinData[al].push_back({curTs, val});
-         }
-      };
+         /*------------- 5. запускаем потоки ----------------------*/
+         runWorkers(worker);
+      }
 
-      /*------------- 5. запускаем потоки -----------------------*/
-      std::vector<std::thread> workers;
-      for (unsigned i = 0; i < nThreads; ++i)
-         workers.emplace_back(worker, i);
-      for (auto &t : workers)
-         t.join();
+      m_loadStats.parseMs = MsSince(parseStart);
+      m_loadStats.threadParseMs = std::move(threadMs);
+      if (m_collectCounters)
+      {
+         m_loadStats.counters.insert(m_loadStats.counters.end(), threadCounters.begin(), threadCounters.end());
+      }
 
       /*------------- 6. слияние в основной Handle --------------*/
+      const auto mergeStart = Clock::now();
+      PhaseCounterScope mergeCounters(m_collectCounters);
       m_maxTimestamp = 0;
       std::map<uint64_t, std::string> mergedRanges;
       for (auto &L : locals)
       {
+         VCD_TRACE_SCOPE("LoadSignalsParallel/merge");
          m_maxTimestamp = std::max(m_maxTimestamp, L.maxTs);
 
-         for (auto &[alias, vec] : L.pinData)
+         // при точном резервировании pinData пусты: всё уже на месте
+         for (std::size_t id = 0; id < L.pinData.size(); ++id)
          {
-            auto pinIt = m_alias2pin.find(alias);
-            if (pinIt == m_alias2pin.end())
-               continue;
-
-            if (pinIt->second->GetSignalType() == SignalType::simple)
-            {
-               auto sp = std::static_pointer_cast<SimplePinDescription>(pinIt->second);
-               auto &dst = sp->m_values;
-               dst.insert(dst.end(),
-                          std::make_move_iterator(vec.begin()),
-                          std::make_move_iterator(vec.end()));
-            }
-            else
+            auto &vec = L.pinData[id];
+            if (auto *dst = timelineById[id]; dst && !vec.empty())
             {
-               auto mp = std::static_pointer_cast<BusPinDescription>(pinIt->second);
-               auto &dst = mp->m_values;
-               dst.insert(dst.end(),
-                          std::make_move_iterator(vec.begin()),
-                          std::make_move_iterator(vec.end()));
+               dst->insert(dst->end(),
+                           std::make_move_iterator(vec.begin()),
+                           std::make_move_iterator(vec.end()));
             }
          }
          mergedRanges.insert(L.m_ranges.begin(), L.m_ranges.end());
@@ -675,19 +973,1200 @@ namespace vcd
          }
       }
 
+      m_loadStats.mergeMs = MsSince(mergeStart);
+      mergeCounters.Finish(m_loadStats.counters, "merge");
+
       // Удаление дубликатов
-      for (auto &&it : m_pins)
+      const auto sortStart = Clock::now();
       {
-         it->SortAndRemoveDuplicates();
+         VCD_TRACE_SCOPE("LoadSignalsParallel/sort");
+         PhaseCounterScope sortCounters(m_collectCounters);
+         for (auto &&it : m_pins)
+         {
+            it->SortAndRemoveDuplicates();
+         }
+         sortCounters.Finish(m_loadStats.counters, "sort");
+      }
+      m_loadStats.sortMs = MsSince(sortStart);
+
+      std::vector<std::uint64_t> splits;
+      for (const auto &L : locals)
+         splits.push_back(L.maxTs + 1); // кусок idx — метки до L.maxTs включительно
+      locals.clear();
+      CompactValues();
+      BuildIndexes(std::move(splits));
+      FinishLoadStats("parallel", nThreads, bodyStart);
+   }
+
+   /*
+    * Конвейерная загрузка тела: чтение блоками (io_uring или пул pread)
+    * идёт параллельно с разбором, буфер всего файла не создаётся.
+    *
+    *  I/O-поток      : держит до kReadDepth запросов, блок i -> слот i % nSlots;
+    *  текущий поток  : по порядку блоков режет их по границам "\n#",
+    *                   склеивает «шов» (хвост блока i-1 + голову блока i)
+    *                   и отдаёт задания разборщикам, сливает результаты;
+    *  разборщики     : разбирают шов и середину блока, сразу копируя
+    *                   строки шин в свой ValuePool, и освобождают слот.
+    */
+   void
+   Handle::LoadSignalsPipelined()
+   {
+      if (m_bodyLoaded)
+         return;
+      if (!m_data.empty())
+      {
+         LoadSignalsParallel(); // файл уже прочитан целиком
+         return;
+      }
+      VCD_TRACE_SCOPE("Handle::LoadSignalsPipelined");
+      const auto bodyStart = Clock::now();
+
+      const int fd = ::open(m_filepath.c_str(), O_RDONLY);
+      if (fd < 0)
+         throw std::system_error(errno, std::generic_category(), "Can't open " + m_filepath.string());
+      struct FdGuard
+      {
+         int fd;
+         ~FdGuard() { ::close(fd); }
+      } fdGuard{fd};
+      ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+      /*------------- 1. параметры конвейера ---------------------*/
+      constexpr unsigned kReadDepth = 4;
+      const std::size_t blockSize = m_chunkSize ? m_chunkSize : (8u << 20);
+      const std::size_t bodySize = m_size > m_tsOffset ? m_size - m_tsOffset : 0;
+      const std::size_t nBlocks = (bodySize + blockSize - 1) / blockSize;
+
+      const unsigned nParsers = std::max(1u, GetThreadBudget() - 1);
+      const std::size_t nSlots = nParsers + kReadDepth + 2;
+
+      auto reader = BlockReader::Create(fd, kReadDepth, m_useIoUring);
+      m_readBackend = reader->GetName();
+
+      /* alias -> вектор изменений, чтобы разборщики не трогали shared_ptr */
+      std::unordered_map<std::string_view, std::vector<PinValue> *> aliasToTimeline;
+      BuildKeepMask();
+      for (const auto &[alias, pin] : m_alias2pin)
+      {
+         if (!IsPinLoaded(*pin))
+            continue;
+         if (auto *timeline = GetMutableTimeline(*pin))
+            aliasToTimeline.emplace(alias, timeline);
       }
 
-      auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                    clock::now() - t0)
-                    .count();
-      // std::cout << "[LoadSignalsParallel] "
-      //           << nThreads << " threads, "
-      //           << m_pins.size() << " pins, "
-      //           << "done in " << ms << " ms\n";
+      /*------------- 2. общее состояние -------------------------*/
+      enum class SlotState
+      {
+         free,
+         reading,
+         ready,
+         parsing
+      };
+      struct Slot
+      {
+         std::unique_ptr<char[]> buf;
+         SlotState state = SlotState::free;
+         std::size_t block = 0;
+         std::size_t bytes = 0;
+      };
+      struct WorkItem
+      {
+         std::size_t seq = 0;
+         std::string seam;              //!< хвост прошлого блока + голова текущего
+         const char *beg = nullptr;     //!< середина блока [beg, end) в слоте
+         const char *end = nullptr;
+         std::size_t slot = SIZE_MAX;   //!< SIZE_MAX — задание без слота
+      };
+      struct ItemResult
+      {
+         std::unordered_map<std::vector<PinValue> *, std::vector<PinValue>> values;
+         std::vector<std::pair<uint64_t, bool>> ranges; //!< (ts, true = dumpoff)
+         uint64_t maxTs = 0;
+      };
+
+      std::vector<Slot> slots(nSlots);
+      for (auto &slot : slots)
+         slot.buf = std::make_unique<char[]>(blockSize);
+
+      std::mutex mtx;
+      std::condition_variable cv;
+      std::deque<WorkItem> work;
+      std::vector<std::optional<ItemResult>> results(nBlocks + 1);
+      bool noMoreWork = false;
+      int ioError = 0;
+
+      std::vector<double> parserMs(nParsers, 0.0); //!< чистое время разбора
+      double ioMs = 0.0;                           //!< жизнь I/O-потока
+      double mergeMs = 0.0;
+      /* счётчики потоков: I/O, разборщики; ожидание на cv тактов не тратит */
+      std::vector<LoadStats::PhaseCounters> ioCounters, parserCounters(nParsers);
+      for (unsigned i = 0; i < nParsers; ++i)
+         parserCounters[i] = {"parse", i, {}};
+
+      /*------------- 3. I/O-поток ------------------------------*/
+      std::thread ioThread([&]
+                           {
+         VCD_TRACE_THREAD("io");
+         VCD_TRACE_SCOPE("LoadSignalsPipelined/io");
+         const auto ioStart = Clock::now();
+         PhaseCounterScope counters(m_collectCounters);
+         std::vector<std::size_t> progress(nSlots, 0);
+         auto blockLen = [&](std::size_t block)
+         {
+            return std::min(blockSize, bodySize - block * blockSize);
+         };
+
+         std::size_t next = 0;
+         unsigned inflight = 0;
+         while (next < nBlocks || inflight)
+         {
+            {
+               std::unique_lock lock(mtx);
+               if (!inflight)
+               {
+                  cv.wait(lock, [&]
+                          { return ioError || slots[next % nSlots].state == SlotState::free; });
+               }
+               if (ioError)
+                  break;
+               while (next < nBlocks && inflight < kReadDepth &&
+                      slots[next % nSlots].state == SlotState::free)
+               {
+                  const std::size_t si = next % nSlots;
+                  slots[si].state = SlotState::reading;
+                  slots[si].block = next;
+                  progress[si] = 0;
+                  if (!reader->Submit(si, slots[si].buf.get(), blockLen(next),
+                                      m_tsOffset + next * blockSize))
+                  {
+                     ioError = EIO;
+                     break;
+                  }
+                  ++inflight;
+                  ++next;
+               }
+               if (ioError)
+                  break;
+            }
+
+            if (!inflight)
+               continue;
+
+            const BlockReader::Completion c = reader->WaitOne();
+            const std::size_t si = c.tag;
+            --inflight;
+            if (c.result < 0)
+            {
+               std::lock_guard lock(mtx);
+               ioError = static_cast<int>(-c.result);
+               break;
+            }
+
+            progress[si] += static_cast<std::size_t>(c.result);
+            const std::size_t want = blockLen(slots[si].block);
+            if (c.result > 0 && progress[si] < want)
+            {
+               /* короткое чтение — дочитываем остаток того же блока */
+               if (!reader->Submit(si, slots[si].buf.get() + progress[si], want - progress[si],
+                                   m_tsOffset + slots[si].block * blockSize + progress[si]))
+               {
+                  std::lock_guard lock(mtx);
+                  ioError = EIO;
+                  cv.notify_all();
+                  break;
+               }
+               ++inflight;
+               continue;
+            }
+
+            std::lock_guard lock(mtx);
+            slots[si].bytes = progress[si];
+            slots[si].state = SlotState::ready;
+            cv.notify_all();
+         }
+
+         /* дожидаемся висящих запросов, чтобы не писать в освобождённые буферы */
+         while (inflight)
+         {
+            reader->WaitOne();
+            --inflight;
+         }
+         ioMs = MsSince(ioStart);
+         counters.Finish(ioCounters, "read");
+         cv.notify_all(); });
+
+      /*------------- 4. разборщики ------------------------------*/
+      const std::size_t poolBase = m_pools.size();
+      m_pools.resize(poolBase + nParsers);
+
+      auto parser = [&](unsigned idx)
+      {
+         VCD_TRACE_THREAD("parser " + std::to_string(idx));
+         PhaseCounterScope counters(m_collectCounters);
+         ValuePool &pool = m_pools[poolBase + idx];
+         std::unordered_set<std::string_view> interned;
+
+         auto intern = [&](std::string_view v)
+         {
+            if (v.size() <= 1)
+               return ValuePool::StateView(v.empty() ? '0' : v.front());
+            auto it = interned.find(v);
+            if (it == interned.end())
+               it = interned.insert(pool.Append(v)).first;
+            return *it;
+         };
+
+         for (;;)
+         {
+            WorkItem item;
+            {
+               std::unique_lock lock(mtx);
+               cv.wait(lock, [&]
+                       { return !work.empty() || noMoreWork; });
+               if (work.empty())
+               {
+                  if (auto v = counters.Stop())
+                     parserCounters[idx].values = *v;
+                  return;
+               }
+               item = std::move(work.front());
+               work.pop_front();
+            }
+
+            VCD_TRACE_SCOPE("LoadSignalsPipelined/block");
+            const auto parseStart = Clock::now();
+            ItemResult res;
+            auto parse = [&](const char *p, const char *e)
+            {
+               uint64_t curTs = 0;
+               ScanBody(
+                   p, e,
+                   [&](uint64_t ts)
+                   {
+                      curTs = ts;
+                      res.maxTs = std::max(res.maxTs, curTs);
+                   },
+                   [&](std::string_view val, std::string_view al)
+                   {
+                      auto it = aliasToTimeline.find(al);
+                      if (it != aliasToTimeline.end())
+                         res.values[it->second].push_back({curTs, intern(val)});
+                   },
+                   [&](std::string_view cmd)
+                   {
+                      if (cmd == "dumpoff" || cmd == "dumpon")
+                         res.ranges.emplace_back(curTs, cmd == "dumpoff");
+                   });
+            };
+            parse(item.seam.data(), item.seam.data() + item.seam.size());
+            parse(item.beg, item.end);
+            parserMs[idx] += MsSince(parseStart);
+
+            std::lock_guard lock(mtx);
+            results[item.seq] = std::move(res);
+            if (item.slot != SIZE_MAX)
+               slots[item.slot].state = SlotState::free;
+            cv.notify_all();
+         }
+      };
+
+      std::vector<std::thread> parsers;
+      for (unsigned i = 0; i < nParsers; ++i)
+         parsers.emplace_back(parser, i);
+
+      /*------------- 5. нарезка блоков и слияние ----------------*/
+      PhaseCounterScope mergeCounters(m_collectCounters); //!< весь текущий поток: нарезка + слияние
+      bool insideDumpoff = false;
+      uint64_t dumpoffBeg = 0;
+      std::size_t merged = 0;
+      std::size_t produced = 0;
+      m_maxTimestamp = 0;
+      m_dumpoffIntervals.clear();
+
+      auto apply = [&](ItemResult &r)
+      {
+         VCD_TRACE_SCOPE("LoadSignalsPipelined/merge");
+         const auto mergeStart = Clock::now();
+         m_maxTimestamp = std::max(m_maxTimestamp, r.maxTs);
+         for (auto &[dst, vec] : r.values)
+         {
+            dst->insert(dst->end(),
+                        std::make_move_iterator(vec.begin()),
+                        std::make_move_iterator(vec.end()));
+         }
+         for (const auto &[ts, off] : r.ranges)
+         {
+            if (off && !insideDumpoff)
+            {
+               insideDumpoff = true;
+               dumpoffBeg = ts;
+            }
+            else if (!off && insideDumpoff)
+            {
+               insideDumpoff = false;
+               m_dumpoffIntervals.emplace_back(dumpoffBeg, ts);
+            }
+         }
+         mergeMs += MsSince(mergeStart);
+      };
+
+      /* сливает готовый по порядку префикс; wait — ждать все выданные */
+      auto mergeReady = [&](bool wait)
+      {
+         for (;;)
+         {
+            std::optional<ItemResult> r;
+            {
+               std::unique_lock lock(mtx);
+               if (wait)
+                  cv.wait(lock, [&]
+                          { return merged == produced || results[merged].has_value(); });
+               if (merged == produced || !results[merged])
+                  return;
+               r = std::move(results[merged]);
+               results[merged].reset();
+            }
+            apply(*r);
+            ++merged;
+         }
+      };
+
+      auto push = [&](WorkItem item)
+      {
+         item.seq = produced++;
+         {
+            std::lock_guard lock(mtx);
+            work.push_back(std::move(item));
+         }
+         cv.notify_all();
+      };
+
+      auto isBoundary = [](const char *buf, std::size_t j)
+      {
+         return buf[j - 1] == '\n' && buf[j] == '#';
+      };
+
+      std::string carry;
+      for (std::size_t block = 0; block < nBlocks; ++block)
+      {
+         const std::size_t si = block % nSlots;
+         {
+            std::unique_lock lock(mtx);
+            cv.wait(lock, [&]
+                    { return ioError || (slots[si].state == SlotState::ready && slots[si].block == block); });
+            if (ioError)
+               break;
+            slots[si].state = SlotState::parsing;
+         }
+         const char *buf = slots[si].buf.get();
+         const std::size_t n = slots[si].bytes;
+
+         /* первая и последняя границы "\n#" внутри блока */
+         std::size_t first = 0;
+         if (block != 0)
+         {
+            first = 1;
+            while (first < n && !isBoundary(buf, first))
+               ++first;
+         }
+         std::size_t last = n ? n - 1 : 0;
+         while (last > first && !isBoundary(buf, last))
+            --last;
+
+         if (first >= n)
+         {
+            /* в блоке нет ни одной границы — целиком уходит в шов */
+            carry.append(buf, n);
+            std::lock_guard lock(mtx);
+            slots[si].state = SlotState::free;
+            cv.notify_all();
+            continue;
+         }
+
+         WorkItem item;
+         item.seam = std::move(carry);
+         item.seam.append(buf, first);
+         item.beg = buf + first;
+         item.end = buf + last;
+         item.slot = si;
+         carry.assign(buf + last, n - last);
+         push(std::move(item));
+
+         mergeReady(false);
+      }
+
+      if (!carry.empty())
+      {
+         WorkItem tail;
+         tail.seam = std::move(carry);
+         push(std::move(tail));
+      }
+      {
+         std::lock_guard lock(mtx);
+         noMoreWork = true;
+      }
+      cv.notify_all();
+
+      for (auto &t : parsers)
+         t.join();
+      mergeReady(true);
+      ioThread.join();
+      mergeCounters.Finish(m_loadStats.counters, "merge");
+      if (m_collectCounters)
+      {
+         m_loadStats.counters.insert(m_loadStats.counters.end(), ioCounters.begin(), ioCounters.end());
+         m_loadStats.counters.insert(m_loadStats.counters.end(), parserCounters.begin(), parserCounters.end());
+      }
+
+      if (ioError)
+         throw std::system_error(ioError, std::generic_category(), "Can't read " + m_filepath.string());
+
+      m_loadStats.readMs = ioMs;
+      m_loadStats.parseMs = MsSince(bodyStart);
+      m_loadStats.mergeMs = mergeMs;
+      m_loadStats.threadParseMs = std::move(parserMs);
+
+      /*------------- 6. как в LoadSignalsParallel --------------*/
+      std::transform(m_alias2pin.begin(), m_alias2pin.end(),
+                     std::back_inserter(m_pins),
+                     [](auto const &kv)
+                     { return kv.second; });
+
+      const auto sortStart = Clock::now();
+      PhaseCounterScope sortCounters(m_collectCounters);
+      for (auto &&it : m_pins)
+      {
+         it->SortAndRemoveDuplicates();
+      }
+      sortCounters.Finish(m_loadStats.counters, "sort");
+      m_loadStats.sortMs = MsSince(sortStart);
+
+      CompactValues();
+      BuildIndexes({});
+      FinishLoadStats("pipelined", nParsers, bodyStart);
+   }
+
+   void
+   Handle::LoadWindow(std::uint64_t t0, std::uint64_t t1, const VcdIndex::Options &opt)
+   {
+      if (m_bodyLoaded)
+         return;
+      if (t1 < t0)
+         std::swap(t0, t1);
+      const auto bodyStart = Clock::now();
+
+      /*------------- 1. индекс: sidecar или новый проход --------*/
+      const std::filesystem::path sidecar =
+          opt.sidecar.empty() ? VcdIndex::SidecarPath(m_filepath) : opt.sidecar;
+
+      std::vector<std::pair<std::string, std::string>> aliasInit;
+      aliasInit.reserve(m_alias2pin.size());
+      for (const auto &[alias, pin] : m_alias2pin)
+         aliasInit.emplace_back(alias, pin->GetInitState());
+      std::sort(aliasInit.begin(), aliasInit.end());
+
+      std::optional<VcdIndex> index;
+      if (opt.persist)
+         index = VcdIndex::Load(sidecar, m_filepath);
+      if (index)
+      {
+         /* тот же файл, но индекс мог строиться другой версией заголовка */
+         const auto &aliases = index->GetAliases();
+         const bool same = index->GetBodyOffset() == m_tsOffset &&
+                           std::equal(aliases.begin(), aliases.end(), aliasInit.begin(), aliasInit.end(),
+                                      [](const std::string &a, const auto &b)
+                                      { return a == b.first; });
+         if (!same)
+            index.reset();
+      }
+      if (!index)
+      {
+         index = VcdIndex::Build(m_filepath, m_tsOffset, aliasInit, opt);
+         if (opt.persist)
+            index->Save(sidecar);
+      }
+
+      /*------------- 2. читаем только [checkpoint, конец окна) ---*/
+      const VcdIndex::Checkpoint &cp = index->FindCheckpoint(t0);
+      const std::uint64_t endOff = std::max(index->FindEndOffset(t1), cp.at.offset);
+
+      const auto readStart = Clock::now();
+      PhaseCounterScope readCounters(m_collectCounters);
+      m_data.resize(endOff - cp.at.offset);
+      {
+         std::ifstream f(m_filepath.string(), std::ios::binary);
+         f.seekg(static_cast<std::streamoff>(cp.at.offset));
+         f.read(m_data.data(), static_cast<std::streamsize>(m_data.size()));
+         m_data.resize(static_cast<std::size_t>(f.gcount()));
+      }
+      m_loadStats.readMs = MsSince(readStart);
+      readCounters.Finish(m_loadStats.counters, "read");
+
+      BuildKeepMask();
+      std::vector<std::vector<PinValue> *> timelineById(m_alias2pin.size(), nullptr);
+      std::vector<std::string_view> state(m_alias2pin.size());
+      const auto &aliases = index->GetAliases();
+      for (std::size_t i = 0; i < aliases.size(); ++i)
+      {
+         const auto &pin = m_alias2pin.at(aliases[i]);
+         state[pin->GetId()] = cp.states[i];
+         if (IsPinLoaded(*pin))
+            timelineById[pin->GetId()] = GetMutableTimeline(*pin);
+      }
+
+      /*------------- 3. проход: до t0 только состояния ----------*/
+      const auto parseStart = Clock::now();
+      PhaseCounterScope parseCounters(m_collectCounters);
+      uint64_t curTs = cp.at.timestamp;
+      bool inWindow = false;
+      bool inDumpoff = cp.inDumpoff;
+      uint64_t dumpoffBeg = std::max(cp.dumpoffBegin, t0);
+      m_dumpoffIntervals.clear();
+
+      auto enterWindow = [&]
+      {
+         inWindow = true;
+         for (std::size_t id = 0; id < timelineById.size(); ++id)
+         {
+            if (timelineById[id] && !state[id].empty())
+               timelineById[id]->push_back({t0, state[id]});
+         }
+         if (inDumpoff)
+            dumpoffBeg = std::max(dumpoffBeg, t0);
+      };
+
+      ScanBody(
+          m_data.data(), m_data.data() + m_data.size(),
+          [&](uint64_t ts)
+          {
+             curTs = ts;
+             if (!inWindow && curTs >= t0)
+                enterWindow();
+          },
+          [&](std::string_view val, std::string_view al)
+          {
+             if (curTs > t1)
+                return;
+             auto it = m_alias2pin.find(al);
+             if (it == m_alias2pin.end())
+                return;
+             const auto id = it->second->GetId();
+             if (!inWindow)
+             {
+                state[id] = val;
+                return;
+             }
+             auto *timeline = timelineById[id];
+             if (!timeline)
+                return;
+             if (!timeline->empty() && timeline->back().timestamp == curTs)
+                timeline->back().value = val; // перекрывает состояние на t0
+             else
+                timeline->push_back({curTs, val});
+          },
+          [&](std::string_view cmd)
+          {
+             if (curTs > t1)
+                return;
+             if (cmd == "dumpoff" && !inDumpoff)
+             {
+                inDumpoff = true;
+                dumpoffBeg = curTs;
+             }
+             else if (cmd == "dumpon" && inDumpoff)
+             {
+                inDumpoff = false;
+                if (curTs >= t0)
+                   m_dumpoffIntervals.emplace_back(std::max(dumpoffBeg, t0), curTs);
+             }
+          });
+
+      if (!inWindow)
+         enterWindow();
+      m_loadStats.parseMs = MsSince(parseStart);
+      m_loadStats.threadParseMs = {m_loadStats.parseMs};
+      parseCounters.Finish(m_loadStats.counters, "parse");
+
+      m_maxTimestamp = std::min(t1, index->GetMaxTs());
+      std::transform(m_alias2pin.begin(), m_alias2pin.end(),
+                     std::back_inserter(m_pins),
+                     [](auto const &kv)
+                     { return kv.second; });
+
+      // состояния контрольной точки живут в локальном index: копируются
+      // в пулы и тогда, когда из файла не прочитано ни байта
+      CompactValues(true);
+      BuildIndexes({});
+      FinishLoadStats("window", 1, bodyStart);
+   }
+
+   namespace
+   {
+      /* сравнение с числами по значению: "run_2" < "run_10" */
+      bool
+      NaturalLess(std::string_view a, std::string_view b)
+      {
+         auto isDigit = [](char c)
+         { return c >= '0' && c <= '9'; };
+
+         std::size_t i = 0, j = 0;
+         while (i < a.size() && j < b.size())
+         {
+            if (isDigit(a[i]) && isDigit(b[j]))
+            {
+               const std::size_t i0 = i, j0 = j;
+               while (i < a.size() && isDigit(a[i]))
+                  ++i;
+               while (j < b.size() && isDigit(b[j]))
+                  ++j;
+               std::string_view na = a.substr(i0, i - i0), nb = b.substr(j0, j - j0);
+               while (na.size() > 1 && na.front() == '0')
+                  na.remove_prefix(1);
+               while (nb.size() > 1 && nb.front() == '0')
+                  nb.remove_prefix(1);
+               if (na.size() != nb.size())
+                  return na.size() < nb.size();
+               if (na != nb)
+                  return na < nb;
+               continue;
+            }
+            if (a[i] != b[j])
+               return a[i] < b[j];
+            ++i;
+            ++j;
+         }
+         return a.size() - i < b.size() - j;
+      }
+
+      /* пустая строка — заголовки совместимы, иначе описание расхождения */
+      std::string
+      CompareHeaders(const Handle &ref, const Handle &part)
+      {
+         if (ref.GetTimeScale() != part.GetTimeScale())
+            return "timescale differs";
+
+         const auto &refMap = ref.GetAlias2pinMap();
+         const auto &partMap = part.GetAlias2pinMap();
+         if (refMap.size() != partMap.size())
+            return "different number of signals";
+
+         for (const auto &[alias, pin] : refMap)
+         {
+            const auto other = part.GetPinByAlias(alias);
+            if (!other)
+               return "signal '" + std::string(alias) + "' is missing";
+            if (other->GetPinType() != pin->GetPinType() ||
+                other->GetSignalType() != pin->GetSignalType() ||
+                other->GetName() != pin->GetName())
+               return "signal '" + std::string(alias) + "' is declared differently";
+            if (pin->GetSignalType() == SignalType::bus && pin->GetPinType() != PinType::parameter &&
+                std::static_pointer_cast<BusPinDescription>(pin)->GetBitDepth() !=
+                    std::static_pointer_cast<BusPinDescription>(other)->GetBitDepth())
+               return "signal '" + std::string(alias) + "' has a different width";
+         }
+         return {};
+      }
+   } // namespace
+
+   void
+   Handle::SortPartsNaturally(std::vector<std::filesystem::path> &parts)
+   {
+      std::sort(parts.begin(), parts.end(),
+                [](const std::filesystem::path &a, const std::filesystem::path &b)
+                {
+                   const std::string sa = a.stem().string(), sb = b.stem().string();
+                   if (sa != sb)
+                      return NaturalLess(sa, sb);
+                   return NaturalLess(a.string(), b.string());
+                });
+   }
+
+   void
+   Handle::LoadSignalsFromParts(const std::vector<std::filesystem::path> &parts)
+   {
+      if (m_bodyLoaded)
+         return;
+      if (parts.empty())
+         throw std::invalid_argument("LoadSignalsFromParts: no parts given");
+      const auto bodyStart = Clock::now();
+
+      /*------------- 1. каждая часть — отдельный Handle ----------*/
+      std::vector<std::unique_ptr<Handle>> loaded(parts.size());
+      std::vector<std::exception_ptr> errors(parts.size());
+      std::atomic<std::size_t> next{0};
+
+      const std::size_t nThreads = std::clamp<std::size_t>(GetThreadBudget(), 1, parts.size());
+      std::vector<double> threadMs(nThreads, 0.0);
+      std::vector<LoadStats::PhaseCounters> threadCounters;
+      std::mutex countersMtx;
+
+      auto worker = [&](std::size_t idx)
+      {
+         const auto start = Clock::now();
+         PhaseCounterScope counters(m_collectCounters);
+         for (std::size_t i = next++; i < parts.size(); i = next++)
+         {
+            try
+            {
+               auto h = std::make_unique<Handle>();
+               h->Init(parts[i]);
+               h->LoadHdr();
+               if (const std::string why = CompareHeaders(*this, *h); !why.empty())
+                  throw std::runtime_error("Header of " + parts[i].string() + " does not match " +
+                                           parts.front().string() + ": " + why);
+               h->SetSignalFilter(m_filter);
+               h->LoadSignals();
+               loaded[i] = std::move(h);
+            }
+            catch (...)
+            {
+               errors[i] = std::current_exception();
+            }
+         }
+         threadMs[idx] = MsSince(start);
+         if (auto v = counters.Stop())
+         {
+            std::lock_guard lock(countersMtx);
+            threadCounters.push_back({"parse", static_cast<unsigned>(idx), *v});
+         }
+      };
+
+      std::vector<std::thread> workers;
+      for (std::size_t i = 1; i < nThreads; ++i)
+         workers.emplace_back(worker, i);
+      worker(0);
+      for (auto &t : workers)
+         t.join();
+      m_loadStats.parseMs = MsSince(bodyStart);
+      m_loadStats.threadParseMs = std::move(threadMs);
+      std::sort(threadCounters.begin(), threadCounters.end(), [](const auto &a, const auto &b)
+                { return a.thread < b.thread; });
+      m_loadStats.counters.insert(m_loadStats.counters.end(), threadCounters.begin(), threadCounters.end());
+
+      for (auto &e : errors)
+      {
+         if (e)
+            std::rethrow_exception(e);
+      }
+
+      /*------------- 2. сшивание в порядке частей ---------------*/
+      const auto mergeStart = Clock::now();
+      PhaseCounterScope mergeCounters(m_collectCounters);
+      BuildKeepMask();
+      m_maxTimestamp = 0;
+      std::vector<std::pair<uint64_t, uint64_t>> dumpoff;
+      std::uint64_t bytes = 0;
+
+      for (auto &part : loaded)
+      {
+         bytes += part->m_size;
+         for (const auto &[alias, pin] : m_alias2pin)
+         {
+            auto *dst = GetMutableTimeline(*pin);
+            auto *src = GetMutableTimeline(*part->m_alias2pin.at(alias));
+            if (!dst || !src)
+               continue;
+            /* $dumpall в начале части повторяет уже известные значения */
+            const std::string init = pin->GetInitState();
+            const std::string_view known = dst->empty() ? std::string_view(init) : dst->back().value;
+            auto from = src->begin();
+            while (from != src->end() && from->timestamp == src->front().timestamp &&
+                   from->value == known)
+               ++from;
+            dst->insert(dst->end(), from, src->end());
+         }
+
+         m_maxTimestamp = std::max(m_maxTimestamp, part->m_maxTimestamp);
+         dumpoff.insert(dumpoff.end(), part->m_dumpoffIntervals.begin(), part->m_dumpoffIntervals.end());
+
+         /* значения частей живут в их пулах — забираем пулы себе */
+         std::move(part->m_pools.begin(), part->m_pools.end(), std::back_inserter(m_pools));
+         part.reset();
+      }
+
+      /* пересекающиеся/смежные интервалы (часть оборвалась внутри $dumpoff) */
+      std::sort(dumpoff.begin(), dumpoff.end());
+      m_dumpoffIntervals.clear();
+      for (const auto &iv : dumpoff)
+      {
+         if (!m_dumpoffIntervals.empty() && iv.first <= m_dumpoffIntervals.back().second)
+            m_dumpoffIntervals.back().second = std::max(m_dumpoffIntervals.back().second, iv.second);
+         else
+            m_dumpoffIntervals.push_back(iv);
+      }
+
+      std::transform(m_alias2pin.begin(), m_alias2pin.end(),
+                     std::back_inserter(m_pins),
+                     [](auto const &kv)
+                     { return kv.second; });
+      m_loadStats.mergeMs = MsSince(mergeStart);
+      mergeCounters.Finish(m_loadStats.counters, "merge");
+
+      const auto sortStart = Clock::now();
+      PhaseCounterScope sortCounters(m_collectCounters);
+      for (auto &&it : m_pins)
+      {
+         it->SortAndRemoveDuplicates();
+      }
+      sortCounters.Finish(m_loadStats.counters, "sort");
+      m_loadStats.sortMs = MsSince(sortStart);
+
+      CompactValues();
+      BuildIndexes({});
+      FinishLoadStats("parts", static_cast<unsigned>(nThreads), bodyStart);
+      m_loadStats.bytes = bytes;
+   }
+
+   /*
+    * Переносит все значения из сырого буфера файла в собственную память
+    * Handle и освобождает m_data:
+    *  - 1-битовые значения -> view на статическую таблицу состояний;
+    *  - строки шин -> ValuePool (одинаковые строки хранятся один раз).
+    * Пины делятся между потоками, у каждого потока свой пул.
+    */
+   void
+   Handle::CompactValues(bool viewsOutsideData)
+   {
+      VCD_TRACE_SCOPE("Handle::CompactValues");
+      const auto t0 = Clock::now();
+      m_bodyLoaded = true;
+      if (m_data.empty() && !viewsOutsideData)
+      {
+         /* конвейерная загрузка: значения уже лежат в пулах */
+         m_rss.peakBytes = ReadProcStatusBytes("VmHWM:");
+         m_rss.steadyBytes = ReadProcStatusBytes("VmRSS:");
+         return;
+      }
+
+      std::vector<std::vector<PinValue> *> timelines;
+      for (const auto &[alias, pin] : m_alias2pin)
+      {
+         if (auto *timeline = GetMutableTimeline(*pin))
+            timelines.push_back(timeline);
+      }
+
+      const std::size_t nThreads = std::clamp<std::size_t>(GetThreadBudget(), 1, std::max<std::size_t>(timelines.size(), 1));
+      const std::size_t poolBase = m_pools.size();
+      m_pools.resize(poolBase + nThreads);
+      std::vector<LoadStats::PhaseCounters> threadCounters(nThreads);
+
+      auto worker = [&](std::size_t idx)
+      {
+         PhaseCounterScope counters(m_collectCounters);
+         ValuePool &pool = m_pools[poolBase + idx];
+         std::unordered_set<std::string_view> interned; // dedup в пределах потока
+
+         for (std::size_t i = idx; i < timelines.size(); i += nThreads)
+         {
+            for (PinValue &v : *timelines[i])
+            {
+               if (v.value.size() <= 1)
+               {
+                  v.value = ValuePool::StateView(v.value.empty() ? '0' : v.value.front());
+                  continue;
+               }
+               auto it = interned.find(v.value);
+               if (it == interned.end())
+                  it = interned.insert(pool.Append(v.value)).first;
+               v.value = *it;
+            }
+         }
+         if (auto v = counters.Stop())
+            threadCounters[idx] = {"compact", static_cast<unsigned>(idx), *v};
+      };
+
+      std::vector<std::thread> workers;
+      for (std::size_t i = 1; i < nThreads; ++i)
+         workers.emplace_back(worker, i);
+      worker(0);
+      for (auto &t : workers)
+         t.join();
+      if (m_collectCounters)
+         m_loadStats.counters.insert(m_loadStats.counters.end(), threadCounters.begin(), threadCounters.end());
+
+      m_rss.peakBytes = ReadProcStatusBytes("VmHWM:");
+      std::string().swap(m_data);
+      m_rss.steadyBytes = ReadProcStatusBytes("VmRSS:");
+      m_loadStats.compactMs = MsSince(t0);
+   }
+
+   /*
+    * Необязательные индексы после загрузки тела (SetBuildChangeIndex,
+    * SetBuildStatsIndex). splits — границы временных диапазонов для потоков
+    * ChangeIndex; пустой вектор -> равные диапазоны [0, m_maxTimestamp].
+    */
+   /**  Префиксы RangeStats() по одному пину; сбрасываются в BuildIndexes(). */
+   struct Handle::RangeStatsCache
+   {
+      struct Entry
+      {
+         std::vector<PinValue> bitTimeline; //!< только для BitProxy: символ бита на каждое изменение шины
+         StatsIndex stats;
+      };
+
+      std::mutex mutex;
+      std::unordered_map<const IPinDescription *, std::unique_ptr<Entry>> entries;
+   };
+
+   void
+   Handle::BuildIndexes(std::vector<std::uint64_t> splits)
+   {
+      m_rangeStatsCache->entries.clear(); // ссылались на прежние шкалы
+      if (!m_buildChangeIndex && !m_buildStatsIndex)
+         return;
+      VCD_TRACE_SCOPE("Handle::BuildIndexes");
+      const auto t0 = Clock::now();
+      PhaseCounterScope counters(m_collectCounters); //!< только вызывающий поток
+
+      std::vector<const std::vector<PinValue> *> timelineById(m_pinById.size(), nullptr);
+      for (const auto &pin : m_pinById)
+      {
+         if (IsPinLoaded(*pin))
+            timelineById[pin->GetId()] = GetMutableTimeline(*pin);
+      }
+
+      if (m_buildChangeIndex)
+      {
+         if (splits.empty())
+         {
+            const std::uint64_t n = GetThreadBudget();
+            for (std::uint64_t i = 1; i < n; ++i)
+               splits.push_back(m_maxTimestamp / n * i);
+         }
+         m_changeIndex = std::make_unique<ChangeIndex>(ChangeIndex::Build(timelineById, std::move(splits)));
+      }
+
+      if (m_buildStatsIndex)
+      {
+         std::vector<StatsIndex::Source> sources(m_pinById.size());
+         for (const auto &pin : m_pinById)
+            sources[pin->GetId()] = {timelineById[pin->GetId()], pin->GetInitState()};
+         m_statsIndex = std::make_unique<StatsIndex>(StatsIndex::Build(sources, GetThreadBudget()));
+      }
+      m_loadStats.indexMs = MsSince(t0);
+      counters.Finish(m_loadStats.counters, "index");
+   }
+
+   StatsIndex
+   Handle::BuildPinStats(const IPinDescription &pin, std::vector<PinValue> &bitTimeline) const
+   {
+      const std::vector<PinValue> *timeline = nullptr;
+      std::string initState = pin.GetInitState();
+      if (const auto *proxy = dynamic_cast<const BusPinDescription::BitProxy *>(&pin))
+      {
+         if (IsPinLoaded(*proxy->parent))
+         {
+            /* символ бита, как его отдаёт GetValueChar(); изменения других битов выпадают */
+            char prev = initState.empty() ? '\0' : initState.front();
+            for (const PinValue &v : proxy->parent->GetTimeline())
+            {
+               const char c = proxy->GetValueChar(v.timestamp);
+               if (c != prev)
+                  bitTimeline.push_back(PinValue{.timestamp = v.timestamp, .value = ValuePool::StateView(c)});
+               prev = c;
+            }
+            timeline = &bitTimeline;
+         }
+         initState.resize(std::min<std::size_t>(initState.size(), 1));
+      }
+      else if (pin.GetPinType() != PinType::parameter && IsPinLoaded(pin))
+      {
+         if (pin.GetSignalType() == SignalType::simple)
+            timeline = &static_cast<const SimplePinDescription &>(pin).GetTimeline();
+         else
+            timeline = &static_cast<const BusPinDescription &>(pin).GetTimeline();
+      }
+      return StatsIndex::Build({{timeline, std::move(initState)}}, 1);
+   }
+
+   SignalStats
+   Handle::RangeStats(const IPinDescription &pin, std::uint64_t t0, std::uint64_t t1) const
+   {
+      /* BitProxy не имеет собственного id — ему индекс не подходит */
+      if (m_statsIndex && GetPinById(pin.GetId()).get() == &pin)
+         return m_statsIndex->Query(pin.GetId(), t0, t1);
+
+      /* узлы map не двигаются до следующей загрузки: запрос идёт без блокировки */
+      auto &cache = *m_rangeStatsCache;
+      const StatsIndex *stats = nullptr;
+      {
+         std::lock_guard<std::mutex> lock(cache.mutex);
+         if (const auto it = cache.entries.find(&pin); it != cache.entries.end())
+            stats = &it->second->stats;
+      }
+      if (!stats)
+      {
+         /* O(n) один раз на пин и вне блокировки; проигравший гонку поток свою копию выбрасывает */
+         auto built = std::make_unique<RangeStatsCache::Entry>();
+         built->stats = BuildPinStats(pin, built->bitTimeline);
+         std::lock_guard<std::mutex> lock(cache.mutex);
+         stats = &cache.entries.try_emplace(&pin, std::move(built)).first->second->stats;
+      }
+      return stats->Query(0, t0, t1);
+   }
+
+   std::vector<SignalStats>
+   Handle::RangeStats(const IPinDescription &pin, const std::vector<std::pair<std::uint64_t, std::uint64_t>> &windows) const
+   {
+      std::vector<SignalStats> out;
+      out.reserve(windows.size());
+      if (m_statsIndex && GetPinById(pin.GetId()).get() == &pin)
+      {
+         for (const auto &[t0, t1] : windows)
+            out.push_back(m_statsIndex->Query(pin.GetId(), t0, t1));
+         return out;
+      }
+
+      std::vector<PinValue> bitTimeline;
+      const StatsIndex stats = BuildPinStats(pin, bitTimeline);
+      for (const auto &[t0, t1] : windows)
+         out.push_back(stats.Query(0, t0, t1));
+      return out;
+   }
+
+   SignalStats
+   Handle::RangeStats(std::string_view alias, std::uint64_t t0, std::uint64_t t1) const
+   {
+      auto pin = GetPinByAlias(alias);
+      return pin ? RangeStats(*pin, t0, t1) : SignalStats{};
+   }
+
+   MemoryBreakdown
+   Handle::MemoryUsage(std::size_t topN) const
+   {
+      /* make_shared: счётчики use/weak + vptr управляющего блока */
+      constexpr std::size_t kControlBlock = 2 * sizeof(long) + sizeof(void *);
+      const std::size_t ssoCapacity = std::string().capacity();
+      auto heapOf = [&](const std::string &s) -> std::size_t
+      { return s.capacity() > ssoCapacity ? s.capacity() + 1 : 0; };
+
+      MemoryBreakdown m;
+      m.rawBuffer = heapOf(m_data);
+      for (const auto &pool : m_pools)
+         m.valuePools += pool.GetBytes();
+      if (m_changeIndex)
+         m.changeIndex = m_changeIndex->GetBytes();
+      if (m_statsIndex)
+         m.statsIndex = m_statsIndex->GetBytes();
+
+      /*------------- пины и их шкалы ---------------------------*/
+      std::vector<MemoryBreakdown::Signal> signals;
+      signals.reserve(m_pinById.size());
+      for (const auto &pin : m_pinById)
+      {
+         std::size_t object = 0;
+         const std::vector<PinValue> *timeline = nullptr;
+         if (pin->GetPinType() == PinType::parameter)
+         {
+            object = sizeof(ParamPinDescription);
+         }
+         else if (pin->GetSignalType() == SignalType::simple)
+         {
+            object = sizeof(SimplePinDescription);
+            timeline = &static_cast<const SimplePinDescription &>(*pin).m_values;
+         }
+         else
+         {
+            const auto &bus = static_cast<const BusPinDescription &>(*pin);
+            object = sizeof(BusPinDescription);
+            /* подпины, которые GetSubPins() строит в другом потоке, пропускаем */
+            if (bus.m_subpinsReady.load(std::memory_order_acquire))
+               object += bus.m_subpins.capacity() * sizeof(bus.m_subpins[0]) +
+                         bus.m_subpins.size() * (sizeof(BusPinDescription::BitProxy) + kControlBlock);
+            timeline = &bus.m_values;
+         }
+         m.hierarchy += object + kControlBlock + heapOf(pin->m_alias) + heapOf(pin->m_name) + heapOf(pin->m_initState);
+
+         if (!timeline)
+            continue;
+         const std::size_t bytes = timeline->capacity() * sizeof(PinValue);
+         (pin->GetSignalType() == SignalType::simple ? m.simpleTimelines : m.busTimelines) += bytes;
+         signals.push_back({pin, timeline->size(), bytes});
+      }
+
+      /*------------- дерево модулей и таблицы поиска ------------*/
+      auto walk = [&](auto &&self, const Module &module) -> void
+      {
+         m.hierarchy += sizeof(Module) + kControlBlock + heapOf(module.m_moduleName) +
+                        module.m_pins.capacity() * sizeof(PinDescriptionPtr) +
+                        module.m_subModules.capacity() * sizeof(std::shared_ptr<Module>);
+         for (const auto &sub : module.m_subModules)
+            self(self, *sub);
+      };
+      if (m_root)
+         walk(walk, *m_root);
+
+      /* узел unordered_map: next + кэш хэша + пара */
+      m.hierarchy += m_alias2pin.size() * (sizeof(decltype(m_alias2pin)::value_type) + 2 * sizeof(void *)) +
+                     m_alias2pin.bucket_count() * sizeof(void *) +
+                     (m_pins.capacity() + m_pinById.capacity()) * sizeof(PinDescriptionPtr) +
+                     m_keep.capacity();
+
+      /*------------- самые тяжёлые сигналы ---------------------*/
+      const std::size_t n = std::min(topN, signals.size());
+      std::partial_sort(signals.begin(), signals.begin() + static_cast<std::ptrdiff_t>(n), signals.end(),
+                        [](const MemoryBreakdown::Signal &a, const MemoryBreakdown::Signal &b)
+                        { return a.bytes > b.bytes; });
+      signals.resize(n);
+      m.largest = std::move(signals);
+      return m;
+   }
+
+   std::ostream &
+   operator<<(std::ostream &os, const MemoryBreakdown &m)
+   {
+      auto row = [&](const char *name, std::size_t bytes)
+      {
+         os << "  " << std::left << std::setw(18) << name << std::right << std::setw(12) << bytes << " B  "
+            << std::fixed << std::setprecision(2) << std::setw(9) << bytes / (1024.0 * 1024.0) << " MiB\n";
+      };
+      os << "memory usage:\n";
+      row("raw buffer", m.rawBuffer);
+      row("simple timelines", m.simpleTimelines);
+      row("bus timelines", m.busTimelines);
+      row("value pools", m.valuePools);
+      row("hierarchy", m.hierarchy);
+      row("change index", m.changeIndex);
+      row("stats index", m.statsIndex);
+      row("total", m.Total());
+      if (!m.largest.empty())
+         os << "largest signals:\n";
+      for (const auto &s : m.largest)
+      {
+         os << "  " << std::left << std::setw(8) << s.pin->GetAlias() << ' ' << std::setw(24) << s.pin->GetName()
+            << std::right << std::setw(10) << s.changes << " changes " << std::setw(12) << s.bytes << " B\n";
+      }
+      return os;
+   }
+
+   Handle::Handle()
+       : m_rangeStatsCache(std::make_unique<RangeStatsCache>())
+   {
+   }
+
+   unsigned
+   Handle::GetThreadBudget() const noexcept
+   {
+      const unsigned hw = std::thread::hardware_concurrency();
+      const unsigned all = hw ? hw : 4;
+      return m_maxThreads ? std::min(all, m_maxThreads) : all;
+   }
+
+   void
+   Handle::FinishLoadStats(std::string_view loader, unsigned threads, Clock::time_point bodyStart)
+   {
+      m_loadStats.loader = loader;
+      m_loadStats.threads = threads;
+      m_loadStats.bytes = m_size;
+      m_loadStats.changes = 0;
+      for (const auto &pin : m_pinById)
+      {
+         if (const auto *timeline = GetMutableTimeline(*pin))
+            m_loadStats.changes += timeline->size();
+      }
+      m_loadStats.bodyMs = MsSince(bodyStart);
+      m_loadStats.totalMs = MsSince(m_loadStats.openedAt);
    }
 
    Handle::~Handle()
@@ -0,0 +1,140 @@
+#include "Include/VcdReport.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <thread>
+#include <utility>
+
+namespace vcd
+{
+   Report
+   BuildReport(const Handle &handle, const ReportOptions &opt)
+   {
+      Report rep;
+      rep.windows = opt.windows;
+      if (rep.windows.empty())
+         rep.windows.push_back({0, handle.GetMaxTs()});
+      const std::size_t nWin = rep.windows.size();
+      rep.totalToggles.assign(nWin, 0);
+
+      /*------------- 1. дерево -> массив в порядке обхода ------*/
+      std::vector<const Module *> modules;
+      if (const auto root = handle.GetRootModule())
+      {
+         std::vector<std::pair<const Module *, std::size_t>> stack{{root.get(), SIZE_MAX}};
+         while (!stack.empty())
+         {
+            const auto [module, parent] = stack.back();
+            stack.pop_back();
+
+            ModuleReport m;
+            m.parent = parent;
+            if (parent != SIZE_MAX)
+            {
+               m.depth = rep.modules[parent].depth + 1;
+               m.path.reserve(rep.modules[parent].path.size() + 1 + module->GetName().size());
+               m.path = rep.modules[parent].path;
+               m.path += '.';
+            }
+            m.path += module->GetName();
+            m.toggles.assign(nWin, 0);
+
+            const std::size_t idx = rep.modules.size();
+            rep.modules.push_back(std::move(m));
+            modules.push_back(module);
+
+            const auto &subs = module->subModules();
+            for (auto it = subs.rbegin(); it != subs.rend(); ++it)
+               stack.emplace_back(it->get(), idx);
+         }
+      }
+
+      /*------------- 2. сигналы: участки массива по потокам ---*/
+      const std::size_t nModules = modules.size();
+      std::vector<std::vector<SignalReport>> rows(nModules);
+
+      const unsigned hw = std::thread::hardware_concurrency();
+      const std::size_t nThreads = std::clamp<std::size_t>(opt.threads ? opt.threads : (hw ? hw : 4),
+                                                           1, std::max<std::size_t>(nModules, 1));
+      /* участки подряд идущих модулей — поддеревья или их части */
+      const std::size_t block = std::max<std::size_t>(1, nModules / (nThreads * 8));
+      std::atomic<std::size_t> next{0};
+      std::atomic<std::size_t> done{0};
+
+      std::vector<std::pair<std::uint64_t, std::uint64_t>> windows;
+      for (const TimeWindow &w : rep.windows)
+         windows.emplace_back(w.t0, w.t1);
+
+      auto processModule = [&](std::size_t i)
+      {
+         ModuleReport &m = rep.modules[i];
+         for (const auto &pin : modules[i]->GetPins())
+         {
+            if (pin->GetPinType() == PinType::parameter)
+               continue;
+            ++m.signalCount;
+
+            SignalReport row{i, pin, handle.RangeStats(*pin, windows)};
+            for (std::size_t w = 0; w < nWin; ++w)
+               m.toggles[w] += row.stats[w].toggles;
+            if (opt.signalRows)
+               rows[i].push_back(std::move(row));
+         }
+         if (opt.moduleReady)
+            opt.moduleReady(i, m, rows[i]);
+      };
+
+      auto worker = [&](std::size_t)
+      {
+         for (;;)
+         {
+            const std::size_t beg = next.fetch_add(block);
+            if (beg >= nModules)
+               return;
+            const std::size_t end = std::min(beg + block, nModules);
+            for (std::size_t i = beg; i < end; ++i)
+               processModule(i);
+            const std::size_t nDone = done.fetch_add(end - beg) + (end - beg);
+            if (opt.progress)
+               opt.progress(nDone, nModules);
+         }
+      };
+
+      std::vector<std::thread> workers;
+      for (std::size_t i = 1; i < nThreads; ++i)
+         workers.emplace_back(worker, i);
+      worker(0);
+      for (auto &t : workers)
+         t.join();
+
+      /*------------- 3. суммы поддеревьев: дети после родителя */
+      for (auto &m : rep.modules)
+         m.subtreeToggles = m.toggles;
+      for (std::size_t i = nModules; i-- > 1;)
+      {
+         const auto &m = rep.modules[i];
+         if (m.parent == SIZE_MAX)
+            continue;
+         auto &dst = rep.modules[m.parent].subtreeToggles;
+         for (std::size_t w = 0; w < nWin; ++w)
+            dst[w] += m.subtreeToggles[w];
+      }
+      for (const auto &m : rep.modules)
+      {
+         for (std::size_t w = 0; w < nWin; ++w)
+            rep.totalToggles[w] += m.toggles[w];
+      }
+
+      /*------------- 4. строки сигналов в порядке модулей -----*/
+      std::size_t nRows = 0;
+      for (const auto &r : rows)
+         nRows += r.size();
+      rep.signals.reserve(nRows);
+      for (auto &r : rows)
+      {
+         std::move(r.begin(), r.end(), std::back_inserter(rep.signals));
+      }
+      return rep;
+   }
+} // namespace vcd
@@ -0,0 +1,194 @@
+#include "Include/VcdStatsIndex.hpp"
+
+#include <algorithm>
+#include <string_view>
+#include <thread>
+
+namespace vcd
+{
+   namespace
+   {
+      enum StateClass : std::uint8_t
+      {
+         kLow = 0,
+         kHigh,
+         kX,
+         kZ
+      };
+
+      std::uint8_t
+      Classify(std::string_view v)
+      {
+         if (v.empty())
+            return kX; // состояние неизвестно (нет $dumpvars)
+         bool hasZ = false;
+         bool allZero = true;
+         for (char c : v)
+         {
+            switch (c)
+            {
+            case '0':
+               break;
+            case '1':
+               allZero = false;
+               break;
+            case 'z':
+            case 'Z':
+               hasZ = true;
+               break;
+            default: // x, u, w, -, …
+               return kX;
+            }
+         }
+         if (hasZ)
+            return kZ;
+         return allZero ? kLow : kHigh;
+      }
+
+      /* значение шины без расширения слева: "0001" == "1", "xx0" == "x0" */
+      std::string_view
+      Normalize(std::string_view v)
+      {
+         if (v.size() < 2)
+            return v;
+         const char lead = v.front();
+         if (lead != '0' && lead != 'x' && lead != 'X' && lead != 'z' && lead != 'Z')
+            return v;
+         std::size_t i = 0;
+         while (i + 1 < v.size() && v[i + 1] == lead)
+            ++i;
+         if (lead == '0' && i + 1 < v.size() && v[i + 1] == '1')
+            ++i; // "01…" — тот же "1…"
+         return v.substr(i);
+      }
+   } // namespace
+
+   StatsIndex
+   StatsIndex::Build(const std::vector<Source> &byId, unsigned threads)
+   {
+      StatsIndex idx;
+      idx.m_series.resize(byId.size());
+
+      auto buildOne = [&](std::size_t id)
+      {
+         Series &s = idx.m_series[id];
+         s.timeline = byId[id].timeline;
+         s.initClass = Classify(byId[id].initState);
+         if (!s.timeline)
+            return;
+
+         const auto &tl = *s.timeline;
+         s.prefix.resize(tl.size());
+         Prefix acc;
+         std::uint64_t prevTs = 0;
+         std::uint8_t prevClass = s.initClass;
+         std::string_view prevVal = Normalize(byId[id].initState);
+         for (std::size_t i = 0; i < tl.size(); ++i)
+         {
+            const std::uint64_t dt = tl[i].timestamp - prevTs;
+            if (prevClass == kHigh)
+               acc.timeHigh += dt;
+            else if (prevClass == kLow)
+               acc.timeLow += dt;
+            else if (prevClass == kX)
+               acc.timeX += dt;
+
+            const std::uint8_t cls = Classify(tl[i].value);
+            if (Normalize(tl[i].value) != prevVal)
+               ++acc.toggles;
+            if (prevClass == kLow && cls == kHigh)
+               ++acc.rises;
+            else if (prevClass == kHigh && cls == kLow)
+               ++acc.falls;
+
+            s.prefix[i] = acc;
+            prevTs = tl[i].timestamp;
+            prevClass = cls;
+            prevVal = Normalize(tl[i].value);
+         }
+      };
+
+      const unsigned hw = std::thread::hardware_concurrency();
+      const std::size_t nThreads = std::clamp<std::size_t>(threads ? threads : (hw ? hw : 4), 1, std::max<std::size_t>(byId.size(), 1));
+      auto worker = [&](std::size_t t)
+      {
+         for (std::size_t id = t; id < byId.size(); id += nThreads)
+            buildOne(id);
+      };
+
+      std::vector<std::thread> workers;
+      for (std::size_t i = 1; i < nThreads; ++i)
+         workers.emplace_back(worker, i);
+      worker(0);
+      for (auto &t : workers)
+         t.join();
+      return idx;
+   }
+
+   StatsIndex::Cumulative
+   StatsIndex::At(const Series &s, std::uint64_t t, std::size_t m)
+   {
+      Cumulative c;
+      if (m == 0)
+      {
+         c.time[s.initClass] = t;
+         return c;
+      }
+
+      const PinValue &last = (*s.timeline)[m - 1];
+      const Prefix &p = s.prefix[m - 1];
+      c.time[kHigh] = p.timeHigh;
+      c.time[kLow] = p.timeLow;
+      c.time[kX] = p.timeX;
+      c.time[kZ] = last.timestamp - p.timeHigh - p.timeLow - p.timeX;
+      c.time[Classify(last.value)] += t - last.timestamp;
+      c.toggles = p.toggles;
+      c.rises = p.rises;
+      c.falls = p.falls;
+      return c;
+   }
+
+   SignalStats
+   StatsIndex::Query(std::uint32_t id, std::uint64_t t0, std::uint64_t t1) const
+   {
+      SignalStats st;
+      if (id >= m_series.size() || t1 < t0)
+         return st;
+
+      const Series &s = m_series[id];
+      std::size_t m0 = 0, m1 = 0;
+      if (s.timeline)
+      {
+         const auto &tl = *s.timeline;
+         auto byTs = [](const PinValue &v, std::uint64_t t)
+         { return v.timestamp < t; };
+         /* изменения ровно в t0 входят в окно */
+         m0 = static_cast<std::size_t>(std::lower_bound(tl.begin(), tl.end(), t0, byTs) - tl.begin());
+         m1 = static_cast<std::size_t>(std::upper_bound(tl.begin() + m0, tl.end(), t1,
+                                                        [](std::uint64_t t, const PinValue &v)
+                                                        { return t < v.timestamp; }) -
+                                       tl.begin());
+      }
+
+      const Cumulative a = At(s, t0, m0);
+      const Cumulative b = At(s, t1, m1);
+      st.duration = t1 - t0;
+      st.toggles = b.toggles - a.toggles;
+      st.rises = b.rises - a.rises;
+      st.falls = b.falls - a.falls;
+      st.timeLow = b.time[kLow] - a.time[kLow];
+      st.timeHigh = b.time[kHigh] - a.time[kHigh];
+      st.timeX = b.time[kX] - a.time[kX];
+      st.timeZ = b.time[kZ] - a.time[kZ];
+      return st;
+   }
+
+   std::size_t
+   StatsIndex::GetBytes() const noexcept
+   {
+      std::size_t bytes = m_series.capacity() * sizeof(Series);
+      for (const auto &s : m_series)
+         bytes += s.prefix.capacity() * sizeof(Prefix);
+      return bytes;
+   }
+} // namespace vcd
@@ -0,0 +1,184 @@
+#include "Include/VcdTrace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace vcd::trace
+{
+   namespace
+   {
+      struct Event
+      {
+         const char *name;
+         std::uint64_t beginNs;
+         std::uint64_t endNs;
+      };
+
+      /* буфер одного потока; переживает поток, пока трасса не записана */
+      struct ThreadBuffer
+      {
+         std::uint32_t tid = 0;
+         std::mutex mtx; //!< владелец пишет, WriteJson/Clear читают
+         std::string name;
+         std::vector<Event> events;
+      };
+
+      struct Registry
+      {
+         std::mutex mtx;
+         std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+         std::atomic<std::uint32_t> nextTid{1};
+      };
+
+      Registry &
+      GetRegistry()
+      {
+         static Registry registry;
+         return registry;
+      }
+
+      ThreadBuffer &
+      LocalBuffer()
+      {
+         thread_local std::shared_ptr<ThreadBuffer> local = []
+         {
+            auto buf = std::make_shared<ThreadBuffer>();
+            Registry &reg = GetRegistry();
+            buf->tid = reg.nextTid++;
+            buf->events.reserve(1024);
+            std::lock_guard lock(reg.mtx);
+            reg.buffers.push_back(buf);
+            return buf;
+         }();
+         return *local;
+      }
+
+      void
+      PutEscaped(std::ostream &out, std::string_view s)
+      {
+         for (char c : s)
+         {
+            if (c == '"' || c == '\\')
+               out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20)
+               out << ' ';
+            else
+               out << c;
+         }
+      }
+   } // namespace
+
+   bool
+   IsCompiledIn() noexcept
+   {
+#ifdef VCD_ENABLE_TRACE
+      return true;
+#else
+      return false;
+#endif
+   }
+
+   std::uint64_t
+   NowNs() noexcept
+   {
+      static const auto epoch = std::chrono::steady_clock::now();
+      return static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+   }
+
+   void
+   SetThreadName(std::string_view name)
+   {
+      ThreadBuffer &buf = LocalBuffer();
+      std::lock_guard lock(buf.mtx);
+      buf.name.assign(name);
+   }
+
+   void
+   Record(const char *name, std::uint64_t beginNs, std::uint64_t endNs)
+   {
+      ThreadBuffer &buf = LocalBuffer();
+      std::lock_guard lock(buf.mtx);
+      buf.events.push_back({name, beginNs, endNs});
+   }
+
+   void
+   Clear()
+   {
+      Registry &reg = GetRegistry();
+      std::lock_guard lock(reg.mtx);
+      for (auto &buf : reg.buffers)
+      {
+         std::lock_guard bufLock(buf->mtx);
+         buf->events.clear();
+      }
+      /* буферы завершившихся потоков больше не нужны */
+      reg.buffers.erase(std::remove_if(reg.buffers.begin(), reg.buffers.end(),
+                                       [](const auto &b)
+                                       { return b.use_count() == 1; }),
+                        reg.buffers.end());
+   }
+
+   /*
+    * {"traceEvents": [...]}: "X" — интервал с длительностью,
+    * "M"/thread_name — подпись дорожки. Время — микросекунды.
+    */
+   std::size_t
+   WriteJson(const std::filesystem::path &path)
+   {
+      std::ofstream out(path, std::ios::binary | std::ios::trunc);
+      if (!out)
+         throw std::system_error(errno, std::generic_category(), "Can't create " + path.string());
+
+      std::size_t written = 0;
+      bool first = true;
+      auto separator = [&]
+      {
+         out << (first ? "\n" : ",\n");
+         first = false;
+      };
+
+      out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+      Registry &reg = GetRegistry();
+      std::lock_guard lock(reg.mtx);
+      for (const auto &buf : reg.buffers)
+      {
+         std::lock_guard bufLock(buf->mtx);
+         if (buf->events.empty())
+            continue;
+         if (!buf->name.empty())
+         {
+            separator();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buf->tid
+                << ",\"args\":{\"name\":\"";
+            PutEscaped(out, buf->name);
+            out << "\"}}";
+         }
+         for (const Event &e : buf->events)
+         {
+            separator();
+            out << "{\"name\":\"";
+            PutEscaped(out, e.name);
+            out << "\",\"cat\":\"vcd\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buf->tid
+                << ",\"ts\":" << e.beginNs / 1000 << '.' << (e.beginNs % 1000) / 100
+                << ",\"dur\":" << (e.endNs - e.beginNs) / 1000 << '.' << ((e.endNs - e.beginNs) % 1000) / 100
+                << '}';
+            ++written;
+         }
+      }
+      out << "\n]}\n";
+
+      out.flush();
+      if (!out)
+         throw std::system_error(errno, std::generic_category(), "Can't write " + path.string());
+      return written;
+   }
+} // namespace vcd::trace
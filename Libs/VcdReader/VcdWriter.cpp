@@ -0,0 +1,351 @@
+#include "Include/VcdWriter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <queue>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace vcd
+{
+   namespace
+   {
+      /* буфер + крупные write() в файловый дескриптор */
+      class FileSink
+      {
+      public:
+         FileSink(const std::filesystem::path &path, std::size_t bufferBytes)
+             : m_path(path), m_limit(std::max<std::size_t>(bufferBytes, 4096))
+         {
+            m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (m_fd < 0)
+               throw std::system_error(errno, std::generic_category(), "Can't create " + path.string());
+            m_buf.reserve(m_limit + 256);
+         }
+
+         ~FileSink()
+         {
+            if (m_fd >= 0)
+               ::close(m_fd);
+         }
+
+         FileSink(const FileSink &) = delete;
+         FileSink &operator=(const FileSink &) = delete;
+
+         void
+         Put(std::string_view s)
+         {
+            m_buf.append(s);
+            if (m_buf.size() >= m_limit)
+               Flush();
+         }
+
+         void
+         Put(char c)
+         {
+            m_buf.push_back(c);
+            if (m_buf.size() >= m_limit)
+               Flush();
+         }
+
+         void
+         PutNumber(std::uint64_t v)
+         {
+            char tmp[24];
+            const auto res = std::to_chars(tmp, tmp + sizeof(tmp), v);
+            Put(std::string_view(tmp, static_cast<std::size_t>(res.ptr - tmp)));
+         }
+
+         void
+         Flush()
+         {
+            std::size_t off = 0;
+            while (off < m_buf.size())
+            {
+               const ssize_t n = ::write(m_fd, m_buf.data() + off, m_buf.size() - off);
+               if (n < 0 && errno == EINTR)
+                  continue;
+               if (n < 0)
+                  throw std::system_error(errno, std::generic_category(), "Can't write " + m_path.string());
+               off += static_cast<std::size_t>(n);
+            }
+            m_written += m_buf.size();
+            m_buf.clear();
+         }
+
+         /**  Сбрасывает буфер и закрывает файл (ошибки close тоже видны). */
+         std::uint64_t
+         Close()
+         {
+            Flush();
+            const int fd = m_fd;
+            m_fd = -1;
+            if (::close(fd) != 0)
+               throw std::system_error(errno, std::generic_category(), "Can't write " + m_path.string());
+            return m_written;
+         }
+
+      private:
+         std::filesystem::path m_path;
+         std::size_t m_limit;
+         int m_fd = -1;
+         std::string m_buf;
+         std::uint64_t m_written = 0;
+      };
+
+      std::string_view
+      TypeKeyword(PinType t)
+      {
+         switch (t)
+         {
+         case PinType::integer:
+            return "integer";
+         case PinType::reg:
+            return "reg";
+         case PinType::parameter:
+            return "parameter";
+         default:
+            return "wire";
+         }
+      }
+
+      const std::vector<PinValue> *
+      TimelineOf(const IPinDescription &pin)
+      {
+         if (pin.GetPinType() == PinType::parameter)
+            return nullptr;
+         if (pin.GetSignalType() == SignalType::simple)
+            return &static_cast<const SimplePinDescription &>(pin).GetTimeline();
+         return &static_cast<const BusPinDescription &>(pin).GetTimeline();
+      }
+
+      /* "0!" для 1 бита, "b0101 !" для шин */
+      void
+      PutValue(FileSink &out, const IPinDescription &pin, std::string_view value)
+      {
+         if (pin.GetSignalType() == SignalType::simple && value.size() <= 1)
+         {
+            out.Put(value.empty() ? 'x' : value.front());
+         }
+         else
+         {
+            out.Put('b');
+            out.Put(value);
+            out.Put(' ');
+         }
+         out.Put(pin.GetAlias());
+         out.Put('\n');
+      }
+   } // namespace
+
+   /*
+    * 1. обход дерева: заголовок выбранных модулей + список уникальных пинов;
+    * 2. $dumpvars под #0 — значения в t0;
+    * 3. куча курсоров (ts, порядковый номер пина, позиция в шкале) —
+    *    изменения из (t0, t1] по возрастанию времени.
+    */
+   WriteResult
+   WriteVcd(const Handle &handle, const std::filesystem::path &outPath, const WriteOptions &opt)
+   {
+      const std::uint64_t t0 = opt.t0;
+      const std::uint64_t t1 = std::min(opt.t1, handle.GetMaxTs());
+
+      std::unordered_set<const Module *> scopes;
+      for (const auto &m : opt.scopes)
+         scopes.insert(m.get());
+      std::unordered_set<const IPinDescription *> picked;
+      for (const auto &p : opt.signals)
+         picked.insert(p.get());
+      const bool all = scopes.empty() && picked.empty();
+
+      FileSink out(outPath, opt.bufferBytes);
+      WriteResult res;
+
+      /*------------- 1. заголовок ------------------------------*/
+      out.Put("$date\n\t");
+      out.Put(handle.GetDate());
+      out.Put("\n$end\n$version\n\t");
+      out.Put(handle.GetVersion());
+      out.Put("\n$end\n$comment\n\tExtracted window ");
+      out.PutNumber(t0);
+      out.Put(" - ");
+      out.PutNumber(t1);
+      out.Put("\n$end\n$timescale\n\t");
+      out.Put(handle.GetTimeScale());
+      out.Put("\n$end\n");
+
+      std::vector<const IPinDescription *> pins; //!< уникальные alias в порядке появления
+      std::unordered_set<const IPinDescription *> seen;
+
+      /* модуль пишется, только если в его поддереве есть выбранные пины */
+      std::string header;
+      auto walk = [&](auto &&self, const Module &module, bool inScope) -> bool
+      {
+         inScope = inScope || all || scopes.count(&module);
+         const std::size_t mark = header.size();
+         header += "$scope module ";
+         header += module.GetName();
+         header += " $end\n";
+
+         bool any = false;
+         for (const auto &pin : module.GetPins())
+         {
+            if (!inScope && !picked.count(pin.get()))
+               continue;
+            any = true;
+
+            std::size_t width = 1;
+            if (pin->GetPinType() == PinType::parameter)
+               width = std::max<std::size_t>(1, pin->GetInitState().size());
+            else if (pin->GetSignalType() == SignalType::bus)
+            {
+               const auto [msb, lsb] = static_cast<const BusPinDescription &>(*pin).GetBitDepth();
+               width = (msb > lsb ? msb - lsb : lsb - msb) + 1;
+            }
+
+            header += "$var ";
+            header += TypeKeyword(pin->GetPinType());
+            header += ' ';
+            header += std::to_string(width);
+            header += ' ';
+            header += pin->GetAlias();
+            header += ' ';
+            header += pin->GetName();
+            if (pin->GetSignalType() == SignalType::bus && pin->GetPinType() != PinType::parameter)
+            {
+               const auto [msb, lsb] = static_cast<const BusPinDescription &>(*pin).GetBitDepth();
+               header += " [" + std::to_string(msb) + ':' + std::to_string(lsb) + ']';
+            }
+            header += " $end\n";
+
+            if (seen.insert(pin.get()).second)
+               pins.push_back(pin.get());
+         }
+         for (const auto &sub : module.subModules())
+            any = self(self, *sub, inScope) || any;
+
+         if (!any)
+         {
+            header.resize(mark);
+            return false;
+         }
+         header += "$upscope $end\n";
+         return true;
+      };
+      if (const auto root = handle.GetRootModule())
+         walk(walk, *root, false);
+
+      out.Put(header);
+      out.Put("$enddefinitions $end\n");
+      res.signals = pins.size();
+
+      /*------------- 2. состояние в t0 -------------------------*/
+      /* под #0: Init() относит к заголовку всё до первого ненулевого #, так
+         значения в t0 становятся начальными состояниями и при t0 > 0 */
+      out.Put("#0\n$dumpvars\n");
+      for (const IPinDescription *pin : pins)
+      {
+         if (pin->GetPinType() == PinType::parameter)
+            PutValue(out, *pin, pin->GetInitState());
+         else if (pin->GetSignalType() == SignalType::simple)
+         {
+            /* GetValueChar() без изменений отдаёт '0' — до первого изменения пишем начальное состояние */
+            const auto *tl = TimelineOf(*pin);
+            if (!tl || tl->empty() || t0 < tl->front().timestamp)
+            {
+               PutValue(out, *pin, pin->GetInitState());
+               continue;
+            }
+            const char c = pin->GetValueChar(t0);
+            PutValue(out, *pin, std::string_view(&c, 1));
+         }
+         else
+            PutValue(out, *pin, pin->GetValueBus(t0));
+      }
+      out.Put("$end\n");
+
+      /* $dumpoff/$dumpon внутри окна: (ts, true — off) */
+      std::vector<std::pair<std::uint64_t, bool>> dumpEvents;
+      for (const auto &[beg, end] : handle.GetDumpoffIntervals())
+      {
+         if (beg <= t0 && end > t0)
+            dumpEvents.emplace_back(t0, true);
+         else if (beg > t0 && beg <= t1)
+            dumpEvents.emplace_back(beg, true);
+         if (end > t0 && end <= t1)
+            dumpEvents.emplace_back(end, false);
+      }
+      std::sort(dumpEvents.begin(), dumpEvents.end());
+      std::size_t nextEvent = 0;
+
+      /*------------- 3. k-путевое слияние ----------------------*/
+      struct Cursor
+      {
+         std::uint64_t ts;
+         std::uint32_t order; //!< индекс в pins — стабильный порядок при равных ts
+         std::size_t pos;
+      };
+      auto later = [](const Cursor &a, const Cursor &b)
+      { return a.ts != b.ts ? a.ts > b.ts : a.order > b.order; };
+      std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heap(later);
+
+      std::vector<const std::vector<PinValue> *> timelines(pins.size(), nullptr);
+      for (std::size_t i = 0; i < pins.size(); ++i)
+      {
+         const auto *tl = TimelineOf(*pins[i]);
+         if (!tl || !handle.IsPinLoaded(*pins[i]))
+            continue;
+         timelines[i] = tl;
+         auto it = std::upper_bound(tl->begin(), tl->end(), t0,
+                                    [](std::uint64_t t, const PinValue &v)
+                                    { return t < v.timestamp; });
+         if (it != tl->end() && it->timestamp <= t1)
+            heap.push({it->timestamp, static_cast<std::uint32_t>(i), static_cast<std::size_t>(it - tl->begin())});
+      }
+
+      std::uint64_t curTs = 0;
+      auto emitTs = [&](std::uint64_t ts)
+      {
+         if (ts == curTs)
+            return;
+         curTs = ts;
+         out.Put('#');
+         out.PutNumber(ts);
+         out.Put('\n');
+      };
+      auto emitDumpEvents = [&](std::uint64_t upTo)
+      {
+         for (; nextEvent < dumpEvents.size() && dumpEvents[nextEvent].first <= upTo; ++nextEvent)
+         {
+            emitTs(dumpEvents[nextEvent].first);
+            out.Put(dumpEvents[nextEvent].second ? "$dumpoff\n$end\n" : "$dumpon\n$end\n");
+         }
+      };
+
+      while (!heap.empty())
+      {
+         const Cursor c = heap.top();
+         heap.pop();
+
+         emitDumpEvents(c.ts);
+         emitTs(c.ts);
+         const auto &tl = *timelines[c.order];
+         PutValue(out, *pins[c.order], tl[c.pos].value);
+         ++res.changes;
+
+         if (c.pos + 1 < tl.size() && tl[c.pos + 1].timestamp <= t1)
+            heap.push({tl[c.pos + 1].timestamp, c.order, c.pos + 1});
+      }
+      emitDumpEvents(t1);
+      if (curTs < t1)
+         emitTs(t1); // конец окна виден читателю как GetMaxTs()
+
+      res.bytes = out.Close();
+      return res;
+   }
+} // namespace vcd
@@ -0,0 +1,360 @@
+#include "Commands.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+namespace
+{
+   using Clock = std::chrono::steady_clock;
+
+   double
+   MsSince(Clock::time_point t0)
+   {
+      return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+   }
+
+   std::unique_ptr<vcd::Handle>
+   Open(const std::filesystem::path &file, unsigned threads, bool statsIndex)
+   {
+      auto h = std::make_unique<vcd::Handle>();
+      h->Init(file);
+      h->LoadHdr();
+      h->SetMaxThreads(threads);
+      h->SetBuildStatsIndex(statsIndex);
+      h->LoadSignalsParallel();
+      return h;
+   }
+
+   const char *
+   TypeName(const vcd::IPinDescription &pin)
+   {
+      if (pin.GetPinType() == vcd::PinType::parameter)
+         return "parameter";
+      return pin.GetSignalType() == vcd::SignalType::simple ? "wire" : "bus";
+   }
+
+   std::size_t
+   TimelineSize(const vcd::IPinDescription &pin)
+   {
+      if (pin.GetPinType() == vcd::PinType::parameter)
+         return 0;
+      if (pin.GetSignalType() == vcd::SignalType::simple)
+         return static_cast<const vcd::SimplePinDescription &>(pin).GetTimeline().size();
+      return static_cast<const vcd::BusPinDescription &>(pin).GetTimeline().size();
+   }
+
+   /* полный путь "top.sub.sig" -> пин, обход дерева один раз */
+   std::unordered_map<std::string, vcd::PinDescriptionPtr>
+   PathMap(const vcd::Handle &h)
+   {
+      std::unordered_map<std::string, vcd::PinDescriptionPtr> map;
+      std::string path;
+      auto walk = [&](auto &&self, const vcd::Module &module) -> void
+      {
+         const std::size_t base = path.size();
+         if (!path.empty())
+            path += '.';
+         path += module.GetName();
+         for (const auto &pin : module.GetPins())
+            map.emplace(path + '.' + std::string(pin->GetName()), pin);
+         for (const auto &sub : module.subModules())
+            self(self, *sub);
+         path.resize(base);
+      };
+      if (const auto root = h.GetRootModule())
+         walk(walk, *root);
+      return map;
+   }
+
+   void
+   WriteStats(JsonWriter &out, const vcd::SignalStats &st)
+   {
+      out.BeginObject()
+          .Field("toggles", st.toggles)
+          .Field("rises", st.rises)
+          .Field("falls", st.falls)
+          .Field("timeHigh", st.timeHigh)
+          .Field("timeLow", st.timeLow)
+          .Field("timeX", st.timeX)
+          .Field("timeZ", st.timeZ)
+          .Field("duty", st.DutyCycle())
+          .EndObject();
+   }
+
+   /* аппаратные значения, недоступные ядру, пишутся как null */
+   void
+   WriteCounters(JsonWriter &out, const vcd::CounterValues &c)
+   {
+      auto hw = [&](std::string_view key, const std::optional<std::uint64_t> &v)
+      {
+         if (v)
+            out.Field(key, *v);
+         else
+            out.Key(key).Raw("null");
+      };
+      out.BeginObject();
+      hw("cycles", c.cycles);
+      hw("instructions", c.instructions);
+      hw("llcMisses", c.llcMisses);
+      hw("branchMisses", c.branchMisses);
+      out.Field("ipc", c.Ipc())
+          .Field("cpuTimeNs", c.cpuTimeNs)
+          .Field("pageFaults", c.pageFaults)
+          .Field("ctxSwitches", c.ctxSwitches)
+          .EndObject();
+   }
+
+   void
+   WritePhases(JsonWriter &out, const vcd::LoadStats &st)
+   {
+      out.BeginObject()
+          .Field("loader", st.loader)
+          .Field("threads", st.threads)
+          .Field("headerScanMs", st.headerScanMs)
+          .Field("tokenizeMs", st.tokenizeMs)
+          .Field("loadHdrMs", st.loadHdrMs)
+          .Field("readMs", st.readMs)
+          .Field("parseMs", st.parseMs)
+          .Field("mergeMs", st.mergeMs)
+          .Field("sortMs", st.sortMs)
+          .Field("compactMs", st.compactMs)
+          .Field("indexMs", st.indexMs)
+          .Field("changes", st.changes)
+          .Field("imbalance", st.Imbalance())
+          .Key("threadParseMs")
+          .BeginArray();
+      for (double ms : st.threadParseMs)
+         out.Value(ms);
+      out.EndArray();
+
+      if (!st.counters.empty())
+      {
+         out.Key("counters").BeginArray();
+         for (const auto &pc : st.counters)
+         {
+            out.BeginObject().Field("phase", pc.phase).Field("thread", pc.thread).Key("values");
+            WriteCounters(out, pc.values);
+            out.EndObject();
+         }
+         out.EndArray();
+      }
+      out.EndObject();
+   }
+
+   void
+   WriteMemory(JsonWriter &out, const vcd::MemoryBreakdown &m)
+   {
+      out.BeginObject()
+          .Field("rawBuffer", m.rawBuffer)
+          .Field("simpleTimelines", m.simpleTimelines)
+          .Field("busTimelines", m.busTimelines)
+          .Field("valuePools", m.valuePools)
+          .Field("hierarchy", m.hierarchy)
+          .Field("changeIndex", m.changeIndex)
+          .Field("statsIndex", m.statsIndex)
+          .Field("total", m.Total())
+          .Key("largest")
+          .BeginArray();
+      for (const auto &s : m.largest)
+      {
+         out.BeginObject()
+             .Field("alias", s.pin->GetAlias())
+             .Field("name", s.pin->GetName())
+             .Field("changes", s.changes)
+             .Field("bytes", s.bytes)
+             .EndObject();
+      }
+      out.EndArray().EndObject();
+   }
+} // namespace
+
+/*-------------------------------------------------------------------------*/
+void RunStats(const std::filesystem::path &file, const ToolOptions &, unsigned threads, JsonWriter &out)
+{
+   const auto h = Open(file, threads, false);
+
+   std::size_t modules = 0;
+   auto countModules = [&](auto &&self, const vcd::Module &m) -> void
+   {
+      ++modules;
+      for (const auto &sub : m.subModules())
+         self(self, *sub);
+   };
+   if (const auto root = h->GetRootModule())
+      countModules(countModules, *root);
+
+   std::size_t wires = 0, buses = 0, params = 0, changes = 0;
+   for (const auto &[alias, pin] : h->GetAlias2pinMap())
+   {
+      if (pin->GetPinType() == vcd::PinType::parameter)
+         ++params;
+      else if (pin->GetSignalType() == vcd::SignalType::simple)
+         ++wires;
+      else
+         ++buses;
+      changes += TimelineSize(*pin);
+   }
+
+   out.Field("fileSize", static_cast<std::uint64_t>(std::filesystem::file_size(file)))
+       .Field("date", h->GetDate())
+       .Field("version", h->GetVersion())
+       .Field("timescale", h->GetTimeScale())
+       .Field("maxTs", h->GetMaxTs())
+       .Field("modules", modules);
+   out.Key("signals")
+       .BeginObject()
+       .Field("total", h->GetAlias2pinMap().size())
+       .Field("wire", wires)
+       .Field("bus", buses)
+       .Field("parameter", params)
+       .EndObject();
+   out.Field("changes", changes)
+       .Field("dumpoffIntervals", h->GetDumpoffIntervals().size());
+}
+
+/*-------------------------------------------------------------------------*/
+void RunReport(const std::filesystem::path &file, const ToolOptions &opt, unsigned threads, JsonWriter &out)
+{
+   const auto h = Open(file, threads, true);
+
+   vcd::ReportOptions ropt;
+   ropt.windows = opt.windows;
+   ropt.signalRows = opt.signalRows;
+   ropt.threads = threads;
+   const vcd::Report rep = vcd::BuildReport(*h, ropt);
+
+   out.Field("timescale", h->GetTimeScale()).Key("windows").BeginArray();
+   for (const auto &w : rep.windows)
+      out.BeginArray().Value(w.t0).Value(w.t1).EndArray();
+   out.EndArray();
+
+   out.Key("totalToggles").BeginArray();
+   for (auto t : rep.totalToggles)
+      out.Value(t);
+   out.EndArray();
+
+   out.Key("modules").BeginArray();
+   for (const auto &m : rep.modules)
+   {
+      out.BeginObject().Field("path", m.path).Field("signals", m.signalCount);
+      out.Key("toggles").BeginArray();
+      for (auto t : m.toggles)
+         out.Value(t);
+      out.EndArray().Key("subtreeToggles").BeginArray();
+      for (auto t : m.subtreeToggles)
+         out.Value(t);
+      out.EndArray().EndObject();
+   }
+   out.EndArray();
+
+   if (!opt.signalRows)
+      return;
+   out.Key("signals").BeginArray();
+   for (const auto &s : rep.signals)
+   {
+      out.BeginObject()
+          .Field("path", rep.SignalPath(s))
+          .Field("type", TypeName(*s.pin))
+          .Key("windows")
+          .BeginArray();
+      for (const auto &st : s.stats)
+         WriteStats(out, st);
+      out.EndArray().EndObject();
+   }
+   out.EndArray();
+}
+
+/*-------------------------------------------------------------------------*/
+void RunValues(const std::filesystem::path &file, const ToolOptions &opt, unsigned threads, JsonWriter &out)
+{
+   const auto h = Open(file, threads, false);
+   const auto paths = PathMap(*h);
+
+   std::optional<vcd::PerfCounters> counters;
+   if (opt.counters)
+   {
+      counters.emplace();
+      counters->Start();
+   }
+   out.Key("signals").BeginArray();
+   for (const auto &name : opt.signals)
+   {
+      vcd::PinDescriptionPtr pin;
+      if (auto it = paths.find(name); it != paths.end())
+         pin = it->second;
+      else
+         pin = h->GetPinByAlias(name);
+
+      out.BeginObject().Field("name", name);
+      if (!pin)
+      {
+         out.Field("error", "not found").EndObject();
+         continue;
+      }
+      out.Field("alias", pin->GetAlias()).Field("type", TypeName(*pin)).Key("values").BeginArray();
+      for (auto ts : opt.times)
+         out.BeginArray().Value(ts).Value(pin->GetValueBus(ts)).EndArray();
+      out.EndArray().EndObject();
+   }
+   out.EndArray();
+
+   if (counters)
+   {
+      /* запросы и запись JSON в текущем потоке, без загрузки */
+      const vcd::CounterValues c = counters->Stop();
+      out.Key("queryCounters");
+      WriteCounters(out, c);
+   }
+}
+
+/*-------------------------------------------------------------------------*/
+void RunBench(const std::filesystem::path &file, const ToolOptions &opt, unsigned threads, JsonWriter &out)
+{
+   out.Field("fileSize", static_cast<std::uint64_t>(std::filesystem::file_size(file)))
+       .Field("threads", threads)
+       .Key("runs")
+       .BeginArray();
+
+   double best = 0.0;
+   vcd::MemoryBreakdown memory;
+   for (unsigned r = 0; r < std::max(1u, opt.repeat); ++r)
+   {
+      const auto t0 = Clock::now();
+      vcd::Handle h;
+      h.SetCollectCounters(opt.counters);
+      h.Init(file);
+      const double initMs = MsSince(t0);
+
+      auto t = Clock::now();
+      h.LoadHdr();
+      const double hdrMs = MsSince(t);
+
+      h.SetMaxThreads(threads);
+      t = Clock::now();
+      h.LoadSignalsParallel();
+      const double bodyMs = MsSince(t);
+      const double totalMs = MsSince(t0);
+      best = r ? std::min(best, totalMs) : totalMs;
+      memory = h.MemoryUsage();
+
+      out.BeginObject()
+          .Field("initMs", initMs)
+          .Field("headerMs", hdrMs)
+          .Field("bodyMs", bodyMs)
+          .Field("totalMs", totalMs)
+          .Field("peakRssBytes", h.GetRssInfo().peakBytes)
+          .Field("steadyRssBytes", h.GetRssInfo().steadyBytes)
+          .Key("phases");
+      WritePhases(out, h.GetLoadStats());
+      out.EndObject();
+   }
+   out.EndArray();
+
+   const double mb = static_cast<double>(std::filesystem::file_size(file)) / (1024.0 * 1024.0);
+   out.Field("bestMs", best).Field("bestMBps", best > 0.0 ? mb / (best / 1000.0) : 0.0);
+   out.Key("memory");
+   WriteMemory(out, memory);
+}
@@ -0,0 +1,50 @@
+#pragma once
+/*--------------------------------------------------------------------------
+ *  Подкоманды vcdtool
+ *  ------------------
+ *  Каждая обрабатывает один файл и пишет в JsonWriter один объект.
+ *  Исключения (файл не открылся, битый заголовок) ловит вызывающий.
+ *------------------------------------------------------------------------*/
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "Include/VcdReport.hpp"
+#include "JsonWriter.hpp"
+
+struct ToolOptions
+{
+   std::string command;
+   std::vector<std::filesystem::path> files;
+   unsigned threads = 0; //!< общий бюджет потоков, 0 -> по числу ядер
+   std::filesystem::path trace; //!< куда записать трассу (сборка с VCD_ENABLE_TRACE)
+   bool counters = false;       //!< счётчики процессора по фазам (bench) и запросам (values)
+
+   /* report */
+   std::vector<vcd::TimeWindow> windows;
+   bool signalRows = true;
+
+   /* values */
+   std::vector<std::string> signals; //!< полный путь "top.dut.clk" или alias
+   std::vector<std::uint64_t> times;
+
+   /* bench */
+   unsigned repeat = 1;
+};
+
+using CommandFn = void (*)(const std::filesystem::path &file, const ToolOptions &opt,
+                           unsigned threads, JsonWriter &out);
+
+/**  Заголовок, размер, число модулей/сигналов/изменений. */
+void RunStats(const std::filesystem::path &file, const ToolOptions &opt, unsigned threads, JsonWriter &out);
+
+/**  Переключения по модулям и сигналам в окнах (vcd::BuildReport). */
+void RunReport(const std::filesystem::path &file, const ToolOptions &opt, unsigned threads, JsonWriter &out);
+
+/**  Значения выбранных сигналов в заданные моменты. */
+void RunValues(const std::filesystem::path &file, const ToolOptions &opt, unsigned threads, JsonWriter &out);
+
+/**  Время этапов загрузки и память, opt.repeat прогонов. */
+void RunBench(const std::filesystem::path &file, const ToolOptions &opt, unsigned threads, JsonWriter &out);
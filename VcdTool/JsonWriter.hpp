@@ -0,0 +1,190 @@
+#pragma once
+/*--------------------------------------------------------------------------
+ *  JsonWriter
+ *  ----------
+ *  Потоковая запись JSON без промежуточного DOM: запятые и экранирование
+ *  расставляются автоматически, вложенность отслеживается стеком.
+ *------------------------------------------------------------------------*/
+
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+class JsonWriter
+{
+public:
+   explicit JsonWriter(std::ostream &os)
+       : m_os(os)
+   {
+   }
+
+   JsonWriter &
+   BeginObject()
+   {
+      Separate();
+      m_os << '{';
+      m_first.push_back(true);
+      return *this;
+   }
+
+   JsonWriter &
+   EndObject()
+   {
+      m_first.pop_back();
+      m_os << '}';
+      return *this;
+   }
+
+   JsonWriter &
+   BeginArray()
+   {
+      Separate();
+      m_os << '[';
+      m_first.push_back(true);
+      return *this;
+   }
+
+   JsonWriter &
+   EndArray()
+   {
+      m_first.pop_back();
+      m_os << ']';
+      return *this;
+   }
+
+   JsonWriter &
+   Key(std::string_view key)
+   {
+      Separate();
+      WriteString(key);
+      m_os << ':';
+      m_afterKey = true;
+      return *this;
+   }
+
+   JsonWriter &
+   Value(std::string_view v)
+   {
+      Separate();
+      WriteString(v);
+      return *this;
+   }
+
+   JsonWriter &
+   Value(const char *v)
+   {
+      return Value(std::string_view(v));
+   }
+
+   JsonWriter &
+   Value(std::uint64_t v)
+   {
+      Separate();
+      m_os << v;
+      return *this;
+   }
+
+   /**  Прочие целые без знака/со знаком >= 0 (size_t, unsigned, int). */
+   template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+   JsonWriter &
+   Value(T v)
+   {
+      return Value(static_cast<std::uint64_t>(v));
+   }
+
+   JsonWriter &
+   Value(double v)
+   {
+      Separate();
+      char buf[32];
+      std::snprintf(buf, sizeof(buf), "%.6g", v);
+      m_os << buf;
+      return *this;
+   }
+
+   JsonWriter &
+   Value(bool v)
+   {
+      Separate();
+      m_os << (v ? "true" : "false");
+      return *this;
+   }
+
+   /**  Уже готовый JSON-фрагмент (например, результат другого JsonWriter). */
+   JsonWriter &
+   Raw(std::string_view json)
+   {
+      Separate();
+      m_os << json;
+      return *this;
+   }
+
+   template <typename T>
+   JsonWriter &
+   Field(std::string_view key, const T &v)
+   {
+      return Key(key).Value(v);
+   }
+
+private:
+   void
+   Separate()
+   {
+      if (m_afterKey)
+      {
+         m_afterKey = false;
+         return;
+      }
+      if (m_first.empty())
+         return;
+      if (!m_first.back())
+         m_os << ',';
+      m_first.back() = false;
+   }
+
+   void
+   WriteString(std::string_view s)
+   {
+      m_os << '"';
+      for (char c : s)
+      {
+         switch (c)
+         {
+         case '"':
+            m_os << "\\\"";
+            break;
+         case '\\':
+            m_os << "\\\\";
+            break;
+         case '\n':
+            m_os << "\\n";
+            break;
+         case '\r':
+            m_os << "\\r";
+            break;
+         case '\t':
+            m_os << "\\t";
+            break;
+         default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+               char buf[8];
+               std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+               m_os << buf;
+            }
+            else
+            {
+               m_os << c;
+            }
+         }
+      }
+      m_os << '"';
+   }
+
+   std::ostream &m_os;
+   std::vector<bool> m_first; //!< по уровням вложенности: ещё не было элементов
+   bool m_afterKey = false;
+};
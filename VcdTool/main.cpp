@@ -0,0 +1,232 @@
+/*--------------------------------------------------------------------------
+ *  vcdtool — пакетная обработка VCD без GUI
+ *
+ *    vcdtool <stats|report|values|bench> [опции] <file.vcd>...
+ *
+ *  Результат — один JSON-объект в stdout: {"command": …, "files": [ … ]},
+ *  файлы в порядке аргументов. Ошибка файла попадает в его объект
+ *  ("error"), код возврата 1; ошибка аргументов — 2.
+ *------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Commands.hpp"
+#include "Include/VcdTrace.hpp"
+
+namespace
+{
+   const char *const kUsage =
+       "usage: vcdtool <command> [options] <file.vcd>...\n"
+       "\n"
+       "commands:\n"
+       "  stats                 header, size, module/signal/change counts\n"
+       "  report                switching activity per module and signal\n"
+       "  values                signal values at given times\n"
+       "  bench                 load timing and memory breakdown\n"
+       "\n"
+       "options:\n"
+       "  -j, --threads N       total thread budget for all files (default: all cores)\n"
+       "  --window T0:T1        report window, repeatable (default: whole dump)\n"
+       "  --no-signals          report: module summary only\n"
+       "  --signal NAME         values: full path (top.dut.clk) or alias, repeatable\n"
+       "  --at T[,T...]         values: timestamps\n"
+       "  --repeat N            bench: number of runs (default 1)\n"
+       "  --trace FILE          write Chrome/Perfetto trace JSON (build with VCD_ENABLE_TRACE)\n"
+       "  --counters            bench/values: CPU counters per phase and thread (perf_event_open,\n"
+       "                        software counters only if the kernel denies access)\n";
+
+   std::uint64_t
+   ParseU64(const std::string &s)
+   {
+      std::size_t pos = 0;
+      const unsigned long long v = std::stoull(s, &pos);
+      if (pos != s.size())
+         throw std::invalid_argument("not a number: " + s);
+      return v;
+   }
+
+   ToolOptions
+   ParseArgs(int argc, char **argv)
+   {
+      if (argc < 2)
+         throw std::invalid_argument("no command");
+
+      ToolOptions opt;
+      opt.command = argv[1];
+      for (int i = 2; i < argc; ++i)
+      {
+         const std::string arg = argv[i];
+         auto next = [&]() -> std::string
+         {
+            if (i + 1 >= argc)
+               throw std::invalid_argument("missing value for " + arg);
+            return argv[++i];
+         };
+
+         if (arg == "-j" || arg == "--threads")
+         {
+            opt.threads = static_cast<unsigned>(ParseU64(next()));
+         }
+         else if (arg == "--window")
+         {
+            const std::string v = next();
+            const auto colon = v.find(':');
+            if (colon == std::string::npos)
+               throw std::invalid_argument("window must be T0:T1");
+            opt.windows.push_back({ParseU64(v.substr(0, colon)), ParseU64(v.substr(colon + 1))});
+         }
+         else if (arg == "--no-signals")
+         {
+            opt.signalRows = false;
+         }
+         else if (arg == "--signal")
+         {
+            opt.signals.push_back(next());
+         }
+         else if (arg == "--at")
+         {
+            std::stringstream list(next());
+            for (std::string t; std::getline(list, t, ',');)
+               opt.times.push_back(ParseU64(t));
+         }
+         else if (arg == "--repeat")
+         {
+            opt.repeat = static_cast<unsigned>(ParseU64(next()));
+         }
+         else if (arg == "--trace")
+         {
+            opt.trace = next();
+         }
+         else if (arg == "--counters")
+         {
+            opt.counters = true;
+         }
+         else if (!arg.empty() && arg[0] == '-')
+         {
+            throw std::invalid_argument("unknown option " + arg);
+         }
+         else
+         {
+            opt.files.emplace_back(arg);
+         }
+      }
+      if (opt.files.empty())
+         throw std::invalid_argument("no input files");
+      return opt;
+   }
+} // namespace
+
+int main(int argc, char **argv)
+{
+   if (argc >= 2 && (!std::strcmp(argv[1], "-h") || !std::strcmp(argv[1], "--help")))
+   {
+      std::cout << kUsage;
+      return 0;
+   }
+
+   ToolOptions opt;
+   try
+   {
+      opt = ParseArgs(argc, argv);
+   }
+   catch (const std::exception &ex)
+   {
+      std::cerr << "vcdtool: " << ex.what() << "\n\n"
+                << kUsage;
+      return 2;
+   }
+
+   const std::map<std::string, CommandFn> commands = {
+       {"stats", &RunStats},
+       {"report", &RunReport},
+       {"values", &RunValues},
+       {"bench", &RunBench}};
+   const auto cmd = commands.find(opt.command);
+   if (cmd == commands.end())
+   {
+      std::cerr << "vcdtool: unknown command " << opt.command << "\n\n"
+                << kUsage;
+      return 2;
+   }
+
+   /* бюджет делится поровну между одновременно открытыми файлами */
+   const unsigned hw = std::thread::hardware_concurrency();
+   const unsigned budget = opt.threads ? opt.threads : (hw ? hw : 4);
+   const unsigned nWorkers = static_cast<unsigned>(std::min<std::size_t>(budget, opt.files.size()));
+   const unsigned perFile = std::max(1u, budget / nWorkers);
+
+   std::vector<std::string> results(opt.files.size());
+   std::atomic<std::size_t> next{0};
+   std::atomic<bool> failed{false};
+
+   auto worker = [&]
+   {
+      for (std::size_t i; (i = next.fetch_add(1)) < opt.files.size();)
+      {
+         VCD_TRACE_SCOPE("vcdtool/file");
+         std::ostringstream buf;
+         JsonWriter out(buf);
+         out.BeginObject().Field("path", opt.files[i].string());
+         try
+         {
+            std::ostringstream body;
+            JsonWriter bodyOut(body);
+            bodyOut.BeginObject();
+            cmd->second(opt.files[i], opt, perFile, bodyOut);
+            bodyOut.EndObject();
+
+            /* поля команды — в тот же объект, без внешних скобок */
+            const std::string s = body.str();
+            if (s.size() > 2)
+               out.Raw(std::string_view(s).substr(1, s.size() - 2));
+         }
+         catch (const std::exception &ex)
+         {
+            out.Field("error", ex.what());
+            failed = true;
+         }
+         out.EndObject();
+         results[i] = buf.str();
+      }
+   };
+
+   std::vector<std::thread> workers;
+   for (unsigned w = 1; w < nWorkers; ++w)
+      workers.emplace_back(worker);
+   worker();
+   for (auto &t : workers)
+      t.join();
+
+   JsonWriter out(std::cout);
+   out.BeginObject().Field("command", opt.command).Key("files").BeginArray();
+   for (const auto &r : results)
+      out.Raw(r);
+   out.EndArray().EndObject();
+   std::cout << std::endl;
+
+   if (!opt.trace.empty())
+   {
+      if (!vcd::trace::IsCompiledIn())
+         std::cerr << "vcdtool: built without VCD_ENABLE_TRACE, trace is empty\n";
+      try
+      {
+         vcd::trace::WriteJson(opt.trace);
+      }
+      catch (const std::exception &ex)
+      {
+         std::cerr << "vcdtool: " << ex.what() << '\n';
+         return 1;
+      }
+   }
+
+   return failed ? 1 : 0;
+}
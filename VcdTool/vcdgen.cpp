@@ -0,0 +1,201 @@
+/*--------------------------------------------------------------------------
+ *  vcdgen — детерминированный генератор синтетических VCD
+ *
+ *    vcdgen [опции] -o out.vcd
+ *
+ *  Одинаковые опции и seed дают побайтно одинаковый файл. Итог —
+ *  JSON-объект в stdout; ошибка аргументов — код 2, записи — 1.
+ *------------------------------------------------------------------------*/
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "Include/VcdGen.hpp"
+#include "JsonWriter.hpp"
+
+namespace
+{
+   const char *const kUsage =
+       "usage: vcdgen [options] -o out.vcd\n"
+       "\n"
+       "options:\n"
+       "  -o, --output FILE     output file (required)\n"
+       "  --size N[K|M|G]       target file size (default 16M)\n"
+       "  --signals N           number of signals (default 1000)\n"
+       "  --depth N             hierarchy depth (default 3)\n"
+       "  --fanout N            submodules per module (default 4)\n"
+       "  --bus-fraction F      share of buses, 0..1 (default 0.2)\n"
+       "  --bus-widths W[,W...] bus widths, picked uniformly (default 4,8,16,32,64)\n"
+       "  --xz F                probability of x/z per bit (default 0.01)\n"
+       "  --changes F           share of signals changing per timestamp (default 0.05)\n"
+       "  --step N              distance between timestamps (default 10)\n"
+       "  --crlf                CRLF line endings\n"
+       "  --dumpoff N[:LEN]     $dumpoff block every N timestamps, LEN long (default 5)\n"
+       "  --timescale S         $timescale value (default 1ps)\n"
+       "  --seed N              generator seed (default 1)\n";
+
+   std::uint64_t
+   ParseU64(const std::string &s)
+   {
+      std::size_t pos = 0;
+      const unsigned long long v = std::stoull(s, &pos);
+      if (pos != s.size())
+         throw std::invalid_argument("not a number: " + s);
+      return v;
+   }
+
+   double
+   ParseFraction(const std::string &s)
+   {
+      std::size_t pos = 0;
+      const double v = std::stod(s, &pos);
+      if (pos != s.size() || v < 0.0 || v > 1.0)
+         throw std::invalid_argument("not a fraction in [0, 1]: " + s);
+      return v;
+   }
+
+   std::uint64_t
+   ParseSize(std::string s)
+   {
+      std::uint64_t mul = 1;
+      if (!s.empty())
+      {
+         switch (s.back())
+         {
+         case 'K': case 'k': mul = 1ull << 10; break;
+         case 'M': case 'm': mul = 1ull << 20; break;
+         case 'G': case 'g': mul = 1ull << 30; break;
+         default: break;
+         }
+         if (mul != 1)
+            s.pop_back();
+      }
+      return ParseU64(s) * mul;
+   }
+} // namespace
+
+int main(int argc, char **argv)
+{
+   vcd::GenOptions opt;
+   std::string output;
+   try
+   {
+      for (int i = 1; i < argc; ++i)
+      {
+         const std::string arg = argv[i];
+         auto next = [&]() -> std::string
+         {
+            if (i + 1 >= argc)
+               throw std::invalid_argument("missing value for " + arg);
+            return argv[++i];
+         };
+
+         if (arg == "-h" || arg == "--help")
+         {
+            std::cout << kUsage;
+            return 0;
+         }
+         else if (arg == "-o" || arg == "--output")
+         {
+            output = next();
+         }
+         else if (arg == "--size")
+         {
+            opt.targetBytes = ParseSize(next());
+         }
+         else if (arg == "--signals")
+         {
+            opt.signals = static_cast<unsigned>(ParseU64(next()));
+         }
+         else if (arg == "--depth")
+         {
+            opt.depth = static_cast<unsigned>(ParseU64(next()));
+         }
+         else if (arg == "--fanout")
+         {
+            opt.fanout = static_cast<unsigned>(ParseU64(next()));
+         }
+         else if (arg == "--bus-fraction")
+         {
+            opt.busFraction = ParseFraction(next());
+         }
+         else if (arg == "--bus-widths")
+         {
+            opt.busWidths.clear();
+            std::stringstream list(next());
+            for (std::string w; std::getline(list, w, ',');)
+               opt.busWidths.push_back(static_cast<unsigned>(ParseU64(w)));
+         }
+         else if (arg == "--xz")
+         {
+            opt.xzDensity = ParseFraction(next());
+         }
+         else if (arg == "--changes")
+         {
+            opt.changesPerStep = ParseFraction(next());
+         }
+         else if (arg == "--step")
+         {
+            opt.timeStep = ParseU64(next());
+         }
+         else if (arg == "--crlf")
+         {
+            opt.crlf = true;
+         }
+         else if (arg == "--dumpoff")
+         {
+            const std::string v = next();
+            const auto colon = v.find(':');
+            opt.dumpoffEvery = static_cast<unsigned>(ParseU64(v.substr(0, colon)));
+            if (colon != std::string::npos)
+               opt.dumpoffLength = static_cast<unsigned>(ParseU64(v.substr(colon + 1)));
+         }
+         else if (arg == "--timescale")
+         {
+            opt.timescale = next();
+         }
+         else if (arg == "--seed")
+         {
+            opt.seed = ParseU64(next());
+         }
+         else
+         {
+            throw std::invalid_argument("unknown option " + arg);
+         }
+      }
+      if (output.empty())
+         throw std::invalid_argument("no output file");
+   }
+   catch (const std::exception &ex)
+   {
+      std::cerr << "vcdgen: " << ex.what() << "\n\n"
+                << kUsage;
+      return 2;
+   }
+
+   try
+   {
+      const vcd::GenResult res = vcd::GenerateVcd(output, opt);
+      JsonWriter out(std::cout);
+      out.BeginObject()
+          .Field("path", output)
+          .Field("seed", opt.seed)
+          .Field("bytes", res.bytes)
+          .Field("signals", opt.signals)
+          .Field("changes", res.changes)
+          .Field("timestamps", res.timestamps)
+          .Field("maxTs", res.maxTs)
+          .Field("dumpoffBlocks", res.dumpoffBlocks)
+          .EndObject();
+      std::cout << std::endl;
+   }
+   catch (const std::exception &ex)
+   {
+      std::cerr << "vcdgen: " << ex.what() << '\n';
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,373 @@
+/*--------------------------------------------------------------------------
+ *  VcdRenderBench — время кадров WaveformView без экрана
+ *
+ *    VcdRenderBench [опции]
+ *
+ *  Запускается на платформе offscreen (QT_QPA_PLATFORM, если не задана).
+ *  Синтетический файл (vcd::GenerateVcd) или --file загружается целиком,
+ *  первые N сигналов выводятся в WaveformView, затем прогоняются сценарии
+ *  зума, скролла и раскрытия шин; каждый шаг — действие, обработка
+ *  событий и отрисовка viewport в QImage.
+ *
+ *  Результат — JSON в stdout: p50/p99 кадра и отрисовки, время и число
+ *  перестроений путей (PathRebuildStats), память wave-элементов.
+ *------------------------------------------------------------------------*/
+
+#include <QApplication>
+#include <QImage>
+#include <QScrollBar>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Include/VcdGen.hpp"
+#include "Include/VcdStructs.hpp"
+#include "VcdTool/JsonWriter.hpp"
+#include "WaveformItem/TileCache.hpp"
+#include "WaveformView.hpp"
+
+namespace
+{
+   using Clock = std::chrono::steady_clock;
+
+   const char *const kUsage =
+       "usage: VcdRenderBench [options]\n"
+       "\n"
+       "options:\n"
+       "  --file FILE           use an existing VCD instead of a generated one\n"
+       "  --size MB             generated file size (default 8)\n"
+       "  --signals N           signals shown in the view (default 200)\n"
+       "  --bus-fraction F      share of buses in the generated file (default 0.2)\n"
+       "  --steps N             frames per scenario (default 40)\n"
+       "  --width W --height H  viewport size (default 1600x1000)\n"
+       "  --seed N              generator seed (default 1)\n"
+       "  --tile-cache MB       waveform tile cache limit, 0 draws rows directly (default 64)\n";
+
+   struct Options
+   {
+      std::filesystem::path file;
+      std::uint64_t sizeMb = 8;
+      unsigned signals = 200;
+      double busFraction = 0.2;
+      unsigned steps = 40;
+      int width = 1600;
+      int height = 1000;
+      std::uint64_t seed = 1;
+      std::uint64_t tileCacheMb = 64;
+   };
+
+   double
+   MsSince(Clock::time_point t0)
+   {
+      return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+   }
+
+   /* nearest-rank: p в [0, 1] */
+   double
+   Percentile(std::vector<double> v, double p)
+   {
+      if (v.empty())
+         return 0.0;
+      std::sort(v.begin(), v.end());
+      const std::size_t rank = static_cast<std::size_t>(std::ceil(p * static_cast<double>(v.size())));
+      return v[std::clamp<std::size_t>(rank, 1, v.size()) - 1];
+   }
+
+   Options
+   ParseArgs(int argc, char **argv)
+   {
+      Options opt;
+      for (int i = 1; i < argc; ++i)
+      {
+         const std::string arg = argv[i];
+         auto next = [&]() -> std::string
+         {
+            if (i + 1 >= argc)
+               throw std::invalid_argument("missing value for " + arg);
+            return argv[++i];
+         };
+
+         if (arg == "--file")
+         {
+            opt.file = next();
+         }
+         else if (arg == "--size")
+         {
+            opt.sizeMb = std::stoull(next());
+         }
+         else if (arg == "--signals")
+         {
+            opt.signals = static_cast<unsigned>(std::stoul(next()));
+         }
+         else if (arg == "--bus-fraction")
+         {
+            opt.busFraction = std::stod(next());
+         }
+         else if (arg == "--steps")
+         {
+            opt.steps = static_cast<unsigned>(std::stoul(next()));
+         }
+         else if (arg == "--width")
+         {
+            opt.width = std::stoi(next());
+         }
+         else if (arg == "--height")
+         {
+            opt.height = std::stoi(next());
+         }
+         else if (arg == "--seed")
+         {
+            opt.seed = std::stoull(next());
+         }
+         else if (arg == "--tile-cache")
+         {
+            opt.tileCacheMb = std::stoull(next());
+         }
+         else
+         {
+            throw std::invalid_argument("unknown option " + arg);
+         }
+      }
+      return opt;
+   }
+
+   /* один сценарий: шаги «действие -> события -> кадр в QImage» */
+   class Runner
+   {
+   public:
+      Runner(WaveformView &view, JsonWriter &out)
+          : m_view(view), m_out(out),
+            m_image(view.viewport()->size(), QImage::Format_ARGB32_Premultiplied)
+      {
+      }
+
+      /** prepare — вне замера, после сброса масштаба; step(i) -> false, если сценарий закончился раньше. */
+      void
+      Run(const char *name, unsigned steps, const std::function<void()> &prepare,
+          const std::function<bool(unsigned)> &step)
+      {
+         m_view.SetInitialScale();
+         if (prepare)
+            prepare();
+         QCoreApplication::processEvents();
+
+         std::vector<double> frameMs, renderMs;
+         const PathRebuildStats before = GetPathRebuildStats();
+         const WaveTileCache::Stats tilesBefore = m_view.GetTileCache()->GetStats();
+         for (unsigned i = 0; i < steps; ++i)
+         {
+            const auto t0 = Clock::now();
+            if (!step(i))
+               break;
+            QCoreApplication::processEvents();
+            const auto tRender = Clock::now();
+            m_view.viewport()->render(&m_image);
+            renderMs.push_back(MsSince(tRender));
+            frameMs.push_back(MsSince(t0));
+         }
+         const PathRebuildStats &after = GetPathRebuildStats();
+         const std::uint64_t rebuildNs = (after.simple.ns - before.simple.ns) + (after.bus.ns - before.bus.ns);
+         const WaveTileCache::Stats &tiles = m_view.GetTileCache()->GetStats();
+
+         m_out.BeginObject()
+             .Field("name", name)
+             .Field("frames", frameMs.size())
+             .Field("frameP50Ms", Percentile(frameMs, 0.50))
+             .Field("frameP99Ms", Percentile(frameMs, 0.99))
+             .Field("frameMaxMs", frameMs.empty() ? 0.0 : *std::max_element(frameMs.begin(), frameMs.end()))
+             .Field("renderP50Ms", Percentile(renderMs, 0.50))
+             .Field("renderP99Ms", Percentile(renderMs, 0.99))
+             .Field("rebuildMs", static_cast<double>(rebuildNs) / 1e6)
+             .Field("simpleRebuilds", after.simple.calls - before.simple.calls)
+             .Field("busRebuilds", after.bus.calls - before.bus.calls)
+             .Field("itemsMemoryBytes", m_view.GetItemsMemoryBytes())
+             .Field("liveItems", m_view.GetLiveItemCount())
+             .Field("tileHits", tiles.hits - tilesBefore.hits)
+             .Field("tileMisses", tiles.misses - tilesBefore.misses)
+             .Field("tileRenderMs", static_cast<double>(tiles.renderNs - tilesBefore.renderNs) / 1e6)
+             .Field("tileBytes", tiles.bytes)
+             .EndObject();
+      }
+
+   private:
+      WaveformView &m_view;
+      JsonWriter &m_out;
+      QImage m_image;
+   };
+} // namespace
+
+int main(int argc, char *argv[])
+{
+   if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+      qputenv("QT_QPA_PLATFORM", "offscreen");
+
+   Options opt;
+   try
+   {
+      for (int i = 1; i < argc; ++i)
+      {
+         if (!std::strcmp(argv[i], "-h") || !std::strcmp(argv[i], "--help"))
+         {
+            std::cout << kUsage;
+            return 0;
+         }
+      }
+      opt = ParseArgs(argc, argv);
+   }
+   catch (const std::exception &ex)
+   {
+      std::cerr << "VcdRenderBench: " << ex.what() << "\n\n"
+                << kUsage;
+      return 2;
+   }
+
+   QApplication app(argc, argv);
+
+   /*------------- 1. файл и загрузка -------------------------*/
+   std::filesystem::path path = opt.file;
+   bool generated = false;
+   if (path.empty())
+   {
+      vcd::GenOptions gen;
+      gen.seed = opt.seed;
+      gen.targetBytes = opt.sizeMb << 20;
+      gen.signals = std::max(1u, opt.signals);
+      gen.busFraction = opt.busFraction;
+      gen.dumpoffEvery = 2000;
+      path = std::filesystem::temp_directory_path() / ("vcd-render-bench-" + std::to_string(opt.seed) + ".vcd");
+      vcd::GenerateVcd(path, gen);
+      generated = true;
+   }
+
+   auto handle = std::make_shared<vcd::Handle>();
+   handle->Init(path);
+   handle->LoadHdr();
+   handle->LoadSignalsParallel();
+
+   std::vector<vcd::PinDescriptionPtr> signals;
+   for (std::size_t id = 0; id < handle->GetAlias2pinMap().size() && signals.size() < opt.signals; ++id)
+      signals.push_back(handle->GetPinById(static_cast<std::uint32_t>(id)));
+
+   /*------------- 2. вид без экрана ---------------------------*/
+   WaveformView view;
+   view.setAttribute(Qt::WA_DontShowOnScreen);
+   view.resize(opt.width, opt.height);
+   view.SetTileCacheBytes(static_cast<std::size_t>(opt.tileCacheMb) << 20);
+   view.show();
+   QCoreApplication::processEvents();
+
+   JsonWriter out(std::cout);
+   out.BeginObject()
+       .Field("file", path.string())
+       .Field("fileSize", static_cast<std::uint64_t>(std::filesystem::file_size(path)))
+       .Field("signals", signals.size())
+       .Key("viewport")
+       .BeginArray()
+       .Value(view.viewport()->width())
+       .Value(view.viewport()->height())
+       .EndArray();
+
+   const PathRebuildStats beforeSetup = GetPathRebuildStats();
+   const auto setupStart = Clock::now();
+   view.SetHandle(handle);
+   view.UpdateSignals(signals);
+   view.SetInitialScale();
+   QCoreApplication::processEvents();
+   const double setupMs = MsSince(setupStart);
+   const PathRebuildStats &afterSetup = GetPathRebuildStats();
+
+   out.Key("setup")
+       .BeginObject()
+       .Field("ms", setupMs)
+       .Field("rebuildMs", static_cast<double>((afterSetup.simple.ns - beforeSetup.simple.ns) +
+                                               (afterSetup.bus.ns - beforeSetup.bus.ns)) / 1e6)
+       .Field("simpleRebuilds", afterSetup.simple.calls - beforeSetup.simple.calls)
+       .Field("busRebuilds", afterSetup.bus.calls - beforeSetup.bus.calls)
+       .Field("itemsMemoryBytes", view.GetItemsMemoryBytes())
+       .EndObject();
+
+   /*------------- 3. сценарии ---------------------------------*/
+   std::vector<vcd::PinDescriptionPtr> buses;
+   for (const auto &pin : signals)
+   {
+      if (pin->GetPinType() != vcd::PinType::parameter && pin->GetSignalType() == vcd::SignalType::bus)
+         buses.push_back(pin);
+   }
+   const std::uint64_t maxTs = std::max<std::uint64_t>(1, handle->GetMaxTs());
+
+   Runner runner(view, out);
+   out.Key("scenarios").BeginArray();
+
+   runner.Run("static", opt.steps, nullptr, [&](unsigned)
+              { return true; });
+
+   runner.Run("zoomIn", opt.steps, nullptr, [&](unsigned)
+              {
+      view.ZoomIn();
+      return true; });
+
+   runner.Run(
+       "zoomOut", opt.steps, [&]
+       {
+          for (unsigned k = 0; k < opt.steps; ++k)
+             view.ZoomIn(); },
+       [&](unsigned)
+       { return view.ZoomOut(); });
+
+   runner.Run(
+       "scroll", opt.steps, [&]
+       { view.zoomToRange(0, maxTs / 20); },
+       [&](unsigned)
+       {
+          QScrollBar *sb = view.horizontalScrollBar();
+          sb->setValue(std::min(sb->maximum(), sb->value() + sb->pageStep() / 4));
+          return true; });
+
+   /* вертикальный скролл: строки меняют элементы через пул */
+   runner.Run(
+       "scrollRows", opt.steps, [&]
+       { view.verticalScrollBar()->setValue(0); },
+       [&](unsigned)
+       {
+          QScrollBar *sb = view.verticalScrollBar();
+          if (sb->value() >= sb->maximum())
+             return false;
+          sb->setValue(std::min(sb->maximum(), sb->value() + sb->pageStep() / 2));
+          return true; });
+
+   /* окна со случайной шириной в логарифмическом масштабе, LCG с фиксированным зерном */
+   std::uint64_t lcg = opt.seed;
+   runner.Run("zoomToRange", opt.steps, nullptr, [&](unsigned)
+              {
+      lcg = lcg * 6364136223846793005ull + 1442695040888963407ull;
+      const double frac = std::pow(10.0, -3.0 * static_cast<double>((lcg >> 11) % 1000) / 1000.0);
+      const std::uint64_t width = std::max<std::uint64_t>(2, static_cast<std::uint64_t>(frac * static_cast<double>(maxTs)));
+      const std::uint64_t x0 = (lcg >> 29) % std::max<std::uint64_t>(1, maxTs - width + 1);
+      view.zoomToRange(x0, x0 + width);
+      return true; });
+
+   /* первая половина шагов раскрывает шины, вторая — сворачивает их в том же порядке */
+   const unsigned expandSteps = std::min<unsigned>(opt.steps, static_cast<unsigned>(2 * buses.size()));
+   const unsigned half = (expandSteps + 1) / 2;
+   runner.Run("expand", expandSteps, nullptr, [&](unsigned i)
+              {
+      const bool expand = i < half;
+      view.OnItemExpandedOrCollapsed(buses[expand ? i : i - half], expand);
+      return true; });
+
+   out.EndArray().EndObject();
+   std::cout << std::endl;
+
+   if (generated)
+      std::filesystem::remove(path);
+   return 0;
+}
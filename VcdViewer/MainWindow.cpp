@@ -5,6 +5,7 @@
 #include <QHeaderView>
 #include <QIcon>
 #include <QSplitter>
+#include <QStatusBar>
 #include <QToolButton>
 #include <QVBoxLayout>
 
@@ -18,6 +19,7 @@ MainWindow::MainWindow(QWidget *Parent)
    setWindowTitle("VCD Module and Signal Viewer");
    resize(1400, 1300);
    qRegisterMetaType<std::shared_ptr<vcd::Handle>>("std::shared_ptr<vcd::Handle>");
+   qRegisterMetaType<vcd::LoadStats>("vcd::LoadStats");
    VcdViewerWidget *viewerWidget = new VcdViewerWidget;
 
    // Устанавливаем центральный виджет
@@ -47,17 +49,34 @@ MainWindow::MainWindow(QWidget *Parent)
    mainLayout->addWidget(viewerWidget, 1);
 
    connect(buttonReset, &QPushButton::clicked, viewerWidget, &VcdViewerWidget::UnloadPreviousData);
+   connect(viewerWidget, &VcdViewerWidget::StatusMessage, statusBar(), [this](const QString &text)
+           { statusBar()->showMessage(text); });
    connect(this, &MainWindow::AskForFileOpen, viewerWidget, &VcdViewerWidget::AskForReadFile);
+   connect(this, &MainWindow::AskForFilesOpen, viewerWidget, &VcdViewerWidget::AskForReadFiles);
    connect(buttonBrowse, &QPushButton::clicked, this, [this]()
            {
-      // Открываем диалог выбора файла
-      QString filePath = QFileDialog::getOpenFileName(this, tr("Выберите файл"), QString(""), tr("Все файлы (*.*)"));
-      if (!filePath.isEmpty())
+      // Открываем диалог выбора файла; несколько файлов — части одного прогона
+      // (в поле имени можно ввести маску, например run*.vcd, и выделить все)
+      QStringList filePaths = QFileDialog::getOpenFileNames(this, tr("Выберите файл"), QString(""), tr("VCD (*.vcd);;Все файлы (*.*)"));
+      if (filePaths.size() == 1)
       {
          // Эмитируем сигнал с выбранным файлом
-         emit AskForFileOpen(filePath);
+         emit AskForFileOpen(filePaths.front());
+      }
+      else if (filePaths.size() > 1)
+      {
+         emit AskForFilesOpen(filePaths);
       } });
-   emit AskForFileOpen("/home/justfunde/Work/Miet/VcdViewer/VcdTests/bugs/c432.vcd");
+   // Файлы из командной строки: несколько — части одного прогона
+   const QStringList args = QApplication::arguments().mid(1);
+   if (args.size() == 1)
+   {
+      emit AskForFileOpen(args.front());
+   }
+   else if (args.size() > 1)
+   {
+      emit AskForFilesOpen(args);
+   }
 }
 
 void MainWindow::OnBrowse()
@@ -20,6 +20,9 @@ class MainWindow : public QMainWindow
    void
    AskForFileOpen(QString fileName);
 
+   void
+   AskForFilesOpen(QStringList fileNames);
+
  public:
    explicit MainWindow(QWidget* Parent = nullptr);
 
@@ -0,0 +1,224 @@
+#include "TimeRuler.hpp"
+
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QVector>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <vector>
+
+#include "Include/VcdTrace.hpp"
+
+namespace
+{
+   struct Unit
+   {
+      const char *name;
+      double ps;
+   };
+   // от крупной к мелкой: подпись берёт самую крупную, где хватает ≤ 1 знака
+   constexpr std::array<Unit, 5> kUnits{{{"s", 1e12}, {"ms", 1e9}, {"us", 1e6}, {"ns", 1e3}, {"ps", 1.0}}};
+
+   constexpr int kSubTicks = 5;          ///< дробных делений на шаг
+   constexpr std::size_t kMaxLabels = 4096; ///< подписей одного шага в кеше
+} // namespace
+
+void TimeTicks::Reset(std::string_view timescale, std::uint64_t maxTs)
+{
+   m_maxTs = maxTs;
+   m_step = 0;
+   m_unitPs = 0;
+   m_labels.clear();
+   m_font.setPointSize(8);
+
+   /* "10ns", "1 ps": множитель (по умолчанию 1) и единица */
+   std::size_t pos = 0;
+   double mul = 0;
+   while (pos < timescale.size() && std::isdigit(static_cast<unsigned char>(timescale[pos])))
+      mul = mul * 10 + (timescale[pos++] - '0');
+   if (pos == 0)
+      mul = 1;
+   while (pos < timescale.size() && std::isspace(static_cast<unsigned char>(timescale[pos])))
+      ++pos;
+   const std::string_view unit = timescale.substr(pos);
+   if (unit == "fs")
+      m_unitPs = mul * 1e-3;
+   for (const Unit &u : kUnits)
+   {
+      if (unit == u.name)
+         m_unitPs = mul * u.ps;
+   }
+}
+
+void TimeTicks::Update(double pxPerTs, int viewWidthPx)
+{
+   if (m_unitPs <= 0 || pxPerTs <= 0 || viewWidthPx <= 0)
+      return;
+
+   /* «красивый» шаг деления: ≈10 на окно */
+   const double roughStepPs = viewWidthPx / pxPerTs * m_unitPs / 10.0;
+   const double decade = std::pow(10.0, std::floor(std::log10(roughStepPs)));
+   double nicePs = decade;
+   if (roughStepPs / decade > 5)
+      nicePs = 10 * decade;
+   else if (roughStepPs / decade > 2)
+      nicePs = 5 * decade;
+   else if (roughStepPs / decade > 1)
+      nicePs = 2 * decade;
+
+   const double step = nicePs / m_unitPs;
+   if (step != m_step)
+   {
+      VCD_TRACE_SCOPE("TimeTicks::NewStep");
+      m_step = step;
+      m_labels.clear();
+      // самые длинные подписи — у конца файла; зазор — два символа
+      const double gap = QFontMetricsF(m_font).horizontalAdvance(QStringLiteral("00"));
+      m_labelWidth = Label(static_cast<std::int64_t>(m_maxTs / m_step)).size().width() + gap;
+   }
+   m_pxPerTs = pxPerTs;
+
+   /* подписываем каждое 1, 2, 5, 10… деление, чтобы подписи не налезали */
+   const double spacingPx = m_step * pxPerTs;
+   m_stride = 1;
+   for (int decadeStride = 1; spacingPx * m_stride < m_labelWidth && decadeStride < 1000000; decadeStride *= 10)
+   {
+      for (int k : {1, 2, 5})
+      {
+         m_stride = k * decadeStride;
+         if (spacingPx * m_stride >= m_labelWidth)
+            break;
+      }
+   }
+}
+
+const QStaticText &TimeTicks::Label(std::int64_t index)
+{
+   if (const auto it = m_labels.find(index); it != m_labels.end())
+      return it->second;
+
+   QStaticText text(Format(static_cast<double>(index) * m_step * m_unitPs));
+   text.setPerformanceHint(QStaticText::AggressiveCaching);
+   text.prepare(QTransform(), m_font);
+   return m_labels.emplace(index, std::move(text)).first->second;
+}
+
+QString TimeTicks::Format(double timePs) const
+{
+   /* единица — чтобы в подписи был ≤ 1 знак после запятой */
+   std::size_t uIdx = 0;
+   int prec = 0;
+   for (; uIdx + 1 < kUnits.size(); ++uIdx)
+   {
+      const double val = timePs / kUnits[uIdx].ps;
+      const double val10 = val * 10.0;
+      const bool oneDecimal = std::fabs(val10 - std::round(val10)) < 1e-6;
+      const bool zeroDecimal = std::fabs(val - std::round(val)) < 1e-6;
+      if (val >= 1.0 && (zeroDecimal || oneDecimal))
+      {
+         prec = zeroDecimal ? 0 : 1;
+         break;
+      }
+   }
+   const double value = timePs / kUnits[uIdx].ps;
+   if (prec == 0 && std::fabs(value - std::round(value)) > 1e-6)
+      prec = 2; // в ps могут остаться «.25»
+
+   return QString::number(value, 'f', prec) + QString::fromLatin1(kUnits[uIdx].name);
+}
+
+template <typename Fn>
+void TimeTicks::ForEachTick(const QRectF &exposed, Fn &&fn) const
+{
+   // подпись шире риски: захватываем деления, чьи подписи задевают exposed
+   const double margin = m_labelWidth / m_pxPerTs;
+   const double x0 = std::max(0.0, exposed.left() - margin);
+   const double x1 = std::min(static_cast<double>(m_maxTs), exposed.right() + margin);
+   if (x1 < x0)
+      return;
+   const auto i0 = static_cast<std::int64_t>(std::ceil(x0 / m_step));
+   const auto i1 = static_cast<std::int64_t>(std::floor(x1 / m_step));
+   for (std::int64_t i = i0; i <= i1; ++i)
+      fn(i, static_cast<double>(i) * m_step);
+}
+
+void TimeTicks::PaintRuler(QPainter *p, const QRectF &exposed, int height)
+{
+   VCD_TRACE_SCOPE("TimeTicks::PaintRuler");
+   if (m_labels.size() >= kMaxLabels)
+      m_labels.clear(); // долгая прокрутка на одном шаге; ссылки ниже живут до конца кадра
+   const QTransform t = p->worldTransform();
+   auto devX = [&](double x)
+   { return t.m11() * x + t.dx(); };
+   const double mid = height / 2.0;
+
+   QVector<QLineF> solid, dashed;
+   struct Pending
+   {
+      QPointF pos;
+      const QStaticText *text;
+   };
+   std::vector<Pending> labels;
+
+   ForEachTick(exposed, [&](std::int64_t i, double x)
+               {
+      const double dx = devX(x);
+      if (i % m_stride != 0)
+      {
+         dashed.append(QLineF(dx, mid, dx, height));
+         return;
+      }
+      solid.append(QLineF(dx, mid, dx, height));
+      const QStaticText &text = Label(i);
+      labels.push_back({QPointF(dx - text.size().width() / 2.0, 1.0), &text}); });
+
+   /* дробные деления */
+   const double sub = m_step / kSubTicks;
+   const double s0 = std::max(0.0, exposed.left());
+   const double s1 = std::min(static_cast<double>(m_maxTs), exposed.right());
+   for (auto j = static_cast<std::int64_t>(std::ceil(s0 / sub)); j <= static_cast<std::int64_t>(std::floor(s1 / sub)); ++j)
+   {
+      if (j % kSubTicks != 0)
+         dashed.append(QLineF(devX(static_cast<double>(j) * sub), mid, devX(static_cast<double>(j) * sub), height));
+   }
+
+   p->save();
+   p->resetTransform();
+
+   p->setPen(QPen(Qt::blue, 1));
+   p->drawLine(QPointF(devX(s0), mid), QPointF(devX(s1), mid));
+   p->setPen(QPen(QColor(0, 0, 255, 128), 1));
+   p->drawLines(solid);
+   p->setPen(QPen(Qt::blue, 1, Qt::DashLine));
+   p->drawLines(dashed);
+
+   p->setFont(m_font);
+   p->setPen(Qt::white);
+   for (const Pending &l : labels)
+      p->drawStaticText(l.pos, *l.text);
+   p->restore();
+}
+
+void TimeTicks::PaintGrid(QPainter *p, const QRectF &exposed)
+{
+   QVector<QLineF> lines;
+   ForEachTick(exposed, [&](std::int64_t i, double x)
+               {
+      if (i % m_stride == 0 && x >= exposed.left() && x <= exposed.right())
+         lines.append(QLineF(x, exposed.top(), x, exposed.bottom())); });
+
+   QPen pen(QColor(0, 0, 255, 128), 1);
+   pen.setCosmetic(true);
+   p->setPen(pen);
+   p->drawLines(lines);
+}
+
+void TimeRulerView::drawBackground(QPainter *p, const QRectF &rect)
+{
+   QGraphicsView::drawBackground(p, rect);
+   m_ticks.Update(transform().m11(), viewport()->width());
+   if (m_ticks.Valid())
+      m_ticks.PaintRuler(p, rect, viewport()->height());
+}
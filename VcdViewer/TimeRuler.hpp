@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+#include <QFont>
+#include <QGraphicsView>
+#include <QStaticText>
+
+/**
+ * @brief Деления шкалы времени для текущего масштаба.
+ *
+ * Шаг «1-2-5» подбирается под ≈10 делений на окно; подписи — QStaticText
+ * (раскладка глифов готова заранее) и живут, пока не сменился шаг.
+ * Используется линейкой (TimeRulerView) и сеткой WaveformView::drawBackground,
+ * при прокрутке ничего не создаётся.
+ */
+class TimeTicks
+{
+public:
+   /// Новый файл: #timescale ("10ns") разбирается здесь один раз.
+   void Reset(std::string_view timescale, std::uint64_t maxTs);
+
+   /// Масштаб и ширина окна; шаг и подписи пересчитываются, только если сменился шаг.
+   void Update(double pxPerTs, int viewWidthPx);
+
+   bool Valid() const noexcept { return m_unitPs > 0 && m_step > 0; }
+
+   /// Линейка: риски, подписи каждого LabelStride()-го деления, дробные деления.
+   void PaintRuler(QPainter *p, const QRectF &exposed, int height);
+
+   /// Сетка основного вида — линии подписанных делений.
+   void PaintGrid(QPainter *p, const QRectF &exposed);
+
+private:
+   const QStaticText &Label(std::int64_t index);
+   QString Format(double timePs) const;
+
+   template <typename Fn>
+   void ForEachTick(const QRectF &exposed, Fn &&fn) const;
+
+private:
+   double m_unitPs = 0;       //!< 1 метка времени = ? пс
+   std::uint64_t m_maxTs = 0;
+   double m_step = 0;         //!< основной шаг, метки времени
+   double m_pxPerTs = 0;
+   int m_stride = 1;          //!< подписывается каждое m_stride-е деление
+   double m_labelWidth = 0;   //!< самая широкая подпись шага + зазор, пикселей
+
+   QFont m_font;
+   std::unordered_map<std::int64_t, QStaticText> m_labels; //!< номер деления → подпись
+};
+
+/// Линейка над WaveformView: сцена пустая, всё рисует drawBackground по TimeTicks.
+class TimeRulerView final : public QGraphicsView
+{
+public:
+   TimeRulerView(QGraphicsScene *scene, TimeTicks &ticks, QWidget *parent = nullptr)
+       : QGraphicsView(scene, parent), m_ticks(ticks)
+   {
+   }
+
+protected:
+   void drawBackground(QPainter *p, const QRectF &rect) override;
+
+private:
+   TimeTicks &m_ticks;
+};
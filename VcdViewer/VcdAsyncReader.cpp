@@ -1,4 +1,5 @@
 #include "VcdAsyncReader.hpp"
+#include "Include/VcdTrace.hpp"
 
 #include <QtConcurrent>
 #include <filesystem>
@@ -12,31 +13,71 @@ VcdAsyncFileReader::VcdAsyncFileReader(QObject *parent)
 /*-------------------------------------------------------------------------*/
 void VcdAsyncFileReader::ReadFile(const QString &vcdFilePath)
 {
-    const std::filesystem::path filePath = vcdFilePath.toStdString();
+    m_filePaths = {vcdFilePath.toStdString()};
+    m_filter = vcd::SignalFilter{};
+    StartRead();
+}
 
-    if (!std::filesystem::exists(filePath))
-    {
-        emit ReadFileError(tr("Файл не существует"));
+/*-------------------------------------------------------------------------*/
+void VcdAsyncFileReader::ReadFiles(const QStringList &vcdFilePaths)
+{
+    m_filePaths.clear();
+    for (const QString &path : vcdFilePaths)
+        m_filePaths.emplace_back(path.toStdString());
+    vcd::Handle::SortPartsNaturally(m_filePaths);
+
+    m_filter = vcd::SignalFilter{};
+    StartRead();
+}
+
+/*-------------------------------------------------------------------------*/
+void VcdAsyncFileReader::ReloadWithFilter(vcd::SignalFilter filter)
+{
+    if (m_filePaths.empty())
         return;
+
+    m_filter = std::move(filter);
+    StartRead();
+}
+
+/*-------------------------------------------------------------------------*/
+void VcdAsyncFileReader::StartRead()
+{
+    const std::vector<std::filesystem::path> filePaths = m_filePaths;
+
+    for (const auto &filePath : filePaths)
+    {
+        if (!std::filesystem::exists(filePath))
+        {
+            emit ReadFileError(tr("Файл не существует: %1").arg(QString::fromStdString(filePath.string())));
+            return;
+        }
     }
 
     /* 2. Отправляем парсинг в пул потоков                       */
     /*    QtConcurrent гарантирует queued-delivery сигнала назад */
-    QtConcurrent::run([this, filePath]()
+    QtConcurrent::run([this, filePaths, filter = m_filter]()
                       {
+        VCD_TRACE_THREAD("loader");
         try
         {
             auto handle = std::make_shared<vcd::Handle>();
 
             /* Последовательность инициализации — как и раньше */
-            handle->Init(filePath);
+            handle->Init(filePaths.front());
             handle->LoadHdr();
-            handle->LoadSignalsParallel();
+            handle->SetSignalFilter(filter);
+            handle->SetBuildChangeIndex(true); // переход по событиям
+            handle->SetBuildStatsIndex(true);  // отчёт по окну From-To
+            if (filePaths.size() > 1)
+                handle->LoadSignalsFromParts(filePaths);
+            else
+                handle->LoadSignalsPipelined();
 
-            emit ReadFileReady(handle);   // queued-connection
+            emit ReadFileReady(handle, handle->GetLoadStats()); // queued-connection
         }
         catch (const std::exception &ex)
         {
             emit ReadFileError(QString::fromStdString(ex.what()));
         } });
-}
\ No newline at end of file
+}
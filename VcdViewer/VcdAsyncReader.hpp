@@ -9,7 +9,10 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
+#include <filesystem>
 #include <memory>
+#include <vector>
 
 #include "Include/VcdStructs.hpp" // объявление vcd::Handle
 
@@ -37,18 +40,46 @@ public slots:
     * @param vcdFilePath Путь к *.vcd.
     *
     * Генерирует:
-    *  * ReadFileReady(shared_ptr<Handle>) — если успех;
+    *  * ReadFileReady(shared_ptr<Handle>, LoadStats) — если успех;
     *  * ReadFileError(QString)            — если ошибка.
     */
    void ReadFile(const QString &vcdFilePath);
 
+   /**
+    * @brief Открывает несколько частей одного прогона (run.vcd, run_1.vcd, …)
+    *        как одну трассу. Порядок частей — натуральный по имени.
+    */
+   void ReadFiles(const QStringList &vcdFilePaths);
+
+public:
+   /**
+    * @brief Перечитывает последний файл, сохраняя только сигналы,
+    *        прошедшие фильтр (пустой фильтр — все сигналы).
+    *
+    * ReadFile() сбрасывает фильтр: новый файл всегда открывается целиком.
+    */
+   void ReloadWithFilter(vcd::SignalFilter filter);
+
+   bool
+   HasFilter() const noexcept
+   {
+      return !m_filter.IsEmpty();
+   }
+
 signals:
-   /// Файл успешно прочитан, `handle` готов к работе.
-   void ReadFileReady(std::shared_ptr<vcd::Handle> handle);
+   /// Файл успешно прочитан, `handle` готов к работе; `stats` — время фаз загрузки.
+   void ReadFileReady(std::shared_ptr<vcd::Handle> handle, vcd::LoadStats stats);
 
    /// Произошла ошибка; текст содержит описание.
    void ReadFileError(QString description);
+
+private:
+   void StartRead();
+
+   std::vector<std::filesystem::path> m_filePaths; ///< последний запрошенный файл (или части)
+   vcd::SignalFilter m_filter;       ///< применяется при следующем чтении
 };
 
 // Регистрируем тип для queued-сигналов.
 Q_DECLARE_METATYPE(std::shared_ptr<vcd::Handle>)
+Q_DECLARE_METATYPE(vcd::LoadStats)
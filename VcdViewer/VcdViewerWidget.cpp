@@ -1,4 +1,7 @@
 #include "VcdViewerWidget.hpp"
+#include "Include/VcdReport.hpp"
+#include "Include/VcdTrace.hpp"
+#include "Include/VcdWriter.hpp"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -8,20 +11,80 @@
 #include <QLineEdit>
 #include <QLabel>
 #include <QIcon>
+#include <QMenu>
 #include <QMessageBox>
 #include <QRegularExpression>
 #include <QScrollBar>
 #include <QTimer>
 #include <QTableView>
-#include <stack>
+#include <QApplication>
+#include <QFileDialog>
+#include <QPlainTextEdit>
+#include <QPointer>
+#include <QtConcurrent>
+#include <sstream>
+#include <tuple>
 
 #include <cmath>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <iostream>
 
 using namespace vcd;
 
+namespace
+{
+   /* текстовый вид отчёта: сводка, модули, сигналы (первое окно) */
+   QString FormatReport(const vcd::Report &report, std::string_view timeScale)
+   {
+      const std::string_view unit = timeScale.size() > 1 ? timeScale.substr(1) : timeScale;
+      const vcd::TimeWindow &win = report.windows.front();
+
+      std::stringstream out;
+      out << "Временной масштаб: " << timeScale << std::endl;
+      out << "Окно отчёта: " << win.t0 << " - " << win.t1 << unit << std::endl;
+      out << "Общее количество переключений: " << report.totalToggles.front() << std::endl
+          << std::endl;
+
+      out << "Статистика по модулям:" << std::endl;
+      for (const auto &m : report.modules)
+         out << m.path << ": " << m.toggles.front() << " переключений" << std::endl;
+
+      out << std::endl
+          << "Статистика по сигналам и шинам:" << std::endl;
+      for (const auto &s : report.signals)
+      {
+         const vcd::SignalStats &st = s.stats.front();
+         out << report.SignalPath(s) << ": " << st.toggles << " переключений";
+         if (s.pin->GetSignalType() == vcd::SignalType::simple)
+            out << ", заполнение " << std::fixed << std::setprecision(1) << st.DutyCycle() * 100.0 << "%" << std::defaultfloat;
+         out << std::endl;
+      }
+      return QString::fromStdString(out.str());
+   }
+
+   /* одна строка для строки состояния: объём, скорость, фазы */
+   QString FormatLoadStats(const vcd::LoadStats &st)
+   {
+      std::ostringstream out;
+      out << std::fixed << std::setprecision(1);
+      out << st.loader << " x" << st.threads << " | "
+          << st.bytes / (1024.0 * 1024.0) << " MiB, " << st.changes << " changes in " << st.totalMs << " ms ("
+          << st.BytesPerSecond() / (1024.0 * 1024.0) << " MiB/s) | "
+          << "header " << st.headerScanMs + st.tokenizeMs + st.loadHdrMs
+          << ", read " << st.readMs
+          << ", parse " << st.parseMs << " (imbalance " << std::setprecision(2) << st.Imbalance() << std::setprecision(1) << ")"
+          << ", merge " << st.mergeMs
+          << ", sort " << st.sortMs
+          << ", compact " << st.compactMs
+          << ", index " << st.indexMs << " ms";
+      if (st.firstFrameMs > 0.0)
+         out << " | first frame " << st.firstFrameMs << " ms";
+      return QString::fromStdString(out.str());
+   }
+} // namespace
+
 /* коэффициенты перевода единиц ------------------------------------------------*/
 const std::unordered_map<std::string, double> VcdViewerWidget::s_scale =
     {
@@ -52,12 +115,26 @@ void VcdViewerWidget::BuildUi()
    m_btnZoomOut->setIcon(QIcon(":icons/zoomOut.ico"));
    m_btnZoomReset = new QPushButton;
    m_btnZoomReset->setIcon(QIcon(":icons/zoomReset.ico"));
+   m_btnPrevEvent = new QPushButton(QStringLiteral("<"));
+   m_btnPrevEvent->setToolTip(QStringLiteral("Previous change of the shown signals"));
+   m_btnNextEvent = new QPushButton(QStringLiteral(">"));
+   m_btnNextEvent->setToolTip(QStringLiteral("Next change of the shown signals"));
 
    m_btnInsert = new QPushButton(QStringLiteral("Insert"));
    m_btnReplace = new QPushButton(QStringLiteral("Replace"));
    m_btnAppend = new QPushButton(QStringLiteral("Append"));
 
    m_btnApplyRange = new QPushButton(QStringLiteral("Apply"));
+   m_btnExport = new QPushButton(QStringLiteral("Export…"));
+   m_btnExport->setToolTip(QStringLiteral("Export visible signals/range to a new VCD"));
+   m_btnDiagnostics = new QPushButton(QStringLiteral("Memory"));
+   m_btnDiagnostics->setToolTip(QStringLiteral("Show memory breakdown of the loaded file"));
+   m_btnDiagnostics->setCheckable(true);
+   if (vcd::trace::IsCompiledIn())
+   {
+      m_btnSaveTrace = new QPushButton(QStringLiteral("Trace…"));
+      m_btnSaveTrace->setToolTip(QStringLiteral("Save collected trace events (chrome://tracing, Perfetto)"));
+   }
    m_editFrom = new QLineEdit;
    m_editFrom->setPlaceholderText("From");
    m_editTo = new QLineEdit;
@@ -73,6 +150,12 @@ void VcdViewerWidget::BuildUi()
 
    m_lblCursorMarker = new QLabel(this);
 
+   m_diagnostics = new QPlainTextEdit(this);
+   m_diagnostics->setReadOnly(true);
+   m_diagnostics->setFont(QFont(QStringLiteral("Monospace")));
+   m_diagnostics->setLineWrapMode(QPlainTextEdit::NoWrap);
+   m_diagnostics->setVisible(false);
+
    /* --- модели ------------------------------------------------------ */
    m_moduleModel = new ModuleTreeModel(this);
    m_signalModel = new SignalTreeModel(this);
@@ -80,6 +163,7 @@ void VcdViewerWidget::BuildUi()
 
    m_modulesView->setModel(m_moduleModel);
    m_modulesView->setHeaderHidden(true);
+   m_modulesView->setContextMenuPolicy(Qt::CustomContextMenu);
 
    m_signalTreeView->setModel(m_signalModel);
 
@@ -99,6 +183,7 @@ void VcdViewerWidget::BuildUi()
    leftLayout->addWidget(m_modulesView);
    leftLayout->addWidget(m_pinsView);
    leftLayout->addLayout(opLayout);
+   leftLayout->addWidget(m_diagnostics);
 
    QWidget *leftWidget = new QWidget(this);
    leftWidget->setLayout(leftLayout);
@@ -142,7 +227,13 @@ void VcdViewerWidget::BuildUi()
    topLayout->addWidget(m_btnZoomIn);
    topLayout->addWidget(m_btnZoomOut);
    topLayout->addWidget(m_btnZoomReset);
+   topLayout->addWidget(m_btnPrevEvent);
+   topLayout->addWidget(m_btnNextEvent);
    topLayout->addLayout(rangeLayout);
+   topLayout->addWidget(m_btnExport);
+   topLayout->addWidget(m_btnDiagnostics);
+   if (m_btnSaveTrace)
+      topLayout->addWidget(m_btnSaveTrace);
    topLayout->addWidget(m_lblCursorMarker);
    topLayout->addStretch(1);
 
@@ -159,6 +250,8 @@ void VcdViewerWidget::MakeConnections()
    m_reader = new VcdAsyncFileReader(this);
    connect(this, &VcdViewerWidget::AskForReadFile,
            m_reader, &VcdAsyncFileReader::ReadFile);
+   connect(this, &VcdViewerWidget::AskForReadFiles,
+           m_reader, &VcdAsyncFileReader::ReadFiles);
    connect(m_reader, &VcdAsyncFileReader::ReadFileReady,
            this, &VcdViewerWidget::OnReadFileReady);
    connect(m_reader, &VcdAsyncFileReader::ReadFileError,
@@ -169,6 +262,10 @@ void VcdViewerWidget::MakeConnections()
    connect(m_btnZoomOut, &QPushButton::clicked, this, &VcdViewerWidget::OnZoomOutClicked);
    connect(m_btnZoomReset, &QPushButton::clicked, this, &VcdViewerWidget::OnZoomResetClicked);
 
+   /* переход по событиям */
+   connect(m_btnPrevEvent, &QPushButton::clicked, m_waveView, &WaveformView::GoToPrevEvent);
+   connect(m_btnNextEvent, &QPushButton::clicked, m_waveView, &WaveformView::GoToNextEvent);
+
    /* сигнал-кнопки */
    connect(m_btnAppend, &QPushButton::clicked, this, &VcdViewerWidget::OnAppendSignals);
    connect(m_btnReplace, &QPushButton::clicked, this, &VcdViewerWidget::OnReplaceSignals);
@@ -177,12 +274,21 @@ void VcdViewerWidget::MakeConnections()
    /* диапазон */
    connect(m_btnApplyRange, &QPushButton::clicked,
            this, &VcdViewerWidget::OnApplyRangeClicked);
+   connect(m_btnExport, &QPushButton::clicked,
+           this, &VcdViewerWidget::OnExportClicked);
+   connect(m_btnDiagnostics, &QPushButton::toggled,
+           this, &VcdViewerWidget::OnDiagnosticsToggled);
+   if (m_btnSaveTrace)
+      connect(m_btnSaveTrace, &QPushButton::clicked,
+              this, &VcdViewerWidget::OnSaveTraceClicked);
 
    /* дерево модулей → реакция на клик (вернули) */
    connect(m_modulesView, &QTreeView::clicked,
            m_moduleModel, &ModuleTreeModel::OnItemClicked);
    connect(m_moduleModel, &ModuleTreeModel::ModuleClicked,
            this, &VcdViewerWidget::OnModuleClicked);
+   connect(m_modulesView, &QTreeView::customContextMenuRequested,
+           this, &VcdViewerWidget::OnModulesContextMenu);
 
    /* сигнал-значения */
    connect(m_pinModel, &PinTableModel::PinClicked,
@@ -190,6 +296,8 @@ void VcdViewerWidget::MakeConnections()
 
    connect(m_signalModel, &SignalTreeModel::SignalListChanged,
            m_waveView, &WaveformView::UpdateSignals);
+   connect(m_signalModel, &SignalTreeModel::SignalListChanged,
+           this, &VcdViewerWidget::RefreshDiagnostics);
 
    connect(m_pinsView, &QTreeView::doubleClicked, m_pinModel, &PinTableModel::OnItemClicked);
    connect(m_pinModel, &PinTableModel::PinClicked, m_signalModel, &SignalTreeModel::AppendSignal);
@@ -206,6 +314,8 @@ void VcdViewerWidget::MakeConnections()
            this, &VcdViewerWidget::MarkerPositionUpdated);
    connect(m_waveView, &WaveformView::PointerPositionChanged,
            this, &VcdViewerWidget::CursorPositionUpdated);
+   connect(m_waveView, &WaveformView::FirstFramePainted,
+           this, &VcdViewerWidget::OnFirstFramePainted);
 
    /* scroll-sync */
    QScrollBar *treeSB = m_signalTreeView->GetVerticalScrollBar();
@@ -290,114 +400,91 @@ VcdViewerWidget::ParseTime(const QString &txt) const
 
 void VcdViewerWidget::OnPrepareReport(std::shared_ptr<vcd::Handle> handle)
 {
-   uint64_t totalSwitchings = 0;
-
-   // Стек для обхода модулей в глубину
-   std::stack<std::shared_ptr<vcd::Module>> moduleStack;
-   moduleStack.push(handle->GetRootModule());
-
-   // Вектор для хранения статистики по модулям
-   std::vector<std::pair<std::string, uint64_t>> moduleStats;
-   // Вектор для хранения статистики по пинам
-   std::vector<std::tuple<std::string, std::string, uint64_t>> pinStats;
+   if (!handle)
+      return;
 
-   // Лямбда для получения полного имени модуля (путь от корня)
-   auto getFullModuleName = [](std::shared_ptr<vcd::Module> module)
+   // Окно отчёта: поля From-To, если заданы, иначе всё время моделирования
+   vcd::ReportOptions opt;
+   if (!m_editFrom->text().isEmpty() && !m_editTo->text().isEmpty())
    {
-      std::vector<std::string> parts;
-      auto current = module;
-      while (current)
-      {
-         parts.push_back(std::string(current->GetName()));
-         auto parent = current->GetParent().lock();
-         current = parent;
-      }
-      std::reverse(parts.begin(), parts.end());
-      std::string fullName;
-      for (size_t i = 0; i < parts.size(); ++i)
-      {
-         if (i != 0)
-            fullName += ".";
-         fullName += parts[i];
-      }
-      return fullName;
-   };
+      const auto from = ParseTime(m_editFrom->text());
+      const auto to = ParseTime(m_editTo->text());
+      if (from && to && *from < *to)
+         opt.windows.push_back({*from, *to});
+   }
+
+   // Расчёт в пуле потоков; устаревший отчёт (файл уже перезагружен) отбрасывается
+   const quint64 generation = ++m_reportGeneration;
+   QPointer<VcdViewerWidget> guard(this);
+   QtConcurrent::run([guard, generation, handle = std::move(handle), opt = std::move(opt)]()
+                     {
+      const vcd::Report report = vcd::BuildReport(*handle, opt);
+      const QString text = FormatReport(report, handle->GetTimeScale());
+
+      QMetaObject::invokeMethod(qApp, [guard, generation, text]()
+                                {
+         if (guard && guard->m_reportGeneration == generation)
+            emit guard->ReportReady(text); }, Qt::QueuedConnection); });
+}
 
-   // Обход дерева модулей
-   while (!moduleStack.empty())
+/*------------------------- export -----------------------------------------*/
+void VcdViewerWidget::OnExportClicked()
+{
+   const auto handle = m_waveView->GetHandle();
+   if (!handle || m_waveView->GetSignals().empty())
    {
-      auto currentModule = moduleStack.top();
-      moduleStack.pop();
+      QMessageBox::information(this, tr("Export"), tr("Нет отображаемых сигналов"));
+      return;
+   }
 
-      uint64_t moduleSwitches = 0;
-      std::string moduleFullName = getFullModuleName(currentModule);
+   const QString path = QFileDialog::getSaveFileName(this, tr("Export VCD"), QString(), tr("VCD (*.vcd)"));
+   if (path.isEmpty())
+      return;
 
-      // Перебираем все пины текущего модуля
-      for (const auto &pin : currentModule->GetPins())
+   vcd::WriteOptions opt;
+   std::tie(opt.t0, opt.t1) = m_waveView->GetVisibleRange();
+   for (const auto &pin : m_waveView->GetSignals())
+      opt.signals.push_back(pin);
+
+   // Запись в пуле потоков, результат — в GUI-поток
+   QPointer<VcdViewerWidget> guard(this);
+   QtConcurrent::run([guard, handle, opt = std::move(opt), path]()
+                     {
+      QString message;
+      try
       {
-         uint64_t pinSwitches = 0;
-         std::string pinTypeStr;
-
-         // Определяем тип пина и количество переключений
-         if (pin->GetPinType() == vcd::PinType::parameter)
-         {
-            pinTypeStr = "Parameter";
-            // Параметры не имеют переключений
-         }
-         else
-         {
-            // Для простых пинов
-            if (auto simplePin = std::dynamic_pointer_cast<vcd::SimplePinDescription>(pin))
-            {
-               pinTypeStr = "Signal";
-               pinSwitches = simplePin->GetTimeline().size();
-            }
-            // Для шин
-            else if (auto busPin = std::dynamic_pointer_cast<vcd::BusPinDescription>(pin))
-            {
-               pinTypeStr = "Bus";
-               pinSwitches = busPin->GetTimeline().size();
-            }
-
-            // Добавляем статистику по пину
-            pinStats.emplace_back(moduleFullName, std::string(pin->GetName()), pinSwitches);
-            moduleSwitches += pinSwitches;
-         }
+         const vcd::WriteResult res = vcd::WriteVcd(*handle, path.toStdString(), opt);
+         message = tr("Записано сигналов: %1, изменений: %2").arg(res.signals).arg(res.changes);
       }
-
-      totalSwitchings += moduleSwitches;
-      moduleStats.emplace_back(moduleFullName, moduleSwitches);
-
-      // Добавляем подмодули в стек в обратном порядке для сохранения исходного порядка обхода
-      auto subModules = currentModule->subModules();
-      for (auto it = subModules.rbegin(); it != subModules.rend(); ++it)
+      catch (const std::exception &ex)
       {
-         moduleStack.push(*it);
+         message = QString::fromStdString(ex.what());
       }
-   }
 
-   // Формируем отчет
-   std::stringstream report;
-   report << "Временной масштаб: " << handle->GetTimeScale() << std::endl;
-   report << "Общее время моделирования: " << handle->GetMaxTs() << handle->GetTimeScale().substr(1) << std::endl;
+      QMetaObject::invokeMethod(qApp, [guard, message]()
+                                {
+         if (guard)
+            QMessageBox::information(guard, tr("Export"), message); }, Qt::QueuedConnection); });
+}
 
-   report << "Общее количество переключений: " << totalSwitchings << std::endl
-          << std::endl;
+/*------------------------- трасса -----------------------------------------*/
+void VcdViewerWidget::OnSaveTraceClicked()
+{
+   const QString path = QFileDialog::getSaveFileName(this, tr("Save trace"), QStringLiteral("vcdviewer-trace.json"),
+                                                     tr("Trace JSON (*.json)"));
+   if (path.isEmpty())
+      return;
 
-   report << "Статистика по модулям:" << std::endl;
-   for (const auto &[name, switches] : moduleStats)
+   try
    {
-      report << name << ": " << switches << " переключений" << std::endl;
+      const std::size_t events = vcd::trace::WriteJson(path.toStdString());
+      vcd::trace::Clear(); // следующая запись — только новые события
+      emit StatusMessage(tr("Trace: %1 events -> %2").arg(events).arg(path));
    }
-
-   report << std::endl
-          << "Статистика по сигналам и шинам:" << std::endl;
-   for (const auto &[moduleName, pinName, switches] : pinStats)
+   catch (const std::exception &ex)
    {
-      report << moduleName << "." << pinName << ": " << switches << " переключений" << std::endl;
+      QMessageBox::warning(this, tr("Save trace"), QString::fromStdString(ex.what()));
    }
-
-   emit ReportReady(QString::fromStdString(report.str()));
 }
 
 /*------------------------- label update -----------------------------------*/
@@ -451,9 +538,71 @@ void VcdViewerWidget::OnModuleClicked(std::shared_ptr<Module> module)
    m_pinModel->SetModule(module);
 }
 
+/*------------------------- «только этот scope» ----------------------------*/
+void VcdViewerWidget::OnModulesContextMenu(const QPoint &pos)
+{
+   std::shared_ptr<Module> module =
+       m_moduleModel->GetModuleByIndex(m_modulesView->indexAt(pos));
+
+   QMenu menu(this);
+   QAction *onlyScope = menu.addAction(tr("Load only this scope"));
+   QAction *allScopes = menu.addAction(tr("Load all scopes"));
+   onlyScope->setEnabled(module != nullptr);
+   allScopes->setEnabled(m_reader->HasFilter());
+
+   QAction *chosen = menu.exec(m_modulesView->viewport()->mapToGlobal(pos));
+   if (!chosen)
+      return;
+
+   vcd::SignalFilter filter;
+   if (chosen == onlyScope)
+   {
+      /* путь модуля от корня: "tb.dut.core0" */
+      std::string path(module->GetName());
+      for (auto parent = module->GetParent().lock(); parent; parent = parent->GetParent().lock())
+         path = std::string(parent->GetName()) + '.' + path;
+      filter.Include(path + ".*");
+   }
+
+   UnloadPreviousData();
+   m_reader->ReloadWithFilter(std::move(filter));
+}
+
+/*------------------------- диагностика памяти ------------------------------*/
+void VcdViewerWidget::OnDiagnosticsToggled(bool on)
+{
+   m_diagnostics->setVisible(on);
+   RefreshDiagnostics();
+}
+
+void VcdViewerWidget::RefreshDiagnostics()
+{
+   if (!m_diagnostics->isVisible())
+      return;
+
+   const auto handle = m_waveView->GetHandle();
+   if (!handle)
+   {
+      m_diagnostics->setPlainText(QStringLiteral("No file loaded"));
+      return;
+   }
+
+   const std::size_t items = m_waveView->GetItemsMemoryBytes();
+   std::ostringstream out;
+   out << handle->MemoryUsage();
+   out << "wave items:\n  " << std::left << std::setw(18) << "paths + labels" << std::right << std::setw(12) << items
+       << " B  " << std::fixed << std::setprecision(2) << std::setw(9) << items / (1024.0 * 1024.0) << " MiB\n";
+   const auto rss = handle->GetRssInfo();
+   out << "rss after load:\n  peak " << rss.peakBytes << " B, steady " << rss.steadyBytes << " B\n";
+   m_diagnostics->setPlainText(QString::fromStdString(out.str()));
+}
+
 /*------------------------- чтение VCD -------------------------------------*/
-void VcdViewerWidget::OnReadFileReady(std::shared_ptr<vcd::Handle> h)
+void VcdViewerWidget::OnReadFileReady(std::shared_ptr<vcd::Handle> h, const vcd::LoadStats &stats)
 {
+   m_loadStats = stats;
+   emit StatusMessage(FormatLoadStats(m_loadStats));
+
    m_timeScale = h->GetTimeScale();
    if (m_timeScale.empty())
       m_timeScale = "1ns";
@@ -463,11 +612,22 @@ void VcdViewerWidget::OnReadFileReady(std::shared_ptr<vcd::Handle> h)
    m_signalModel->SetHandle(h);
    m_pinModel->SetHandle(h);
    m_waveView->SetHandle(h);
+   RefreshDiagnostics();
 
    m_prevZoomOut.store(false);
    QTimer::singleShot(200, this, &VcdViewerWidget::FixZoom);
 }
 
+void VcdViewerWidget::OnFirstFramePainted()
+{
+   if (m_loadStats.loader.empty())
+      return;
+   m_loadStats.firstFrameMs = std::chrono::duration<double, std::milli>(
+                                  std::chrono::steady_clock::now() - m_loadStats.openedAt)
+                                  .count();
+   emit StatusMessage(FormatLoadStats(m_loadStats));
+}
+
 void VcdViewerWidget::OnReadFileError(const QString &msg)
 {
    QMessageBox::warning(this, QStringLiteral("Read error"), msg);
@@ -578,10 +738,13 @@ void VcdViewerWidget::UnloadPreviousData()
    m_signalModel->SetHandle(nullptr);
    m_pinModel->SetHandle(nullptr);
    m_waveView->SetHandle(nullptr);
+   m_loadStats = vcd::LoadStats{};
+   emit StatusMessage(QString());
 
    m_markerPos.reset();
    m_cursorPos.reset();
    UpdateMarkerAndCursorLabel();
+   RefreshDiagnostics();
 }
 
 void VcdViewerWidget::UpdateMarkerPosition(quint64 pos)
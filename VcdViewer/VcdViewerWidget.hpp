@@ -23,6 +23,7 @@ class QTableView;
 class QLabel;
 class QLineEdit;
 class QPushButton;
+class QPlainTextEdit;
 class QScrollBar;
 class QSplitter;
 
@@ -38,6 +39,7 @@ public:
 
 signals:
    void AskForReadFile(QString filePath);
+   void AskForReadFiles(QStringList filePaths);
 
    void MarkerPositionUpdated(quint64 pos);
    void CursorPositionUpdated(quint64 pos);
@@ -45,6 +47,9 @@ signals:
    void AskForReportPreparation(std::shared_ptr<vcd::Handle> handle);
    void ReportReady(const QString& report);
 
+   /// Сводка загрузки для строки состояния главного окна.
+   void StatusMessage(const QString &text);
+
 public slots:
    void FixZoom();
    void UnloadPreviousData();
@@ -64,14 +69,28 @@ private slots:
 
    /* дерево модулей → таблица пинов */
    void OnModuleClicked(std::shared_ptr<vcd::Module> module);
+   void OnModulesContextMenu(const QPoint &pos);
 
    /* диапазон «From-To» */
    void OnApplyRangeClicked();
 
+   /* запись видимых сигналов и диапазона в новый VCD */
+   void OnExportClicked();
+
+   /* панель диагностики памяти */
+   void OnDiagnosticsToggled(bool on);
+   void RefreshDiagnostics();
+
+   /* запись накопленной трассы (сборка с VCD_ENABLE_TRACE) */
+   void OnSaveTraceClicked();
+
    /* асинхронный ридер */
    void
    OnReadFileReady(
-       std::shared_ptr<vcd::Handle> handle);
+       std::shared_ptr<vcd::Handle> handle,
+       const vcd::LoadStats &stats);
+
+   void OnFirstFramePainted();
 
    void OnReadFileError(
        const QString &msg);
@@ -117,10 +136,17 @@ private:
    QPushButton *m_btnZoomIn{nullptr};
    QPushButton *m_btnZoomOut{nullptr};
    QPushButton *m_btnZoomReset{nullptr};
+   QPushButton *m_btnPrevEvent{nullptr};
+   QPushButton *m_btnNextEvent{nullptr};
    QPushButton *m_btnInsert{nullptr};
    QPushButton *m_btnReplace{nullptr};
    QPushButton *m_btnAppend{nullptr};
    QPushButton *m_btnApplyRange{nullptr};
+   QPushButton *m_btnExport{nullptr};
+   QPushButton *m_btnDiagnostics{nullptr};
+   QPushButton *m_btnSaveTrace{nullptr}; ///< только при VCD_ENABLE_TRACE
+
+   QPlainTextEdit *m_diagnostics{nullptr}; ///< разбивка памяти Handle и wave-элементов
 
    QLabel *m_lblCursorMarker{nullptr};
    QLineEdit *m_editFrom{nullptr};
@@ -129,6 +155,8 @@ private:
    std::atomic_bool m_prevZoomOut{false};
    std::optional<quint64> m_markerPos;
    std::optional<quint64> m_cursorPos;
+   quint64 m_reportGeneration{0}; ///< номер последнего запрошенного отчёта
+   vcd::LoadStats m_loadStats;     ///< фазы загрузки текущего файла
 
    std::string m_timeScale; ///< «1ns» -> «ns»
    uint64_t m_maxTs;
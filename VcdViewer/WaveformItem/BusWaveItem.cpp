@@ -1,243 +1,361 @@
 #include "WaveItems.hpp"
+#include "TileCache.hpp"
 
-#include <QDebug>
+#include <QApplication>
+#include <QPointer>
+#include <QtConcurrent>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <iterator>
 #include "Include/Bin2Hex.hpp"
 
 namespace
 {
-   QString binToHex(QString bin)
-   {
-      return QString::fromStdString(utils::BinaryToHex(bin.toStdString()));
-   }
+   constexpr double kBevelPx = WAVEFORM_HEIGHT / 10.0; // скос ромба, в пикселях
 
    /* классификация bus-строки */
-   char classifyBus(QString v)
+   char classifyBus(std::string_view v)
    {
-      if (v.isEmpty())
+      if (v.empty())
          return 'd';
       if (std::all_of(v.begin(), v.end(),
-                      [](QChar c)
-                      { return c == u'z' || c == u'Z'; }))
+                      [](char c)
+                      { return c == 'z' || c == 'Z'; }))
          return 'z';
       if (std::any_of(v.begin(), v.end(),
-                      [](QChar c)
-                      { return c == u'x' || c == u'X'; }))
+                      [](char c)
+                      { return c == 'x' || c == 'X'; }))
          return 'x';
       return 'd';
    }
-} // unnamed namespace
 
-/* ===== ctor ===== */
-MultipleWaveItem::MultipleWaveItem(
-    const std::shared_ptr<vcd::Handle> &h,
-    std::shared_ptr<vcd::BusPinDescription> p,
-    int yOffset,
-    double scale,
-    QGraphicsItem *parent)
-    : QGraphicsItem(parent), m_scaleCoeff(scale), m_handle(h), m_pin(std::move(p))
-{
-   setPos(0, yOffset);
-   // setCacheMode(DeviceCoordinateCache);
-   PreparePaths();
-}
+   /* hex только из чистых 0/1 (BinaryToHex бросает на z внутри значения) */
+   QString labelFor(char cls, std::string_view bits)
+   {
+      if (cls == 'x')
+         return QStringLiteral("x");
+      if (!std::all_of(bits.begin(), bits.end(),
+                       [](char c)
+                       { return c == '0' || c == '1'; }))
+         return QString::fromLatin1(bits.data(), int(bits.size()));
+      return QString::fromStdString(utils::BinaryToHex(std::string(bits)));
+   }
+} // unnamed namespace
 
 /* =========================================================================
- *  PreparePaths  (перестраивается при зуме — scaleCoeff)
+ *  BuildBusGeometry  (только чтение загруженного pin: вызывается из пула)
  * ========================================================================= */
-void MultipleWaveItem::PreparePaths()
+BusGeometry BuildBusGeometry(const vcd::BusPinDescription &pin, std::uint64_t maxTs,
+                             double x0, double x1, double pxPerTs)
 {
-   /* 0. очистка ------------------------------------------------------- */
-   m_pathDataUpper = m_pathDataLower = QPainterPath();
-   m_pathXUpper = m_pathXLower = QPainterPath();
-   m_pathZ = QPainterPath();
-   m_labels.clear();
-
-   /* 1. геометрия по Y -------------------------------------------------- */
-   const int yU = SPACING;         // верх
-   const int yL = WAVEFORM_HEIGHT; // низ
-   const int yM = (yU + yL) / 2;   // середина
-   const double xStep = (WAVEFORM_HEIGHT / 10.0) * m_scaleCoeff;
-
-   auto stairs = [=](QPainterPath &up, QPainterPath &lo,
-                     double x, bool right)
+   VCD_TRACE_SCOPE("BuildBusGeometry");
+   const auto start = std::chrono::steady_clock::now();
+   using vcd::PinValue;
+
+   BusGeometry g;
+   g.x0 = x0;
+   g.x1 = x1;
+   g.pxPerTs = pxPerTs;
+
+   const std::string init = pin.GetInitState();
+   const auto &tl = pin.GetTimeline();
+   const double tsPerPx = 1.0 / pxPerTs;
+
+   auto push = [&](double a, double b, std::string_view bits)
    {
-      if (!right)
-      { /* левый угол */
-         up.lineTo(x + xStep, yU);
-         lo.lineTo(x + xStep, yL);
-      }
-      else
-      { /* правый угол */
-         up.lineTo(x - xStep, yU);
-         up.lineTo(x, yM);
-         lo.lineTo(x - xStep, yL);
-         lo.lineTo(x, yM);
-      }
+      if (b <= a)
+         return;
+      const char cls = classifyBus(bits);
+      // подпись нужна, только если в отрезок влезает хотя бы «+»
+      const bool wide = (b - a) * pxPerTs > 2 * kBevelPx + 4;
+      g.segments.push_back({a, b, cls, cls != 'z' && wide ? labelFor(cls, bits) : QString()});
    };
 
-   /* 2. инициализация состояний --------------------------------------- */
-   const QString init = QString::fromStdString(m_pin->GetInitState());
-   const auto &tl = m_pin->GetTimeline();
-   auto it = tl.begin();
-
-   char curCls = 'd';
-   QString curBits = "0"; // для hex-подписи
-   if (!init.isEmpty())
+   // значение и начало отрезка, в котором лежит x0
+   auto it = std::upper_bound(tl.begin(), tl.end(), x0,
+                              [](double ts, const PinValue &v)
+                              { return ts < static_cast<double>(v.timestamp); });
+   std::string_view curBits;
+   double segBeg = 0;
+   if (it != tl.begin())
+   {
+      curBits = std::prev(it)->value;
+      segBeg = static_cast<double>(std::prev(it)->timestamp);
+   }
+   else if (!init.empty())
    {
       curBits = init;
-      curCls = ::classifyBus(init);
    }
-   else if (it != tl.end())
+   else
    {
-      curBits = QString::fromLatin1(it->value.data(), int(it->value.size()));
-      curCls = ::classifyBus(curBits);
+      curBits = tl.empty() ? std::string_view("0") : tl.front().value;
    }
 
-   quint64 segBeg = 0; // левая граница текущего ромба
-
-   /* 3. helpers open/close -------------------------------------------- */
-   auto open = [&](char cls, quint64 x, const QString &raw)
+   while (it != tl.end() && static_cast<double>(it->timestamp) <= x1)
    {
-      if (cls == 'd' || cls == 'x')
-      { // и «data», и «x» имеют подписи
-         segBeg = x;
-         curBits = raw; // raw игнорируется для «x»
-      }
-
-      switch (cls)
+      const double ts = static_cast<double>(it->timestamp);
+      // правая граница пиксельного столбца, в который попал фронт
+      const double colEnd = x0 + (std::floor((ts - x0) * pxPerTs) + 1.0) * tsPerPx;
+      auto next = std::lower_bound(it, tl.end(), colEnd,
+                                   [](const PinValue &v, double t)
+                                   { return static_cast<double>(v.timestamp) < t; });
+      if (next == it)
+         ++next; // округление: фронт всегда попадает в свой столбец
+
+      push(segBeg, ts, curBits);
+      if (next - it == 1)
       {
-      case 'd':
-         m_pathDataUpper.moveTo(x, yM);
-         m_pathDataLower.moveTo(x, yM);
-         stairs(m_pathDataUpper, m_pathDataLower, x, false);
-         break;
-      case 'x':
-         m_pathXUpper.moveTo(x, yM);
-         m_pathXLower.moveTo(x, yM);
-         stairs(m_pathXUpper, m_pathXLower, x, false);
-         break;
-      case 'z':
-         m_pathZ.moveTo(x, yM);
-         break;
+         segBeg = ts;
       }
-   };
-
-   auto close = [&](char cls, quint64 x)
-   {
-      switch (cls)
+      else
       {
-      case 'd':
-         stairs(m_pathDataUpper, m_pathDataLower, x, true);
-         if (x > segBeg + 2 * xStep) // место под подпись
-            m_labels.push_back({static_cast<uint64_t>(segBeg + xStep),
-                                static_cast<uint64_t>(x - xStep),
-                                binToHex(QString(curBits))});
-         break;
-
-      case 'x':
-         stairs(m_pathXUpper, m_pathXLower, x, true);
-         if (x > segBeg + 2 * xStep)
-            m_labels.push_back({static_cast<uint64_t>(segBeg + xStep),
-                                static_cast<uint64_t>(x - xStep),
-                                QStringLiteral("x")});
-         break;
-
-      case 'z':
-         m_pathZ.lineTo(x, yM);
-         break;
+         g.segments.push_back({ts, colEnd, 'b', QString()});
+         segBeg = colEnd;
       }
-   };
+      curBits = std::prev(next)->value;
+      it = next;
+   }
+   push(segBeg, it != tl.end() ? static_cast<double>(it->timestamp) : static_cast<double>(maxTs), curBits);
 
-   /* 4. построение ломаных -------------------------------------------- */
-   open(curCls, 0, curBits);
+   g.buildNs = static_cast<std::uint64_t>(
+       std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+   return g;
+}
 
-   for (; it != tl.end(); ++it)
-   {
-      quint64 ts = it->timestamp;
-      QString raw = QString::fromLatin1(it->value.data(), int(it->value.size()));
-      char nxt = ::classifyBus(raw);
+/* ===== ctor ===== */
+MultipleWaveItem::MultipleWaveItem(
+    const std::shared_ptr<vcd::Handle> &h,
+    std::shared_ptr<vcd::BusPinDescription> p,
+    int yOffset,
+    QGraphicsItem *parent)
+    : QGraphicsItem(parent), m_handle(h), m_pin(std::move(p))
+{
+   setPos(0, yOffset);
+   // setCacheMode(DeviceCoordinateCache);
 
-      close(curCls, ts);
-      open(nxt, ts, raw);
-      curCls = nxt;
+   // exposedRect — реально открытая часть, а не весь boundingRect
+   setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+/* =========================================================================
+ *  RequestGeometry  (диапазон или масштаб вышли за готовую геометрию)
+ * ========================================================================= */
+void MultipleWaveItem::RequestGeometry(double x0, double x1, double pxPerTs)
+{
+   const std::uint64_t maxTs = m_handle->GetMaxTs();
+   if (!m_hasGeometry)
+   {
+      // первый кадр рисуется сразу, без пустой строки
+      m_geometry = BuildBusGeometry(*m_pin, maxTs, x0, x1, pxPerTs);
+      GetPathRebuildStats().bus.Add(m_geometry.buildNs);
+      m_hasGeometry = true;
+      return;
    }
-   close(curCls, m_handle->GetMaxTs());
+
+   // тот же запрос уже в работе
+   if (m_pending.pxPerTs == pxPerTs && m_pending.x0 <= x0 && m_pending.x1 >= x1)
+      return;
+   m_pending.x0 = x0;
+   m_pending.x1 = x1;
+   m_pending.pxPerTs = pxPerTs;
+
+   const std::uint64_t generation = ++m_generation;
+   QPointer<MultipleWaveItem> guard(this);
+   // handle держит ValuePool, в который смотрят строки шины, пока задача в пуле
+   QtConcurrent::run([guard, generation, handle = m_handle, pin = m_pin, maxTs, x0, x1, pxPerTs]()
+                     {
+      auto geometry = std::make_shared<BusGeometry>(BuildBusGeometry(*pin, maxTs, x0, x1, pxPerTs));
+
+      QMetaObject::invokeMethod(qApp, [guard, generation, geometry]()
+                                {
+         if (!guard)
+            return;
+         GetPathRebuildStats().bus.Add(geometry->buildNs);
+         if (guard->m_generation != generation)
+            return; // зум или скролл успели уйти дальше
+         guard->m_geometry = std::move(*geometry);
+         guard->update(); }, Qt::QueuedConnection); });
 }
 
 /* ======================================================================
  *  MultipleWaveItem :: paint()
  *  ────────────────────────────────────────────────────────────────────
- *  • выводит «ломаные» (зелёная, красная, жёлтая)
+ *  • отрезки из m_geometry переводятся в пиксели, скос ромба — kBevelPx
+ *    при любом зуме
  *  • поверх них — подписи шины (`hex`-текст | «+» | пусто)
  *    - шрифт фиксированного размера, не масштабируется вместе с вью
  * ===================================================================== */
+void MultipleWaveItem::SetTileCache(WaveTileCache *cache)
+{
+   m_tileCache = cache;
+   m_tileOwner = cache ? cache->OwnerFor(m_pin.get()) : 0;
+   for (auto *w : m_)
+      w->SetTileCache(cache);
+}
+
+void MultipleWaveItem::SetPin(std::shared_ptr<vcd::BusPinDescription> p)
+{
+   prepareGeometryChange();
+   for (auto *w : m_)
+      delete w;
+   m_.clear();
+   m_prepared = false;
+   m_isExpanded = false;
+
+   m_pin = std::move(p);
+   m_geometry = BusGeometry{};
+   m_pending = BusGeometry{};
+   m_hasGeometry = false;
+   ++m_generation; // геометрия прежнего пина, если ещё в пуле, не нужна
+   SetTileCache(m_tileCache);
+   update();
+}
+
 void MultipleWaveItem::paint(QPainter *p,
                              const QStyleOptionGraphicsItem *opt,
-                             QWidget *)
+                             QWidget *widget)
 {
-   /* ── линии ──────────────────────────────────────────────────────── */
+   VCD_TRACE_SCOPE("MultipleWaveItem::paint");
+   const double maxTs = static_cast<double>(m_handle->GetMaxTs());
+   if (m_tileCache && m_tileCache->Enabled())
+   {
+      PaintTiles(p, opt, *m_tileCache, m_tileOwner, maxTs, WAVEFORM_HEIGHT + SPACING,
+                 [handle = m_handle, pin = m_pin, maxTs](double ts0, double ts1, double pxPerTs, QSize size)
+                 {
+                    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+                    image.fill(Qt::transparent);
+                    QPainter tp(&image);
+                    tp.setRenderHint(QPainter::Antialiasing);
+                    tp.setTransform(QTransform(pxPerTs, 0, 0, 1, -ts0 * pxPerTs, 0));
+                    ts1 = std::min(ts1, maxTs);
+                    if (ts0 < ts1)
+                       PaintBusGeometry(&tp, BuildBusGeometry(*pin, static_cast<std::uint64_t>(maxTs), ts0, ts1, pxPerTs),
+                                        ts0, ts1);
+                    return image;
+                 });
+      return;
+   }
+
    p->setRenderHint(QPainter::Antialiasing);
    p->setClipRect(opt->exposedRect);
 
-   QPen pen(Qt::green, 1);
-   pen.setCosmetic(true);
-   p->setPen(pen);
-   p->drawPath(m_pathDataUpper);
-   p->drawPath(m_pathDataLower);
+   const double pxPerTs = p->worldTransform().m11() > 0 ? p->worldTransform().m11() : 1.0;
+   const double x0 = std::max(0.0, opt->exposedRect.left());
+   const double x1 = std::min(maxTs, opt->exposedRect.right());
+   if (x1 < x0)
+      return;
 
-   pen.setColor(Qt::red);
-   p->setPen(pen);
-   p->drawPath(m_pathXUpper);
-   p->drawPath(m_pathXLower);
+   /* запас в ширину viewport с каждой стороны: небольшой скролл без перестроения */
+   if (m_geometry.pxPerTs != pxPerTs || m_geometry.x0 > x0 || m_geometry.x1 < x1)
+   {
+      const double margin = std::max(x1 - x0, (widget ? widget->width() : 0) / pxPerTs);
+      RequestGeometry(std::max(0.0, x0 - margin), std::min(maxTs, x1 + margin), pxPerTs);
+   }
+   PaintBusGeometry(p, m_geometry, x0, x1);
+}
 
-   pen.setColor(Qt::yellow);
-   p->setPen(pen);
-   p->drawPath(m_pathZ);
+void PaintBusGeometry(QPainter *p, const BusGeometry &g, double x0, double x1)
+{
+   /* ── всё дальше — в пикселях ────────────────────────────────────── */
+   const QTransform t = p->worldTransform();
+   auto devX = [&](double x)
+   { return t.m11() * x + t.dx(); };
+   auto devY = [&](double y)
+   { return t.m22() * y + t.dy(); };
+   const double yU = devY(SPACING);         // верх
+   const double yL = devY(WAVEFORM_HEIGHT); // низ
+   const double yM = (yU + yL) / 2;         // середина
+   // отрезки обрезаются чуть шире видимой части: огромные координаты QPainter не любит
+   const double clipL = devX(x0) - 2 * kBevelPx;
+   const double clipR = devX(x1) + 2 * kBevelPx;
 
-   /* ── подписи ─────────────────────────────────────────────────────── */
    QFont fixedFont("Monospace");
    fixedFont.setPixelSize(12); // постоянный размер
    QFontMetrics fm(fixedFont);
    const int plusPx = fm.horizontalAdvance(u'+');
 
-   const double sx = p->worldTransform().m11(); // масштаб по X
-
    struct DevTxt
    {
       QPointF pos;
       QString txt;
    };
    std::vector<DevTxt> todo;
-   todo.reserve(m_labels.size());
+   QPainterPath data, xPath, zPath;
+   std::vector<QRectF> busy;
 
-   for (const BusLabel &lbl : m_labels)
+   for (const BusGeometry::Segment &seg : g.segments)
    {
-      double wPx = (lbl.x1 - lbl.x0) * sx;
-      if (wPx <= 0)
+      if (seg.x1 < x0 || seg.x0 > x1)
+         continue;
+      const bool cutL = devX(seg.x0) < clipL;
+      const bool cutR = devX(seg.x1) > clipR;
+      const double a = cutL ? clipL : devX(seg.x0);
+      const double b = cutR ? clipR : devX(seg.x1);
+
+      if (seg.cls == 'b')
+      {
+         busy.emplace_back(a, yU, std::max(1.0, b - a), yL - yU);
+         continue;
+      }
+      if (seg.cls == 'z')
+      {
+         zPath.moveTo(a, yM);
+         zPath.lineTo(b, yM);
          continue;
+      }
 
-      int fullPx = fm.horizontalAdvance(lbl.text);
+      /* ромб: скос с необрезанных сторон, не шире половины отрезка */
+      const double bevel = std::min(kBevelPx, (b - a) / 2);
+      const double bl = cutL ? 0 : bevel;
+      const double br = cutR ? 0 : bevel;
+      QPainterPath &path = seg.cls == 'x' ? xPath : data;
+      path.moveTo(a, yM);
+      path.lineTo(a + bl, yU);
+      path.lineTo(b - br, yU);
+      path.lineTo(b, yM);
+      path.lineTo(b - br, yL);
+      path.lineTo(a + bl, yL);
+      path.closeSubpath();
+
+      /* подпись — по центру видимой части отрезка */
+      const double wPx = b - a - bl - br;
+      if (seg.text.isEmpty() || wPx <= 0)
+         continue;
       QString draw;
-      if (fullPx <= wPx)
-         draw = lbl.text;
+      if (fm.horizontalAdvance(seg.text) <= wPx)
+         draw = seg.text;
       else if (plusPx <= wPx)
          draw = QStringLiteral("+");
       else
          continue;
-
-      double txtWScene = fm.horizontalAdvance(draw) / sx;
-      double xScene = lbl.x0 + ((lbl.x1 - lbl.x0) - txtWScene) / 2.0;
-      double yScene = (SPACING + WAVEFORM_HEIGHT) / 2.0 + fm.ascent() * 0.4;
-
-      todo.push_back({p->worldTransform().map(QPointF(xScene, yScene)),
-                      std::move(draw)});
+      const double xTxt = a + bl + (wPx - fm.horizontalAdvance(draw)) / 2.0;
+      todo.push_back({QPointF(xTxt, yM + fm.ascent() * 0.4), std::move(draw)});
    }
 
    /* выводим без трансформации (в пикселях) */
    p->save();
    p->resetTransform();
+
+   QPen pen(Qt::green, 1);
+   pen.setCosmetic(true);
+   p->setPen(pen);
+   p->drawPath(data);
+   if (!busy.empty())
+   {
+      p->setBrush(QBrush(Qt::darkGreen));
+      p->drawRects(busy.data(), static_cast<int>(busy.size()));
+      p->setBrush(Qt::NoBrush);
+   }
+
+   pen.setColor(Qt::red);
+   p->setPen(pen);
+   p->drawPath(xPath);
+
+   pen.setColor(Qt::yellow);
+   p->setPen(pen);
+   p->drawPath(zPath);
+
    p->setFont(fixedFont);
    p->setPen(Qt::white);
    for (const auto &d : todo)
@@ -258,36 +376,51 @@ QRectF MultipleWaveItem::boundingRect() const
 }
 
 /* ===== раскрытие/сворачивание ===== */
+std::size_t MultipleWaveItem::SubRowCount(const vcd::BusPinDescription &pin)
+{
+   const auto bits = pin.GetBitDepth();
+   const std::size_t nBits = bits.first - bits.second + 1;
+   // если в парсере заполняется pin->subPins(), используйте его.
+   return std::min(nBits, pin.GetSubPins().size());
+}
+
 void MultipleWaveItem::PrepareSubItems()
 {
    if (m_prepared)
       return;
    m_prepared = true;
 
-   const auto bits = m_pin->GetBitDepth();
-   std::size_t nBits = bits.first - bits.second + 1;
-   if (nBits == 0)
-      return;
-
+   const std::size_t nRows = SubRowCount(*m_pin);
+   const std::size_t nSub = m_pin->GetSubPins().size();
    int y = WAVEFORM_HEIGHT + SPACING;
-   for (std::size_t b = 0; b < nBits; ++b)
+   for (std::size_t b = 0; b < nRows; ++b)
    {
-      // если в парсере заполняется pin->subPins(), используйте его.
-      if (b < m_pin->GetSubPins().size())
-      {
-         auto subPin = m_pin->GetSubPins()[m_pin->GetSubPins().size() - b - 1];
-         auto *item = new SimpleWaveItem(m_handle, subPin, y, m_pin->GetSubPins().size() - b - 1, this);
-         item->setVisible(m_isExpanded);
-         m_.push_back(item);
-         y += WAVEFORM_HEIGHT + SPACING;
-      }
+      auto subPin = m_pin->GetSubPins()[nSub - b - 1];
+      auto *item = new SimpleWaveItem(m_handle, subPin, y, nSub - b - 1, this);
+      item->SetTileCache(m_tileCache);
+      item->setVisible(m_isExpanded);
+      m_.push_back(item);
+      y += WAVEFORM_HEIGHT + SPACING;
    }
 }
 
 void MultipleWaveItem::SetExpanded(bool on)
 {
+   prepareGeometryChange(); // высота boundingRect зависит от раскрытия
    m_isExpanded = on;
    PrepareSubItems();
    for (auto *w : m_)
       w->setVisible(m_isExpanded);
 }
+
+/* ===== диагностика памяти ===== */
+std::size_t MultipleWaveItem::MemoryBytes() const
+{
+   std::size_t bytes = m_geometry.segments.capacity() * sizeof(BusGeometry::Segment) +
+                       m_.capacity() * sizeof(SimpleWaveItem *);
+   for (const BusGeometry::Segment &seg : m_geometry.segments)
+      bytes += static_cast<std::size_t>(seg.text.capacity()) * sizeof(QChar);
+   for (const auto *w : m_)
+      bytes += w->MemoryBytes();
+   return bytes;
+}
@@ -12,6 +12,7 @@ void DumpoffItem::paint(QPainter *p,
                         const QStyleOptionGraphicsItem *opt,
                         QWidget *)
 {
+   VCD_TRACE_SCOPE("DumpoffItem::paint");
    if (m_ranges.empty())
    {
       return;
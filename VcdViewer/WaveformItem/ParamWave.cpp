@@ -30,6 +30,7 @@ void ParamWaveItem::paint(QPainter *p,
                           const QStyleOptionGraphicsItem *opt,
                           QWidget *)
 {
+   VCD_TRACE_SCOPE("ParamWaveItem::paint");
    /* ---------- обычная отрисовка волны ------------- */
    const qreal x0 = qMax<qreal>(0, opt->exposedRect.left());
    const qreal x1 = qMin<qreal>(m_handle->GetMaxTs(),
@@ -66,3 +67,15 @@ void ParamWaveItem::paint(QPainter *p,
 
    p->restore();
 }
+
+void ParamWaveItem::SetPin(std::shared_ptr<vcd::ParamPinDescription> p)
+{
+   m_pin = std::move(p);
+   update();
+}
+
+std::size_t
+ParamWaveItem::MemoryBytes() const
+{
+   return m_label ? static_cast<std::size_t>(m_label->text().capacity()) * sizeof(QChar) : 0;
+}
@@ -1,8 +1,10 @@
 #include "Include/VcdStructs.hpp"
 #include "WaveItems.hpp"
+#include "TileCache.hpp"
 
-#include <QDebug>
-#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 
 SimpleWaveItem::SimpleWaveItem(const std::shared_ptr<vcd::Handle> &h,
                                std::shared_ptr<vcd::SimplePinDescription> p,
@@ -14,8 +16,8 @@ SimpleWaveItem::SimpleWaveItem(const std::shared_ptr<vcd::Handle> &h,
    setPos(0, yOffset);
    // setCacheMode(DeviceCoordinateCache);
 
-   // Предвар ительно строим полный путь один раз
-   PrecalcFullPath();
+   // exposedRect — реально открытая часть, а не весь boundingRect
+   setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
 }
 
 QRectF
@@ -27,30 +29,81 @@ SimpleWaveItem::boundingRect() const
            qreal(WAVEFORM_HEIGHT + SPACING)};
 }
 
+void SimpleWaveItem::SetTileCache(WaveTileCache *cache)
+{
+   m_tileCache = cache;
+   m_tileOwner = cache ? cache->OwnerFor(m_pin.get(), m_idx.value_or(0)) : 0;
+}
+
+void SimpleWaveItem::SetPin(std::shared_ptr<vcd::SimplePinDescription> p)
+{
+   m_pin = std::move(p);
+   m_visible = SimpleGeometry{};
+   SetTileCache(m_tileCache);
+   update();
+}
+
 void SimpleWaveItem::paint(QPainter *p,
                            const QStyleOptionGraphicsItem *opt,
                            QWidget *)
 {
+   VCD_TRACE_SCOPE("SimpleWaveItem::paint");
+   if (m_tileCache && m_tileCache->Enabled())
+   {
+      const double maxTs = m_handle->GetMaxTs();
+      PaintTiles(p, opt, *m_tileCache, m_tileOwner, maxTs, WAVEFORM_HEIGHT + SPACING,
+                 [handle = m_handle, pin = m_pin, bit = m_idx.value_or(0), maxTs](double ts0, double ts1, double pxPerTs, QSize size)
+                 {
+                    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+                    image.fill(Qt::transparent);
+                    QPainter tp(&image);
+                    tp.setRenderHint(QPainter::Antialiasing);
+                    tp.setTransform(QTransform(pxPerTs, 0, 0, 1, -ts0 * pxPerTs, 0));
+                    if (ts0 < maxTs)
+                       PaintSimpleGeometry(&tp, BuildSimpleGeometry(*pin, bit, ts0, std::min(ts1, maxTs), pxPerTs));
+                    return image;
+                 });
+      return;
+   }
+
    p->setRenderHint(QPainter::Antialiasing);
    p->setClipRect(opt->exposedRect);
    // границы по X видимой области
    const qreal x0 = std::max<qreal>(0, opt->exposedRect.left());
    const qreal x1 = std::min<qreal>(m_handle->GetMaxTs(),
                                     opt->exposedRect.right());
+   if (x1 < x0)
+      return;
 
+   // пикселей на одну метку времени (масштаб по X из вида)
+   const qreal pxPerTs = p->worldTransform().m11() > 0 ? p->worldTransform().m11() : 1.0;
+   // готовая геометрия шире exposedRect (узкая полоса курсора) — берём её, обрежет clip
+   if (m_visible.pxPerTs != pxPerTs || m_visible.x0 > x0 || m_visible.x1 < x1)
+   {
+      PathRebuildTimer rebuildTimer(GetPathRebuildStats().simple);
+      m_visible = BuildSimpleGeometry(*m_pin, m_idx.value_or(0), x0, x1, pxPerTs);
+   }
+   PaintSimpleGeometry(p, m_visible);
+}
+
+void PaintSimpleGeometry(QPainter *p, const SimpleGeometry &g)
+{
    QPen pen(Qt::green, 1);
    pen.setCosmetic(true);
    p->setPen(pen);
-   p->drawPath(m_precalcedPath);
+   p->drawPath(g.levels);
+
+   if (!g.busy.empty())
+   {
+      p->setBrush(QBrush(Qt::darkGreen));
+      p->drawRects(g.busy.data(), static_cast<int>(g.busy.size()));
+   }
 
    QPen yellowPen(Qt::yellow, 1);
    yellowPen.setCosmetic(true);
    p->setPen(yellowPen);
-
-   for (const auto &it : m_precalcedZPath)
-   {
-      p->drawPath(it);
-   }
+   p->setBrush(Qt::NoBrush);
+   p->drawPath(g.z);
 
    QPen redPen = QPen(Qt::red);
    redPen.setCosmetic(true);
@@ -60,127 +113,116 @@ void SimpleWaveItem::paint(QPainter *p,
    p->setPen(redPen);
    p->setBrush(darkRedBrush);
 
-   for (const auto &it : m_precalcedXRectangles)
-   {
-      p->drawRect(it);
-   }
+   if (!g.x.empty())
+      p->drawRects(g.x.data(), static_cast<int>(g.x.size()));
 }
 
-// строит полный путь для всей последовательности
-void SimpleWaveItem::PrecalcFullPath()
+// строит геометрию только для диапазона [x0, x1]
+SimpleGeometry BuildSimpleGeometry(const vcd::SimplePinDescription &pin, std::size_t bit,
+                                   double x0, double x1, double pxPerTs)
 {
+   VCD_TRACE_SCOPE("BuildSimpleGeometry");
    const int yPos = SPACING;
    const int yNeg = WAVEFORM_HEIGHT;
    const int yZ = WAVEFORM_HEIGHT / 2;
 
-   auto yFor = [&](const QString &s)
+   auto yFor = [&](char c)
    {
-      if (s == "1")
+      if (c == '1')
          return yPos;
-      if (s == "z")
+      if (c == 'z')
          return yZ;
-      return yNeg; // "0" или "x"
+      return yNeg; // '0' или 'x'
    };
 
-   std::int64_t itL = 0;
-   std::int64_t itR = m_handle->GetMaxTs();
-
-   QPainterPath path;
-   QPainterPath zTmpPath;
-   std::vector<std::pair<std::uint64_t, std::uint64_t>> xValueRanges;
-   std::uint64_t xL = 0;
-
-   QString prev;
-   prev = m_pin->GetValueChar(itL, m_idx.value_or(0));
-
-   path.moveTo(itL, yFor(prev)); // старт всегда виден
-   if (yFor(prev) == yZ)
-   {
-      zTmpPath.moveTo(itL, yFor(prev));
-   }
-   uint64_t lastTs = itL;
+   using vcd::PinValue;
+   const auto &timeline = pin.GetTimeline();
 
-   QString s;
-   if (m_pin->GetTimeline().empty())
+   // значение бита в метке ts; для пустой шкалы — начальное состояние
+   auto valueAt = [&](std::uint64_t ts)
    {
-      const char initState = m_pin->GetInitState()[0];
-      if (initState == '0')
+      if (timeline.empty())
       {
-         path.moveTo(0, yNeg);
-         path.lineTo(m_handle->GetMaxTs(), yNeg);
+         const std::string init = pin.GetInitState();
+         return init.empty() ? 'x' : init[0];
       }
-      else if (initState == '1')
+      return pin.GetValueChar(ts, bit);
+   };
+
+   SimpleGeometry g;
+   g.x0 = x0;
+   g.x1 = x1;
+   g.pxPerTs = pxPerTs;
+
+   // участок [a, b] с постоянным значением c
+   auto segment = [&](double a, double b, char c)
+   {
+      if (b <= a)
+         return;
+      if (c == '1' || c == '0')
       {
-         path.moveTo(0, yPos);
-         path.lineTo(m_handle->GetMaxTs(), yPos);
+         g.levels.moveTo(a, yFor(c));
+         g.levels.lineTo(b, yFor(c));
       }
-      else if (initState == 'z')
+      else if (c == 'z')
       {
-         zTmpPath.moveTo(0, yZ);
-         zTmpPath.lineTo(m_handle->GetMaxTs(), yZ);
+         g.z.moveTo(a, yZ);
+         g.z.lineTo(b, yZ);
       }
-      else if (initState == 'x')
+      else
       {
-         xValueRanges.push_back({0, m_handle->GetMaxTs()});
+         g.x.emplace_back(a, yPos, b - a, WAVEFORM_HEIGHT);
       }
-   }
-
-   for (const auto &it : m_pin->GetTimeline())
-   {
-      uint64_t ts = it.timestamp;
-      s = (m_pin->GetValueChar(ts, m_idx.value_or(0)));
-      const uint64_t yForPrevValue = yFor(prev);
-      const uint64_t yForValue = yFor(s);
+   };
 
-      path.lineTo(ts, yForPrevValue);
-      path.lineTo(ts, yForValue);
+   const double tsPerPx = 1.0 / pxPerTs;
 
-      if (prev == "x")
-      {
-         xValueRanges.push_back({xL, ts});
-      }
-      if (s == "x")
-      {
-         xL = ts;
-      }
-
-      prev = s;
+   char cur = valueAt(static_cast<std::uint64_t>(x0));
+   double segStart = x0;
+   // первое изменение правее x0
+   auto it = std::upper_bound(timeline.begin(), timeline.end(), x0,
+                              [](double ts, const PinValue &v)
+                              { return ts < static_cast<double>(v.timestamp); });
 
-      if (yForPrevValue == yZ)
+   while (it != timeline.end() && static_cast<double>(it->timestamp) <= x1)
+   {
+      const double ts = static_cast<double>(it->timestamp);
+      // правая граница пиксельного столбца, в который попал фронт
+      const double colEnd = x0 + (std::floor((ts - x0) * pxPerTs) + 1.0) * tsPerPx;
+      auto next = std::lower_bound(it, timeline.end(), colEnd,
+                                   [](const PinValue &v, double t)
+                                   { return static_cast<double>(v.timestamp) < t; });
+      if (next == it)
+         ++next; // округление: фронт всегда попадает в свой столбец
+
+      segment(segStart, ts, cur);
+      if (next - it == 1)
       {
-         zTmpPath.lineTo(ts, yZ);
-         m_precalcedZPath.push_back(zTmpPath);
-         zTmpPath.clear();
+         const char c = valueAt(it->timestamp);
+         g.levels.moveTo(ts, yFor(cur));
+         g.levels.lineTo(ts, yFor(c));
+         cur = c;
+         segStart = ts;
       }
-      if (yForValue == yZ)
+      else
       {
-         zTmpPath.moveTo(ts, yForValue);
+         // несколько фронтов в одном пикселе — один «занятый» столбец
+         // (у бита шины это изменения шины, бит при них мог и не меняться)
+         const double busyEnd = std::min(colEnd, x1);
+         g.busy.emplace_back(ts, yPos, busyEnd - ts, yNeg - yPos);
+         cur = valueAt(std::prev(next)->timestamp);
+         segStart = busyEnd;
       }
+      it = next;
    }
+   segment(segStart, x1, cur);
 
-   if (s == "0")
-   {
-      path.lineTo(m_handle->GetMaxTs(), yNeg);
-   }
-   else if (s == "1")
-   {
-      path.lineTo(m_handle->GetMaxTs(), yPos);
-   }
-   else if (s == "z")
-   {
-      zTmpPath.lineTo(m_handle->GetMaxTs(), yZ);
-   }
-   else if (s == "x")
-   {
-      xValueRanges.push_back({m_pin->GetTimeline().rbegin()->timestamp, m_handle->GetMaxTs()});
-   }
-
-   m_precalcedPath = std::move(path);
-   qWarning() << m_precalcedPath;
+   return g;
+}
 
-   for (const auto &[left, right] : xValueRanges)
-   {
-      QRect rect(left, yPos, right - left, WAVEFORM_HEIGHT);
-      m_precalcedXRectangles.emplace_back(rect);
-   }
+std::size_t
+SimpleWaveItem::MemoryBytes() const
+{
+   return PainterPathBytes(m_visible.levels) + PainterPathBytes(m_visible.z) +
+          (m_visible.x.capacity() + m_visible.busy.capacity()) * sizeof(QRectF);
 }
@@ -0,0 +1,185 @@
+#include "TileCache.hpp"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtConcurrent>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "Include/VcdTrace.hpp"
+
+WaveTileCache::WaveTileCache(QObject *parent)
+    : QObject(parent)
+{
+   // один поток оставляем GUI
+   m_pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount() - 1));
+}
+
+WaveTileCache::~WaveTileCache()
+{
+   // задачи держат this: дожидаемся их до разрушения
+   m_pool.clear();
+   m_pool.waitForDone();
+}
+
+std::uint64_t WaveTileCache::ZoomKey(double pxPerTs) noexcept
+{
+   std::uint64_t bits = 0;
+   std::memcpy(&bits, &pxPerTs, sizeof(bits));
+   return bits;
+}
+
+std::uint64_t WaveTileCache::OwnerFor(const void *source, std::size_t bit)
+{
+   const auto [it, inserted] = m_owners.try_emplace(std::make_pair(source, bit), m_nextOwner + 1);
+   if (inserted)
+      ++m_nextOwner;
+   return it->second;
+}
+
+void WaveTileCache::SetMemoryCap(std::size_t bytes)
+{
+   m_cap = bytes;
+   if (!m_cap)
+      Clear();
+   else
+      EvictToCap();
+}
+
+const QImage *WaveTileCache::Find(const Key &key)
+{
+   const auto it = m_tiles.find(key);
+   if (it == m_tiles.end())
+   {
+      ++m_stats.misses;
+      return nullptr;
+   }
+   ++m_stats.hits;
+   m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+   return &it->second.image;
+}
+
+void WaveTileCache::Request(const Key &key, const Renderer &render, QSize size)
+{
+   // новый масштаб: плитки старого, ещё не начатые, уже не нужны
+   if (key.zoom != m_zoom)
+   {
+      m_zoom = key.zoom;
+      m_pool.clear();
+      m_pending.clear();
+   }
+   if (!m_pending.insert(key).second)
+      return;
+
+   const double pxPerTs = [&]
+   {
+      double v = 0;
+      std::memcpy(&v, &key.zoom, sizeof(v));
+      return v;
+   }();
+   const double ts0 = double(key.index) * kTileWidth / pxPerTs;
+   const double ts1 = double(key.index + 1) * kTileWidth / pxPerTs;
+   const std::uint64_t generation = m_generation;
+
+   QtConcurrent::run(&m_pool, [this, key, render, size, ts0, ts1, pxPerTs, generation]()
+                     {
+      VCD_TRACE_SCOPE("WaveTileCache::Render");
+      const auto start = std::chrono::steady_clock::now();
+      QImage image = render(ts0, ts1, pxPerTs, size);
+      const auto ns = static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+      QMetaObject::invokeMethod(this, [this, key, generation, image = std::move(image), ns]() mutable
+                                { OnRendered(key, generation, std::move(image), ns); },
+                                Qt::QueuedConnection); });
+}
+
+void WaveTileCache::OnRendered(const Key &key, std::uint64_t generation, QImage image, std::uint64_t ns)
+{
+   m_stats.renderNs += ns;
+   if (generation != m_generation || !Enabled())
+   {
+      ++m_stats.dropped;
+      return;
+   }
+   m_pending.erase(key);
+
+   if (const auto it = m_tiles.find(key); it != m_tiles.end())
+      Erase(it);
+   m_lru.push_front(key);
+   m_stats.bytes += static_cast<std::size_t>(image.sizeInBytes());
+   m_tiles.emplace(key, Entry{std::move(image), m_lru.begin()});
+   ++m_stats.rendered;
+   EvictToCap();
+   m_stats.tiles = m_tiles.size();
+   emit TileReady();
+}
+
+void WaveTileCache::Erase(std::unordered_map<Key, Entry, KeyHash>::iterator it)
+{
+   m_stats.bytes -= static_cast<std::size_t>(it->second.image.sizeInBytes());
+   m_lru.erase(it->second.lru);
+   m_tiles.erase(it);
+}
+
+void WaveTileCache::EvictToCap()
+{
+   // самая свежая плитка остаётся, даже если одна больше лимита
+   while (m_stats.bytes > m_cap && m_tiles.size() > 1)
+   {
+      Erase(m_tiles.find(m_lru.back()));
+      ++m_stats.evicted;
+   }
+   m_stats.tiles = m_tiles.size();
+}
+
+void WaveTileCache::Clear()
+{
+   ++m_generation;
+   m_pool.clear();
+   m_tiles.clear();
+   m_lru.clear();
+   m_pending.clear();
+   m_owners.clear(); // пины старого Handle могут освободиться, адреса — повториться
+   m_stats.bytes = 0;
+   m_stats.tiles = 0;
+}
+
+void PaintTiles(QPainter *p, const QStyleOptionGraphicsItem *opt, WaveTileCache &cache,
+                std::uint64_t owner, double maxTs, int rowHeight, const WaveTileCache::Renderer &render)
+{
+   VCD_TRACE_SCOPE("PaintTiles");
+   const QTransform t = p->worldTransform();
+   const double pxPerTs = t.m11() > 0 ? t.m11() : 1.0;
+   const double x0 = std::max(0.0, opt->exposedRect.left());
+   const double x1 = std::min(maxTs, opt->exposedRect.right());
+   if (x1 < x0)
+      return;
+
+   constexpr int W = WaveTileCache::kTileWidth;
+   const std::uint64_t zoom = WaveTileCache::ZoomKey(pxPerTs);
+   const auto i0 = static_cast<std::int64_t>(std::floor(x0 * pxPerTs / W));
+   const auto i1 = static_cast<std::int64_t>(std::floor(x1 * pxPerTs / W));
+   const QSize size(W, rowHeight);
+
+   /* плитки — в пикселях, без трансформации */
+   p->save();
+   p->resetTransform();
+   for (std::int64_t i = i0; i <= i1; ++i)
+   {
+      const WaveTileCache::Key key{owner, zoom, i};
+      const QPointF at(std::round(double(i) * W + t.dx()), std::round(t.dy()));
+      if (const QImage *image = cache.Find(key))
+      {
+         p->drawImage(at, *image);
+      }
+      else
+      {
+         p->fillRect(QRectF(at, QSizeF(size)), QColor(40, 40, 40));
+         cache.Request(key, render, size);
+      }
+   }
+   p->restore();
+}
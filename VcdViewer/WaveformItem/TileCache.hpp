@@ -0,0 +1,130 @@
+#ifndef __TILE_CACHE_HPP__
+#define __TILE_CACHE_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <QImage>
+#include <QObject>
+#include <QThreadPool>
+
+class QPainter;
+class QStyleOptionGraphicsItem;
+
+/// Растровые плитки строк осциллограмм: ключ (элемент, масштаб, номер плитки),
+/// рисуются пулом потоков из данных шкалы, вытесняются по LRU при превышении лимита.
+/// Все методы — только из GUI-потока.
+class WaveTileCache final : public QObject
+{
+   Q_OBJECT
+public:
+   static constexpr int kTileWidth = 256; ///< ширина плитки, пикселей
+
+   /// Рисует плитку [ts0, ts1) при масштабе pxPerTs в изображение size; вызывается в пуле.
+   /// Держит shared_ptr на Handle: начатая задача переживает Clear() и смену файла.
+   using Renderer = std::function<QImage(double ts0, double ts1, double pxPerTs, QSize size)>;
+
+   struct Key
+   {
+      std::uint64_t owner; //!< OwnerFor() источника строки
+      std::uint64_t zoom;  //!< ZoomKey(pxPerTs)
+      std::int64_t index;  //!< плитка [index * kTileWidth, +kTileWidth) в пикселях от нуля сцены
+
+      bool
+      operator==(const Key &o) const noexcept
+      {
+         return owner == o.owner && zoom == o.zoom && index == o.index;
+      }
+   };
+
+   struct Stats
+   {
+      std::uint64_t hits = 0;
+      std::uint64_t misses = 0;   //!< нарисована заглушка
+      std::uint64_t rendered = 0; //!< плиток пришло из пула и легло в кеш
+      std::uint64_t dropped = 0;  //!< пришло после Clear()
+      std::uint64_t evicted = 0;
+      std::uint64_t renderNs = 0; //!< суммарное время отрисовки в пуле
+      std::size_t bytes = 0;
+      std::size_t tiles = 0;
+   };
+
+   explicit WaveTileCache(QObject *parent = nullptr);
+   ~WaveTileCache() override;
+
+   /// Лимит памяти плиток; 0 — кеш выключен, элементы рисуют напрямую.
+   void SetMemoryCap(std::size_t bytes);
+   std::size_t MemoryCap() const noexcept { return m_cap; }
+   bool Enabled() const noexcept { return m_cap != 0; }
+
+   /// Идентификатор строки по её данным (пин и номер бита), а не по элементу:
+   /// элементы переиспользуются для других строк, а плитки строки переживают
+   /// уход из viewport. Действителен до Clear() — пока жив Handle с этими пинами.
+   std::uint64_t OwnerFor(const void *source, std::size_t bit = 0);
+
+   /// Готовая плитка (и отметка в LRU) или nullptr.
+   const QImage *Find(const Key &key);
+
+   /// Ставит отрисовку в пул, если плитка ещё не запрошена.
+   void Request(const Key &key, const Renderer &render, QSize size);
+
+   /// Новые данные: все плитки и владельцы сбрасываются, запоздавшие результаты отбрасываются.
+   void Clear();
+
+   const Stats &GetStats() const noexcept { return m_stats; }
+
+   static std::uint64_t ZoomKey(double pxPerTs) noexcept;
+
+signals:
+   void TileReady(); ///< пришла хотя бы одна плитка — пора перерисовать viewport
+
+private:
+   struct KeyHash
+   {
+      std::size_t
+      operator()(const Key &k) const noexcept
+      {
+         std::uint64_t h = k.owner * 0x9e3779b97f4a7c15ull;
+         h ^= k.zoom + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+         h ^= static_cast<std::uint64_t>(k.index) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+         return static_cast<std::size_t>(h);
+      }
+   };
+
+   struct Entry
+   {
+      QImage image;
+      std::list<Key>::iterator lru;
+   };
+
+   void OnRendered(const Key &key, std::uint64_t generation, QImage image, std::uint64_t ns);
+   void Erase(std::unordered_map<Key, Entry, KeyHash>::iterator it);
+   void EvictToCap();
+
+private:
+   QThreadPool m_pool;
+   std::size_t m_cap = std::size_t(64) << 20;
+
+   std::unordered_map<Key, Entry, KeyHash> m_tiles;
+   std::list<Key> m_lru; //!< спереди — недавно нарисованные
+   std::unordered_set<Key, KeyHash> m_pending;
+
+   std::uint64_t m_generation = 0; //!< Clear()
+   std::uint64_t m_zoom = 0;       //!< масштаб последнего запроса
+   std::map<std::pair<const void *, std::size_t>, std::uint64_t> m_owners;
+   std::uint64_t m_nextOwner = 0;
+
+   Stats m_stats;
+};
+
+/// Рисует строку элемента (rowHeight пикселей) плитками кеша: готовые — копией,
+/// недостающие — заглушкой с запросом в пул.
+void PaintTiles(QPainter *p, const QStyleOptionGraphicsItem *opt, WaveTileCache &cache,
+                std::uint64_t owner, double maxTs, int rowHeight, const WaveTileCache::Renderer &render);
+
+#endif //!__TILE_CACHE_HPP__
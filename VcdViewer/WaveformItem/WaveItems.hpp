@@ -1,6 +1,8 @@
 #ifndef __WAVE_ITEMS_HPP__
 #define __WAVE_ITEMS_HPP__
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 
 #include <QGraphicsItem>
@@ -9,8 +11,90 @@
 #include <QStyleOptionGraphicsItem>
 
 #include "Include/VcdStructs.hpp"
+#include "Include/VcdTrace.hpp"
 #include "Parameters.hpp"
 
+/// Память элементов предрассчитанного пути (QPainterPath::Element — x, y, type).
+inline std::size_t
+PainterPathBytes(const QPainterPath &path)
+{
+   return static_cast<std::size_t>(path.elementCount()) * sizeof(QPainterPath::Element);
+}
+
+/// Число и суммарное время перестроений предрассчитанных путей
+/// (бенчмарк отрисовки). Пишутся только из GUI-потока, синхронизация не нужна.
+struct PathRebuildStats
+{
+   struct Counter
+   {
+      std::uint64_t calls = 0;
+      std::uint64_t ns = 0;
+
+      void
+      Add(std::uint64_t elapsedNs) noexcept
+      {
+         ++calls;
+         ns += elapsedNs;
+      }
+   };
+   Counter simple; ///< BuildSimpleGeometry из SimpleWaveItem::paint (видимый диапазон, без плиток)
+   Counter bus;    ///< BuildBusGeometry (пул потоков, учитывается по приходу в GUI-поток)
+};
+
+inline PathRebuildStats &
+GetPathRebuildStats()
+{
+   static PathRebuildStats stats;
+   return stats;
+}
+
+/// Добавляет время своей области видимости к счётчику PathRebuildStats.
+class PathRebuildTimer
+{
+public:
+   explicit PathRebuildTimer(PathRebuildStats::Counter &counter)
+       : m_counter(counter), m_start(std::chrono::steady_clock::now())
+   {
+   }
+
+   ~PathRebuildTimer()
+   {
+      m_counter.Add(static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count()));
+   }
+
+   PathRebuildTimer(const PathRebuildTimer &) = delete;
+   PathRebuildTimer &operator=(const PathRebuildTimer &) = delete;
+
+private:
+   PathRebuildStats::Counter &m_counter;
+   std::chrono::steady_clock::time_point m_start;
+};
+
+/// Геометрия 1-битового сигнала в диапазоне [x0, x1] при масштабе pxPerTs пикселей на метку.
+struct SimpleGeometry
+{
+   double x0 = -1, x1 = -1, pxPerTs = 0; //!< на какой диапазон и масштаб построено
+
+   QPainterPath levels;      //!< уровни 0/1 и фронты
+   QPainterPath z;           //!< участки z
+   std::vector<QRectF> x;    //!< участки x
+   std::vector<QRectF> busy; //!< столбцы, где в пиксель попало несколько фронтов
+};
+
+/** Обходит только изменения в [x0, x1]; фронты одного пиксельного столбца
+ *  схлопываются в «занятый» столбец, поэтому объём геометрии ограничен
+ *  шириной viewport, а не длиной истории. Только чтение pin — можно из пула. */
+SimpleGeometry
+BuildSimpleGeometry(const vcd::SimplePinDescription &pin, std::size_t bit,
+                    double x0, double x1, double pxPerTs);
+
+/// Рисует в координатах элемента (x — метки времени).
+void
+PaintSimpleGeometry(QPainter *p, const SimpleGeometry &g);
+
+class WaveTileCache;
+
 class SimpleWaveItem final : public QObject, public QGraphicsItem
 {
    Q_OBJECT
@@ -29,11 +113,19 @@ public:
          const QStyleOptionGraphicsItem *opt,
          QWidget *) override;
 
-private:
-   // строит полный путь для всей последовательности
+   /// Предрассчитанные пути и подписи, байт (панель диагностики).
+   std::size_t
+   MemoryBytes() const;
+
+   /// Рисовать плитками из cache (nullptr или выключенный кеш — напрямую).
    void
-   PrecalcFullPath();
+   SetTileCache(WaveTileCache *cache);
 
+   /// Переиспользование элемента из пула строк: другой пин, геометрия сбрасывается.
+   void
+   SetPin(std::shared_ptr<vcd::SimplePinDescription> p);
+
+private:
    QString
    GetPinValueAtTimestamp(
        std::size_t index, uint64_t timestamp);
@@ -43,9 +135,9 @@ private:
    std::shared_ptr<vcd::SimplePinDescription> m_pin;
    std::optional<std::size_t> m_idx;
 
-   QPainterPath m_precalcedPath;
-   std::vector<QPainterPath> m_precalcedZPath;
-   std::vector<QRect> m_precalcedXRectangles;
+   SimpleGeometry m_visible; //!< совпал диапазон и масштаб — paint() берёт готовое
+   WaveTileCache *m_tileCache = nullptr;
+   std::uint64_t m_tileOwner = 0;
 };
 
 class ParamWaveItem final : public QObject, public QGraphicsItem
@@ -67,12 +159,46 @@ public:
    QRectF
    boundingRect() const override;
 
+   /// Предрассчитанные пути и подписи, байт (панель диагностики).
+   std::size_t
+   MemoryBytes() const;
+
+   /// Переиспользование элемента из пула строк.
+   void
+   SetPin(std::shared_ptr<vcd::ParamPinDescription> p);
+
 private:
    std::shared_ptr<vcd::Handle> m_handle;
    std::shared_ptr<vcd::ParamPinDescription> m_pin;
    QGraphicsSimpleTextItem *m_label = nullptr;
 };
 
+/// Отрезки шины видимого диапазона; строится в пуле потоков, от зума не зависит
+/// ничего, кроме схлопывания фронтов одного пикселя.
+struct BusGeometry
+{
+   struct Segment
+   {
+      double x0, x1; //!< границы в метках (реальные, могут выходить за диапазон)
+      char cls;      //!< 'd' — данные, 'x', 'z', 'b' — несколько фронтов в пикселе
+      QString text;  //!< hex-подпись для 'd', «x» для 'x'
+   };
+
+   double x0 = 0, x1 = -1, pxPerTs = 0; //!< на какой диапазон и масштаб построено
+   std::vector<Segment> segments;
+   std::uint64_t buildNs = 0;
+};
+
+/** Отрезки шины, пересекающие [x0, x1]; несколько фронтов в одном пиксельном
+ *  столбце — один отрезок 'b'. Только чтение pin — можно из пула. */
+BusGeometry
+BuildBusGeometry(const vcd::BusPinDescription &pin, std::uint64_t maxTs,
+                 double x0, double x1, double pxPerTs);
+
+/// Рисует отрезки, видимые в [x0, x1], в пикселях по worldTransform() рисовальщика.
+void
+PaintBusGeometry(QPainter *p, const BusGeometry &g, double x0, double x1);
+
 class MultipleWaveItem final : public QObject, public QGraphicsItem
 {
    Q_OBJECT
@@ -80,7 +206,6 @@ public:
    MultipleWaveItem(const std::shared_ptr<vcd::Handle> &h,
                     std::shared_ptr<vcd::BusPinDescription> p,
                     int yOffset,
-                    double scale,
                     QGraphicsItem *parent = nullptr);
 
    /* ───────────── QGraphicsItem ───────────── */
@@ -89,49 +214,48 @@ public:
               const QStyleOptionGraphicsItem *,
               QWidget *) override;
 
+   /// Отрезки, подписи и подэлементы битов, байт (панель диагностики).
+   std::size_t MemoryBytes() const;
+
+   /// Рисовать плитками из cache; передаётся и подэлементам битов.
+   void SetTileCache(WaveTileCache *cache);
+
+   /// Переиспользование элемента из пула строк: другой пин, строка свёрнута,
+   /// подэлементы битов удаляются, запоздавшая геометрия отбрасывается.
+   void SetPin(std::shared_ptr<vcd::BusPinDescription> p);
+
+   /// Строк битов в раскрытом виде (столько подэлементов создаст SetExpanded).
+   static std::size_t SubRowCount(const vcd::BusPinDescription &pin);
+
 public slots:
-   void SetScaleCoeff(double k)
-   {
-      m_scaleCoeff = k;
-      PreparePaths(); // перестраиваем с новым xStep
-      update();       // запрос перерисовки
-   }
    void SetExpanded(bool on);
 
 private:
    /* ───────────── helpers ───────────── */
-   void PreparePaths();
+   /** Запрашивает геометрию [x0, x1] при масштабе pxPerTs: первый раз —
+    *  синхронно, дальше — в пуле потоков. Результат устаревшего запроса
+    *  (m_generation успел вырасти) отбрасывается. */
+   void RequestGeometry(double x0, double x1, double pxPerTs);
    void PrepareSubItems(); // создаёт SimpleWaveItem’ы для каждого бита
 
-   /** классифицирует строку шины:
-       'd' = данные, 'z' = z-состояние, 'x' = неопред. */
-   static char classifyBus(const std::string_view &v);
-
 private:
    std::shared_ptr<vcd::Handle> m_handle;
    std::shared_ptr<vcd::BusPinDescription> m_pin;
 
-   /* предварительно рассчитанные пути --------------- */
-   QPainterPath m_pathDataUpper, m_pathDataLower; // «нормальные» значения
-   QPainterPath m_pathXUpper, m_pathXLower;       // «х»-состояния
-   QPainterPath m_pathZ;                          // «z»
+   BusGeometry m_geometry;        //!< последняя пришедшая, рисуется до прихода новой
+   bool m_hasGeometry = false;
+   std::uint64_t m_generation = 0; //!< номер последнего запроса
+   BusGeometry m_pending;         //!< диапазон и масштаб последнего запроса (без отрезков)
 
    /* подпути-подпины */
    std::vector<SimpleWaveItem *> m_;
 
    /* misc */
-   double m_scaleCoeff = 1.0;
    bool m_isExpanded = false;
    bool m_prepared = false;
 
-   struct BusLabel
-   {
-      uint64_t x0;  // левая граница ромба   (xStep уже «съеден»)
-      uint64_t x1;  // правая граница ромба
-      QString text; // готовая строка для вывода
-   };
-
-   std::vector<BusLabel> m_labels; // + объявление в private-секции
+   WaveTileCache *m_tileCache = nullptr;
+   std::uint64_t m_tileOwner = 0;
 };
 
 class DumpoffItem final : public QGraphicsItem
@@ -1,5 +1,8 @@
 /************************  WaveformView.cpp  ************************/
 #include "WaveformView.hpp"
+#include "Include/VcdChangeIndex.hpp"
+#include "Include/VcdTrace.hpp"
+#include "WaveformItem/TileCache.hpp"
 
 #include <algorithm>
 #include <cmath>
@@ -10,12 +13,22 @@
 #include <QTimer>
 #include <QWindow>
 
-enum Layers
+namespace
 {
-   Layers_ScaleLine = 1,
-   Layers_Graphics,
-   Layers_Cursor
-};
+   constexpr int kRowHeight = WAVEFORM_HEIGHT + SPACING;
+   constexpr int kVirtualMarginRows = 16; ///< живые строки сверх viewport с каждой стороны
+
+   /* высота строки, как у boundingRect() её элемента */
+   qreal RowHeight(const vcd::PinDescriptionPtr &pin, bool expanded)
+   {
+      if (pin->GetPinType() == vcd::PinType::parameter)
+         return WAVEFORM_HEIGHT;
+      if (pin->GetSignalType() == vcd::SignalType::simple || !expanded)
+         return kRowHeight;
+      const auto &bus = static_cast<const vcd::BusPinDescription &>(*pin);
+      return kRowHeight * qreal(1 + MultipleWaveItem::SubRowCount(bus));
+   }
+} // namespace
 
 /* === constructor ================================================= */
 
@@ -32,7 +45,7 @@ WaveformView::WaveformView(QWidget *parent)
 
    createScenes();
    configureScaleView();
-   setupCursor();
+   setupOverlay();
    initScrollSync();
    UpdateScaleViewWidth(); // стартовая ширина линейки
 }
@@ -43,14 +56,19 @@ void WaveformView::createScenes()
 {
    m_scene = new QGraphicsScene(this);
    m_scene->setBackgroundBrush(Qt::black);
+   // элементов — только видимые строки, и они постоянно переезжают: BSP-дерево не окупается
+   m_scene->setItemIndexMethod(QGraphicsScene::NoIndex);
    setScene(m_scene);
 
    m_scaleScene = new QGraphicsScene(this);
+
+   m_tileCache = new WaveTileCache(this);
+   connect(m_tileCache, &WaveTileCache::TileReady, viewport(), qOverload<>(&QWidget::update));
 }
 
 void WaveformView::configureScaleView()
 {
-   m_scaleView = new QGraphicsView(m_scaleScene);
+   m_scaleView = new TimeRulerView(m_scaleScene, m_ticks);
    m_scaleView->setFixedHeight(SCALE_LINE_HEIGHT);
    m_scaleView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
    m_scaleView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -60,11 +78,17 @@ void WaveformView::configureScaleView()
    m_scaleView->setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
 }
 
-void WaveformView::setupCursor()
+/*
+ * Курсор и перекрестие — не элементы сцены: их рисует drawForeground,
+ * а при перемещении помечается грязной только полоса в несколько пикселей.
+ * Строки под ней перерисовываются из готовых плиток/геометрии без перестроения.
+ */
+void WaveformView::setupOverlay()
 {
-   QPen pen(Qt::red, 1);
-   pen.setCosmetic(true);
-   m_cursorLine = m_scene->addLine(0, 0, 0, 0, pen);
+   m_hoverTimer = new QTimer(this);
+   m_hoverTimer->setSingleShot(true);
+   m_hoverTimer->setTimerType(Qt::PreciseTimer);
+   connect(m_hoverTimer, &QTimer::timeout, this, &WaveformView::applyHover);
 }
 
 void WaveformView::initScrollSync()
@@ -76,11 +100,8 @@ void WaveformView::initScrollSync()
    connect(m_scaleView->horizontalScrollBar(), &QScrollBar::valueChanged,
            horizontalScrollBar(), &QScrollBar::setValue);
 
-   /* обновление шкалы при скролле */
-   connect(m_scaleView->horizontalScrollBar(), &QScrollBar::valueChanged,
-           this, &WaveformView::DrawScaleLine);
-   connect(m_scaleView->verticalScrollBar(), &QScrollBar::valueChanged,
-           this, &WaveformView::DrawScaleLine);
+   /* шкала при скролле не перестраивается: обе линейки дорисовывают
+      открывшуюся полосу в drawBackground */
 
    /* изменение ширины линейки при вертикальном скролле */
    connect(verticalScrollBar(), &QScrollBar::valueChanged,
@@ -90,17 +111,20 @@ void WaveformView::initScrollSync()
    auto *sb = new SnapScrollBar(Qt::Vertical, this);
    sb->setSnapStep(WAVEFORM_HEIGHT + SPACING);
    setVerticalScrollBar(sb);
+
+   /* строки, въехавшие в viewport, получают элементы из пула */
+   connect(sb, &QScrollBar::valueChanged,
+           this, &WaveformView::updateVisibleRows);
 }
 
 /* === events ====================================================== */
 
 void WaveformView::mousePressEvent(QMouseEvent *e)
 {
-   if (e->button() == Qt::LeftButton && m_cursorLine)
+   if (e->button() == Qt::LeftButton)
    {
       const QPointF scenePos = mapToScene(e->pos());
-      m_cursorPos = scenePos.x();
-      updateCursorGeometry();
+      setCursorPos(static_cast<qint64>(scenePos.x()));
       emit SelectedTimestampChange(static_cast<uint64_t>(scenePos.x()));
    }
    QGraphicsView::mousePressEvent(e);
@@ -108,10 +132,23 @@ void WaveformView::mousePressEvent(QMouseEvent *e)
 
 void WaveformView::mouseMoveEvent(QMouseEvent *e)
 {
-   emit PointerPositionChanged(static_cast<uint64_t>(mapToScene(e->pos()).x()));
+   scheduleHover(e->pos());
    QGraphicsView::mouseMoveEvent(e);
 }
 
+void WaveformView::leaveEvent(QEvent *e)
+{
+   m_hoverTimer->stop();
+   m_pendingHover.reset();
+   if (m_hoverPos)
+   {
+      updateOverlayColumn(m_hoverPos->x());
+      updateOverlayRow(m_hoverPos->y());
+      m_hoverPos.reset();
+   }
+   QGraphicsView::leaveEvent(e);
+}
+
 void WaveformView::wheelEvent(QWheelEvent *e)
 {
    if (horizontalScrollBar()->isVisible())
@@ -131,7 +168,46 @@ void WaveformView::resizeEvent(QResizeEvent *e)
 
    QGraphicsView::resizeEvent(e);
    UpdateScaleViewWidth();
-   UpdateSignals(m_signals);
+   if (!m_handle)
+      return;
+   updateSceneRect();
+   updateVisibleRows();
+   DrawScaleLine();
+}
+
+void WaveformView::scrollContentsBy(int dx, int dy)
+{
+   QGraphicsView::scrollContentsBy(dx, dy);
+   if (!m_hoverPos)
+      return;
+   // перекрестие привязано к мыши, а не к сцене: сдвинутую копию стираем,
+   // под мышью — рисуем заново; время под мышью тоже сменилось
+   updateOverlayColumn(m_hoverPos->x() + dx);
+   updateOverlayRow(m_hoverPos->y() + dy);
+   updateOverlayColumn(m_hoverPos->x());
+   updateOverlayRow(m_hoverPos->y());
+   scheduleHover(m_pendingHover.value_or(*m_hoverPos));
+}
+
+void WaveformView::drawBackground(QPainter *p, const QRectF &rect)
+{
+   QGraphicsView::drawBackground(p, rect);
+   if (!m_handle)
+      return;
+   m_ticks.Update(transform().m11(), viewport()->width());
+   if (m_ticks.Valid())
+      m_ticks.PaintGrid(p, rect);
+}
+
+void WaveformView::paintEvent(QPaintEvent *e)
+{
+   VCD_TRACE_SCOPE("WaveformView::paintEvent");
+   QGraphicsView::paintEvent(e);
+   if (m_firstFramePending)
+   {
+      m_firstFramePending = false;
+      emit FirstFramePainted();
+   }
 }
 
 /* === public API ================================================== */
@@ -163,10 +239,14 @@ void WaveformView::SetHandle(std::shared_ptr<vcd::Handle> newHandle)
    }
    m_scene->clear();
    m_scaleScene->clear();
+   m_tileCache->Clear();
    m_signals.clear();
-   m_aliasItemMap.clear();
-   m_lineItems.clear();
-   m_aliasOrder.clear();
+   m_eventMask.clear();
+   m_liveItems.clear(); // живые и свободные элементы удалил m_scene->clear()
+   m_freeSimple.clear();
+   m_freeBus.clear();
+   m_freeParam.clear();
+   m_rowTop.clear();
    m_expandedMap.clear();
    m_currentZoomLevel = 0;
    m_minZoomLevel = 0;
@@ -175,14 +255,15 @@ void WaveformView::SetHandle(std::shared_ptr<vcd::Handle> newHandle)
 
    m_scaleView->resetTransform();
    resetTransform();
-   setupCursor();
 
+   m_firstFramePending = m_handle != nullptr;
    if (!m_handle)
    {
       m_scene->setSceneRect(0, 0, 0, height());
       return;
    }
 
+   m_scaleScene->setSceneRect(0, -SCALE_LINE_HEIGHT, m_handle->GetMaxTs(), SCALE_LINE_HEIGHT);
    DrawScaleLine(true);
    m_scene->setSceneRect(0, 0, m_handle->GetMaxTs(), height());
 
@@ -197,77 +278,172 @@ void WaveformView::SetHandle(std::shared_ptr<vcd::Handle> newHandle)
 void WaveformView::OnItemExpandedOrCollapsed(vcd::PinDescriptionPtr pin, bool isExpanded)
 {
    m_expandedMap[pin] = isExpanded;
-   auto *multiItem = static_cast<MultipleWaveItem *>(m_aliasItemMap.at(std::string(pin->GetAlias())));
-   multiItem->SetExpanded(isExpanded);
+   if (!m_handle)
+      return;
+   if (auto it = m_liveItems.find(pin); it != m_liveItems.end())
+      static_cast<MultipleWaveItem *>(it->second)->SetExpanded(isExpanded);
+
+   rebuildRowLayout();
+   updateVisibleRows();
+}
 
-   int yOff = 0;
-   for (const auto &alias : m_aliasOrder)
+/*
+ * Элементы создаются не на каждый сигнал, а только для строк около
+ * viewport (updateVisibleRows); здесь — лишь раскладка строк за O(n).
+ */
+void WaveformView::UpdateSignals(std::vector<vcd::PinDescriptionPtr> newSignals)
+{
+   VCD_TRACE_SCOPE("WaveformView::UpdateSignals");
+   if (!m_handle)
+      return;
+
+   m_signals = std::move(newSignals);
+   m_eventMask.assign(m_handle->GetAlias2pinMap().size(), 0);
+   for (const auto &pin : m_signals)
    {
-      auto *item = m_aliasItemMap.at(alias);
-      item->setPos(0, yOff);
-      yOff += item->boundingRect().height();
+      if (pin->GetPinType() != vcd::PinType::parameter && pin->GetId() < m_eventMask.size())
+         m_eventMask[pin->GetId()] = 1;
    }
+   rebuildRowLayout();
+   updateVisibleRows();
+   DrawScaleLine();
 }
 
-void WaveformView::UpdateSignals(std::vector<vcd::PinDescriptionPtr> newSignals)
+void WaveformView::rebuildRowLayout()
+{
+   m_rowTop.resize(m_signals.size() + 1);
+   qreal y = 0;
+   for (std::size_t i = 0; i < m_signals.size(); ++i)
+   {
+      m_rowTop[i] = y;
+      const auto it = m_expandedMap.find(m_signals[i]);
+      y += RowHeight(m_signals[i], it != m_expandedMap.end() && it->second);
+   }
+   m_rowTop.back() = y;
+   updateSceneRect();
+}
+
+void WaveformView::updateSceneRect()
+{
+   m_scene->setSceneRect(0, 0, m_handle->GetMaxTs(), std::max(rowsHeight(), qreal(height())));
+}
+
+/* строки [viewport ± kVirtualMarginRows] получают элементы, остальные возвращают их в пул */
+void WaveformView::updateVisibleRows()
 {
+   VCD_TRACE_SCOPE("WaveformView::updateVisibleRows");
    if (!m_handle)
       return;
 
-   /* удалить элементы, которых больше нет */
-   for (auto it = m_aliasItemMap.begin(); it != m_aliasItemMap.end();)
+   const QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+   auto rowAt = [&](qreal y)
    {
-      bool stillPresent = std::any_of(newSignals.begin(), newSignals.end(),
-                                      [&](auto &p)
-                                      { return p->GetAlias() == it->first; });
-      if (!stillPresent)
-      {
-         m_scene->removeItem(it->second);
-         delete it->second;
-         it = m_aliasItemMap.erase(it);
-      }
-      else
+      const auto it = std::upper_bound(m_rowTop.begin(), std::prev(m_rowTop.end()), y);
+      return std::size_t(std::max<std::ptrdiff_t>(0, std::distance(m_rowTop.begin(), it) - 1));
+   };
+   const std::size_t n = m_signals.size();
+   std::size_t r0 = 0, r1 = 0;
+   if (n)
+   {
+      const std::size_t top = rowAt(visible.top());
+      r0 = top > kVirtualMarginRows ? top - kVirtualMarginRows : 0;
+      r1 = std::min(n, rowAt(visible.bottom()) + 1 + kVirtualMarginRows);
+   }
+
+   /* сначала освобождаем: ушедшие строки отдают элементы новым */
+   std::unordered_map<vcd::PinDescriptionPtr, QGraphicsItem *> live;
+   live.reserve(r1 - r0);
+   for (std::size_t i = r0; i < r1; ++i)
+   {
+      if (auto it = m_liveItems.find(m_signals[i]); it != m_liveItems.end())
       {
-         ++it;
+         live.emplace(it->first, it->second);
+         m_liveItems.erase(it);
       }
    }
+   for (auto &[pin, item] : m_liveItems)
+      releaseItem(item);
 
-   m_aliasOrder.clear();
-   int yOff = 0;
-
-   /* добавить новые / пере-позиционировать старые */
-   for (auto &pin : newSignals)
+   for (std::size_t i = r0; i < r1; ++i)
    {
-      const std::string alias(pin->GetAlias());
+      const auto &pin = m_signals[i];
+      auto [it, inserted] = live.try_emplace(pin, nullptr);
+      if (inserted)
+         it->second = acquireItem(pin);
+      it->second->setPos(0, m_rowTop[i]);
+   }
+   m_liveItems = std::move(live);
+}
 
-      if (!m_aliasItemMap.count(alias))
+QGraphicsItem *WaveformView::acquireItem(const vcd::PinDescriptionPtr &pin)
+{
+   QGraphicsItem *item = nullptr;
+   if (pin->GetPinType() == vcd::PinType::parameter)
+   {
+      auto param = std::static_pointer_cast<vcd::ParamPinDescription>(pin);
+      if (m_freeParam.empty())
       {
-         QGraphicsItem *item = nullptr;
-
-         if (pin->GetPinType() == vcd::PinType::parameter)
-            item = new ParamWaveItem(m_handle, std::static_pointer_cast<vcd::ParamPinDescription>(pin), yOff);
-         else if (pin->GetSignalType() == vcd::SignalType::simple)
-            item = new SimpleWaveItem(m_handle, std::static_pointer_cast<vcd::SimplePinDescription>(pin), yOff);
-         else
-         {
-            item = new MultipleWaveItem(m_handle, std::static_pointer_cast<vcd::BusPinDescription>(pin), yOff, CalcScaleCoeff());
-            connect(this, &WaveformView::ScaleCoeffChanged,
-                    static_cast<MultipleWaveItem *>(item), &MultipleWaveItem::SetScaleCoeff);
-         }
+         item = new ParamWaveItem(m_handle, std::move(param), 0);
          m_scene->addItem(item);
-         m_aliasItemMap[alias] = item;
       }
-
-      m_aliasItemMap[alias]->setPos(0, yOff);
-      yOff += m_aliasItemMap[alias]->boundingRect().height();
-      m_aliasOrder.push_back(alias);
+      else
+      {
+         m_freeParam.back()->SetPin(std::move(param));
+         item = m_freeParam.back();
+         m_freeParam.pop_back();
+      }
    }
-   m_signals = std::move(newSignals);
+   else if (pin->GetSignalType() == vcd::SignalType::simple)
+   {
+      auto simple = std::static_pointer_cast<vcd::SimplePinDescription>(pin);
+      if (m_freeSimple.empty())
+      {
+         auto *w = new SimpleWaveItem(m_handle, std::move(simple), 0);
+         w->SetTileCache(m_tileCache);
+         m_scene->addItem(w);
+         item = w;
+      }
+      else
+      {
+         m_freeSimple.back()->SetPin(std::move(simple));
+         item = m_freeSimple.back();
+         m_freeSimple.pop_back();
+      }
+   }
+   else
+   {
+      auto bus = std::static_pointer_cast<vcd::BusPinDescription>(pin);
+      MultipleWaveItem *w = nullptr;
+      if (m_freeBus.empty())
+      {
+         w = new MultipleWaveItem(m_handle, std::move(bus), 0);
+         w->SetTileCache(m_tileCache);
+         m_scene->addItem(w);
+      }
+      else
+      {
+         w = m_freeBus.back();
+         m_freeBus.pop_back();
+         w->SetPin(std::move(bus));
+      }
+      const auto expanded = m_expandedMap.find(pin);
+      if (expanded != m_expandedMap.end() && expanded->second)
+         w->SetExpanded(true);
+      item = w;
+   }
+   item->setVisible(true);
+   return item;
+}
 
-   /* обновить границы сцены и курсор */
-   m_scene->setSceneRect(0, 0, m_handle->GetMaxTs(), std::max(yOff, height()));
-   DrawScaleLine();
-   updateCursorGeometry();
+void WaveformView::releaseItem(QGraphicsItem *item)
+{
+   item->setVisible(false);
+   if (auto *w = dynamic_cast<SimpleWaveItem *>(item))
+      m_freeSimple.push_back(w);
+   else if (auto *w = dynamic_cast<MultipleWaveItem *>(item))
+      m_freeBus.push_back(w);
+   else if (auto *w = dynamic_cast<ParamWaveItem *>(item))
+      m_freeParam.push_back(w);
 }
 
 void WaveformView::UpdateScaleViewWidth()
@@ -279,6 +455,12 @@ void WaveformView::UpdateScaleViewWidth()
 
 QGraphicsView *WaveformView::GetScaleView() { return m_scaleView; }
 
+void WaveformView::SetTileCacheBytes(std::size_t bytes)
+{
+   m_tileCache->SetMemoryCap(bytes);
+   viewport()->update();
+}
+
 /* === zoom helpers =============================================== */
 
 void WaveformView::ZoomX(int level)
@@ -326,180 +508,185 @@ void WaveformView::zoomToRange(uint64_t x0, uint64_t x1)
    DrawScaleLine();
 }
 
-/* === helpers ===================================================== */
+std::pair<uint64_t, uint64_t> WaveformView::GetVisibleRange() const
+{
+   if (!m_handle)
+      return {0, 0};
+   const QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+   const uint64_t maxTs = m_handle->GetMaxTs();
+   const uint64_t t0 = static_cast<uint64_t>(std::max<qreal>(visible.left(), 0));
+   const uint64_t t1 = static_cast<uint64_t>(std::max<qreal>(visible.right(), 0));
+   return {std::min(t0, maxTs), std::min(t1, maxTs)};
+}
 
-void WaveformView::updateCursorGeometry()
+std::size_t WaveformView::GetItemsMemoryBytes() const
 {
-   if (!m_cursorLine)
-      return;
+   std::size_t bytes = 0;
+   for (const auto &[pin, item] : m_liveItems)
+   {
+      if (const auto *w = dynamic_cast<const SimpleWaveItem *>(item))
+         bytes += w->MemoryBytes();
+      else if (const auto *w = dynamic_cast<const MultipleWaveItem *>(item))
+         bytes += w->MemoryBytes();
+      else if (const auto *w = dynamic_cast<const ParamWaveItem *>(item))
+         bytes += w->MemoryBytes();
+   }
+   return bytes;
+}
 
-   const std::size_t h = std::max<std::size_t>(height(),
-                                               m_signals.size() * (WAVEFORM_HEIGHT + SPACING));
-   m_cursorLine->setLine(m_cursorPos, 0, m_cursorPos, h);
-   m_cursorLine->setZValue(Layers_Cursor);
+void WaveformView::SetCursorTimestamp(uint64_t ts)
+{
+   setCursorPos(static_cast<qint64>(ts));
+
+   /* прокручиваем только по горизонтали, если курсор вне окна */
+   const QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+   const qreal x = static_cast<qreal>(ts);
+   if (x < visible.left() || x > visible.right())
+      centerOn(x, visible.center().y());
+
+   emit SelectedTimestampChange(ts);
 }
 
-void WaveformView::clearScaleLines()
+void WaveformView::GoToNextEvent()
 {
-   for (auto *l : m_lineItems)
-      if (l)
-         m_scene->removeItem(l);
-   m_lineItems.clear();
+   if (auto ts = findEvent(true))
+      SetCursorTimestamp(*ts);
 }
 
-void WaveformView::DrawScaleLine(bool reset /* = false */)
+void WaveformView::GoToPrevEvent()
 {
-   if (!m_handle)
-      return;
+   if (auto ts = findEvent(false))
+      SetCursorTimestamp(*ts);
+}
 
-   /* ---------- 1. Видимые границы окна -------------------------- */
-   double vStart, vEnd, vWidth;
-   if (reset)
-   {
-      vStart = 0.0;
-      vEnd = m_handle->GetMaxTs();
-      if (vEnd == 0.0)
-         return;
-      vWidth = vEnd;
-   }
-   else
-   {
-      const QRectF vr = mapToScene(viewport()->rect()).boundingRect();
-      vStart = vr.left();
-      vEnd = std::min<double>(vr.right(), m_handle->GetMaxTs());
-      vWidth = vEnd - vStart;
-   }
+/* === helpers ===================================================== */
 
-   /* ---------- 2. Подготовка сцен ------------------------------- */
-   m_scaleScene->clear();
-   m_scaleScene->setSceneRect(0, -SCALE_LINE_HEIGHT,
-                              m_handle->GetMaxTs(), SCALE_LINE_HEIGHT);
-
-   static const std::unordered_map<std::string, double> factor{
-       {"ps", 1.0}, {"ns", 1e3}, {"us", 1e6}, {"ms", 1e9}, {"s", 1e12}};
-   static const std::vector<std::string> units{"ps", "ns", "us", "ms", "s"};
-
-   /* base #timescale VCD (напр. "10ns") */
-   const std::string ts = std::string(m_handle->GetTimeScale());
-   auto itNonDigit = std::find_if(ts.begin(), ts.end(),
-                                  [](char c)
-                                  { return !std::isdigit(static_cast<unsigned char>(c)); });
-
-   const std::size_t mul = std::stoul(std::string{ts.substr(0, size_t(itNonDigit - ts.begin()))});
-   const std::string baseUnit(itNonDigit, ts.end());
-
-   const double sceneUnitPs = mul * factor.at(baseUnit); // 1 unit сцены = ? пс
-
-   /* ---------- 3. «Красивый» шаг деления ------------------------ */
-   const double roughStepPs = (vWidth * sceneUnitPs) / 10.0; // ≈10 делений
-   double decade = std::pow(10.0, std::floor(std::log10(roughStepPs)));
-   double nicePs = decade;
-   if (roughStepPs / decade > 5)
-      nicePs = 10 * decade;
-   else if (roughStepPs / decade > 2)
-      nicePs = 5 * decade;
-   else if (roughStepPs / decade > 1)
-      nicePs = 2 * decade;
-
-   const double stepScene = nicePs / sceneUnitPs;
-
-   /* ---------- 4. Диапазон рисования ---------------------------- */
-   double minX = std::floor(vStart / stepScene) * stepScene - stepScene;
-   double maxX = std::ceil(vEnd / stepScene) * stepScene + stepScene;
-   maxX = std::min<double>(maxX, m_handle->GetMaxTs());
-
-   m_scaleScene->addLine(minX, -SCALE_LINE_HEIGHT / 2,
-                         maxX, -SCALE_LINE_HEIGHT / 2,
-                         QPen(Qt::blue, 1));
-
-   /* ---------- 5. Подготовка коллизий текста -------------------- */
-   auto *probe = m_scaleScene->addText("00");
-   const double minDX = probe->boundingRect().width();
-   delete probe;
-
-   for (auto *l : m_lineItems)
-      if (l)
-         m_scene->removeItem(l);
-   m_lineItems.clear();
-   QRectF lastLbl;
-
-   /* ---------- 6. Основные деления ------------------------------ */
-   for (double x = minX; x <= maxX + 1e-6; x += stepScene)
-   {
-      const double timePs = x * sceneUnitPs;
+/*
+ * Ближайшее изменение любого из отображаемых сигналов строго после /
+ * до курсора. С ChangeIndex — поиск по глобальному журналу, без него —
+ * двоичный поиск по шкале каждого сигнала.
+ */
+std::optional<uint64_t> WaveformView::findEvent(bool forward) const
+{
+   if (!m_handle || m_signals.empty())
+      return std::nullopt;
+
+   const uint64_t cur = static_cast<uint64_t>(std::max<qint64>(m_cursorPos, 0));
+   if (const vcd::ChangeIndex *idx = m_handle->GetChangeIndex())
+      return forward ? idx->NextEvent(cur, &m_eventMask) : idx->PrevEvent(cur, &m_eventMask);
 
-      /* --- выбираем единицу так, чтобы в подписи ≤ 1 знака после запятой --- */
-      int uIdx = int(units.size()) - 1; // начинаем с крупнейшей (s)
-      int prec = 0;
-      while (uIdx > 0)
+   std::optional<uint64_t> best;
+   auto scan = [&](const std::vector<vcd::PinValue> &tl)
+   {
+      auto byTs = [](const vcd::PinValue &v, uint64_t t)
+      { return v.timestamp < t; };
+      if (forward)
       {
-         double val = timePs / factor.at(units[uIdx]);
-         double val10 = val * 10.0;
-
-         bool oneDecimal = std::fabs(val10 - std::round(val10)) < 1e-6;
-         bool zeroDecimal = std::fabs(val - std::round(val)) < 1e-6;
-
-         if (val >= 1.0 && (zeroDecimal || oneDecimal))
-         {
-            prec = zeroDecimal ? 0 : 1;
-            break; // нашли подходящий юнит
-         }
-         --uIdx; // пробуем более мелкий
+         auto it = std::lower_bound(tl.begin(), tl.end(), cur + 1, byTs);
+         if (it != tl.end() && (!best || it->timestamp < *best))
+            best = it->timestamp;
       }
-      /* если дошли до ps */
-      double value = timePs / factor.at(units[uIdx]);
-      if (prec == 0 && std::fabs(value - std::round(value)) > 1e-6)
-         prec = 2; // в ps/нс могут остаться «.25»
-
-      const QString txt = QString::number(value, 'f', prec) +
-                          QString::fromStdString(units[uIdx]);
-
-      /* --- текст + вертикальная линия --------------------------- */
-      auto *lbl = m_scaleScene->addText(txt);
-      auto f = lbl->font();
-      f.setPointSize(8);
-      lbl->setFont(f);
-      lbl->setDefaultTextColor(Qt::white);
-      lbl->setFlag(QGraphicsItem::ItemIgnoresTransformations);
-
-      const QRectF br = lbl->boundingRect();
-      const double lx = x - br.width() / 2.0 / transform().m11();
-
-      if (!lastLbl.isEmpty() &&
-          lastLbl.intersects(QRectF(lx - minDX,
-                                    -SCALE_LINE_HEIGHT - 5,
-                                    br.width() + minDX, br.height())))
+      else
       {
-         delete lbl; // тесновато: подпись опускаем
-         QPen dash(Qt::blue, 1, Qt::DashLine);
-         dash.setCosmetic(true);
-         m_scaleScene->addLine(x, -SCALE_LINE_HEIGHT / 2, x, SCALE_LINE_HEIGHT, dash);
+         auto it = std::lower_bound(tl.begin(), tl.end(), cur, byTs);
+         if (it != tl.begin() && (!best || std::prev(it)->timestamp > *best))
+            best = std::prev(it)->timestamp;
       }
+   };
+   for (const auto &pin : m_signals)
+   {
+      if (pin->GetPinType() == vcd::PinType::parameter)
+         continue;
+      if (pin->GetSignalType() == vcd::SignalType::simple)
+         scan(std::static_pointer_cast<vcd::SimplePinDescription>(pin)->GetTimeline());
       else
-      {
-         lbl->setPos(lx, -SCALE_LINE_HEIGHT - 5);
-         lastLbl = {lx, -SCALE_LINE_HEIGHT - 5, br.width(), br.height()};
+         scan(std::static_pointer_cast<vcd::BusPinDescription>(pin)->GetTimeline());
+   }
+   return best;
+}
 
-         QPen pen(QColor(0, 0, 255, 128), 1);
-         pen.setCosmetic(true);
-         m_scaleScene->addLine(x, -SCALE_LINE_HEIGHT / 2, x, SCALE_LINE_HEIGHT, pen);
 
-         auto *l = m_scene->addLine(x, 0, x, sceneRect().height(), pen);
-         l->setZValue(Layers_ScaleLine);
-         m_lineItems.push_back(l);
-      }
+void WaveformView::setCursorPos(qint64 x)
+{
+   updateOverlayColumn(mapFromScene(QPointF(m_cursorPos, 0)).x());
+   m_cursorPos = x;
+   updateOverlayColumn(mapFromScene(QPointF(m_cursorPos, 0)).x());
+}
+
+/* последнее движение ждёт тика таймера: readout и перекрестие — раз в кадр */
+void WaveformView::scheduleHover(QPoint pos)
+{
+   m_pendingHover = pos;
+   if (m_hoverTimer->isActive())
+      return;
+   const QWindow *w = window()->windowHandle();
+   const QScreen *s = w ? w->screen() : QGuiApplication::primaryScreen();
+   const qreal hz = s && s->refreshRate() > 0 ? s->refreshRate() : 60.0;
+   m_hoverTimer->start(std::max(1, static_cast<int>(1000.0 / hz)));
+}
+
+void WaveformView::applyHover()
+{
+   if (!m_pendingHover)
+      return;
+   if (m_hoverPos)
+   {
+      updateOverlayColumn(m_hoverPos->x());
+      updateOverlayRow(m_hoverPos->y());
    }
+   m_hoverPos = m_pendingHover;
+   m_pendingHover.reset();
+   updateOverlayColumn(m_hoverPos->x());
+   updateOverlayRow(m_hoverPos->y());
+
+   const qreal x = mapToScene(*m_hoverPos).x();
+   emit PointerPositionChanged(static_cast<uint64_t>(std::max<qreal>(x, 0)));
+}
 
-   /* ---------- 7. Прерывистые промежуточные деления ------------- */
-   const double sub = stepScene / 5.0;
-   for (double x = minX; x <= maxX + 1e-6; x += sub)
+void WaveformView::updateOverlayColumn(qreal x)
+{
+   viewport()->update(QRect(static_cast<int>(std::floor(x)) - 2, 0, 5, viewport()->height()));
+}
+
+void WaveformView::updateOverlayRow(qreal y)
+{
+   viewport()->update(QRect(0, static_cast<int>(std::floor(y)) - 2, viewport()->width(), 5));
+}
+
+void WaveformView::drawForeground(QPainter *p, const QRectF &rect)
+{
+   QGraphicsView::drawForeground(p, rect);
+   if (!m_handle)
+      return;
+
+   const qreal cx = viewportTransform().map(QPointF(m_cursorPos, 0)).x();
+   const int w = viewport()->width();
+   const int h = viewport()->height();
+
+   p->save();
+   p->resetTransform(); // пиксели viewport
+   p->setPen(QPen(Qt::red, 1));
+   p->drawLine(QPointF(cx, 0), QPointF(cx, h));
+   if (m_hoverPos)
    {
-      if (std::fmod(x - minX, stepScene) < 1e-6)
-         continue; // это уже основная риска
-      QPen p(Qt::blue, 1, Qt::DashLine);
-      p.setCosmetic(true);
-      auto *l = m_scaleScene->addLine(x, -SCALE_LINE_HEIGHT / 2,
-                                      x, SCALE_LINE_HEIGHT, p);
-      l->setZValue(Layers_ScaleLine);
+      p->setPen(QPen(QColor(160, 160, 160), 1, Qt::DotLine));
+      const QPointF hp = QPointF(*m_hoverPos) + QPointF(0.5, 0.5);
+      p->drawLine(QPointF(hp.x(), 0), QPointF(hp.x(), h));
+      p->drawLine(QPointF(0, hp.y()), QPointF(w, hp.y()));
    }
+   p->restore();
+}
+
+/*
+ * Линейка (TimeRulerView) и сетка (drawBackground) рисуются по m_ticks
+ * без элементов сцены; здесь — новый #timescale и перерисовка линейки,
+ * когда масштаб сменился без её прокрутки.
+ */
+void WaveformView::DrawScaleLine(bool reset /* = false */)
+{
+   if (!m_handle)
+      return;
+   if (reset)
+      m_ticks.Reset(m_handle->GetTimeScale(), m_handle->GetMaxTs());
+   m_scaleView->viewport()->update();
 }
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <vector>
 
@@ -11,14 +12,17 @@
 #include "WaveformItem/Parameters.hpp"
 #include "WaveformItem/WaveItems.hpp"
 #include "SnapScrollBar.hpp"
+#include "TimeRuler.hpp"
 
 class QGraphicsScene;
-class QGraphicsLineItem;
+class QTimer;
 class QScrollBar;
 class QMouseEvent;
 class QWheelEvent;
 class QResizeEvent;
+class QPaintEvent;
 class DumpoffItem;
+class WaveTileCache;
 
 /**
  * @brief Вид для отображения временных диаграмм (waveforms).
@@ -37,11 +41,19 @@ public:
   uint64_t GetMaxTimestamp() const { return m_handle ? m_handle->GetMaxTs() : 0; }
   QGraphicsView *GetScaleView(); ///< вспомогательный QGraphicsView с линейкой
   QScrollBar *GetVerticalScrollBar() const { return verticalScrollBar(); }
+  std::shared_ptr<vcd::Handle> GetHandle() const { return m_handle; }
+  const std::vector<vcd::PinDescriptionPtr> &GetSignals() const { return m_signals; }
+  std::pair<uint64_t, uint64_t> GetVisibleRange() const; ///< [t0, t1] в окне просмотра
+  std::size_t GetItemsMemoryBytes() const;               ///< пути и подписи живых wave-элементов
+  std::size_t GetLiveItemCount() const { return m_liveItems.size(); }
+  WaveTileCache *GetTileCache() const { return m_tileCache; }
+  void SetTileCacheBytes(std::size_t bytes); ///< лимит памяти плиток, 0 — рисовать без кеша
 
 signals:
   void SelectedTimestampChange(uint64_t ts);
   void ScaleCoeffChanged(double coeff);
   void PointerPositionChanged(uint64_t x);
+  void FirstFramePainted(); ///< первый кадр после SetHandle() с непустым handle
 
 public slots:
   void zoomToRange(uint64_t x0, uint64_t x1);
@@ -49,11 +61,16 @@ public slots:
   bool ZoomOut();
   void SetInitialScale();
 
+  /* курсор и переход по событиям видимых сигналов */
+  void SetCursorTimestamp(uint64_t ts);
+  void GoToNextEvent();
+  void GoToPrevEvent();
+
   void SetHandle(std::shared_ptr<vcd::Handle> newHandle);
   void OnItemExpandedOrCollapsed(vcd::PinDescriptionPtr pin, bool isExpanded);
   void UpdateSignals(std::vector<vcd::PinDescriptionPtr> newSignals);
   void UpdateScaleViewWidth();
-  void DrawScaleLine(bool reset = false); // НЕ ТРОГАТЬ!!!
+  void DrawScaleLine(bool reset = false); ///< reset — новый #timescale; иначе только перерисовка линейки
 
 protected:
   /* events */
@@ -61,14 +78,29 @@ protected:
   void mouseMoveEvent(QMouseEvent *e) override;
   void wheelEvent(QWheelEvent *e) override;
   void resizeEvent(QResizeEvent *e) override;
+  void leaveEvent(QEvent *e) override;
+  void paintEvent(QPaintEvent *e) override;
+  void scrollContentsBy(int dx, int dy) override;
+  void drawBackground(QPainter *p, const QRectF &rect) override; ///< фон и сетка по m_ticks
+  void drawForeground(QPainter *p, const QRectF &rect) override; ///< курсор и перекрестие наведения
 
 private: /* helpers – исключительно для внутреннего порядка */
   void createScenes();
   void configureScaleView();
-  void setupCursor();
+  void setupOverlay();
   void initScrollSync();
-  void updateCursorGeometry();
-  void clearScaleLines();
+  void setCursorPos(qint64 x);
+  void scheduleHover(QPoint pos);
+  void applyHover();
+  void updateOverlayColumn(qreal x); ///< x, y — в пикселях viewport
+  void updateOverlayRow(qreal y);
+  void rebuildRowLayout();
+  void updateSceneRect();
+  void updateVisibleRows();
+  QGraphicsItem *acquireItem(const vcd::PinDescriptionPtr &pin);
+  void releaseItem(QGraphicsItem *item);
+  qreal rowsHeight() const { return m_rowTop.empty() ? 0 : m_rowTop.back(); }
+  std::optional<uint64_t> findEvent(bool forward) const;
 
   void ZoomX(int level);
   double CalcScaleCoeff() const;
@@ -77,21 +109,31 @@ private: /* helpers – исключительно для внутреннего
 private:                                     /* data */
   QGraphicsScene *m_scene = nullptr;         ///< основная сцена
   QGraphicsScene *m_scaleScene = nullptr;    ///< сцена шкалы времени
-  QGraphicsView *m_scaleView = nullptr;      ///< отдельный view для шкалы
-  QGraphicsLineItem *m_cursorLine = nullptr; ///< вертикальный курсор
+  QGraphicsView *m_scaleView = nullptr;      ///< отдельный view для шкалы (TimeRulerView)
+  QTimer *m_hoverTimer = nullptr;            ///< ховер — не чаще кадра экрана
 
   std::shared_ptr<vcd::Handle> m_handle;
   std::vector<vcd::PinDescriptionPtr> m_signals;
+  std::vector<std::uint8_t> m_eventMask; ///< по id: пины m_signals для ChangeIndex::Next/PrevEvent
   std::unordered_map<vcd::PinDescriptionPtr, bool> m_expandedMap;
-  std::unordered_map<std::string, QGraphicsItem *> m_aliasItemMap;
-  std::vector<std::string> m_aliasOrder;
-  std::vector<QGraphicsLineItem *> m_lineItems; // «фоновые» синие линии
+
+  /* виртуализация строк: элементы есть только у строк около viewport */
+  std::vector<qreal> m_rowTop; ///< y строки i; back() — высота всех строк
+  std::unordered_map<vcd::PinDescriptionPtr, QGraphicsItem *> m_liveItems;
+  std::vector<SimpleWaveItem *> m_freeSimple; ///< скрытые, ждут SetPin()
+  std::vector<MultipleWaveItem *> m_freeBus;
+  std::vector<ParamWaveItem *> m_freeParam;
+  TimeTicks m_ticks; ///< деления линейки и сетки, подписи — на текущий шаг
 
   DumpoffItem *m_dumpoffItem = nullptr;
+  WaveTileCache *m_tileCache = nullptr; ///< растровые плитки строк
 
   int m_currentZoomLevel = 0;
   int m_minZoomLevel = 0;
   qreal m_dpr = 1.0;      ///< device-pixel-ratio
   qint64 m_cursorPos = 0; ///< x-координата курсора в сцене
+  std::optional<QPoint> m_hoverPos;     ///< перекрестие, пиксели viewport
+  std::optional<QPoint> m_pendingHover; ///< последнее движение мыши до тика m_hoverTimer
   double m_currentScaleValue = 0.0;
+  bool m_firstFramePending = false; ///< ждём первый кадр нового файла
 };
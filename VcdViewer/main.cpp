@@ -1,6 +1,7 @@
 #include <QApplication>
 #include <QDebug>
 
+#include "Include/VcdTrace.hpp"
 #include "MainWindow.hpp"
 
 int
@@ -8,6 +9,7 @@ main(int argc, char* argv[])
 {
    QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
    QApplication app(argc, argv);
+   VCD_TRACE_THREAD("gui");
 
    MainWindow w;
    qDebug() << "This is a debug message";